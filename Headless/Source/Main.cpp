@@ -0,0 +1,28 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/EngineBenchmarks.h"
+#include "../../Source/EngineTests.h"
+#include "../../Source/OfflineRenderer.h"
+
+/*
+OtoDecks' audio engine and library code, without the GUI (builds on Linux with no sound card or display).
+    OtoDecksHeadless --bench [--json <file>] [--dir <folder>] [--seconds <n>] [--files <n>] [extra audio files...]
+    OtoDecksHeadless --render <script> <output.wav>
+    OtoDecksHeadless --test [test name...]
+*/
+int main(int argc, char* argv[])
+{
+  // Message thread for LibraryImporter's and PeakFileStore's callbacks (nothing is ever shown)
+  juce::ScopedJuceInitialiser_GUI juceInitialiser;
+  juce::StringArray arguments(argv + 1, argc - 1);
+
+  if (arguments.contains("--bench")) return EngineBenchmarks::runFromCommandLine(arguments);
+  if (arguments.contains("--render")) return OfflineRenderer::runFromCommandLine(arguments);
+  if (arguments.contains("--test")) return EngineTests::runFromCommandLine(arguments);
+
+  std::cerr << "Usage:" << std::endl
+            << "  OtoDecksHeadless --bench [--json <file>] [--dir <folder>] [--seconds <n>] [--files <n>] [extra audio files...]" << std::endl
+            << "  OtoDecksHeadless --render <script> <output.wav>" << std::endl
+            << "  OtoDecksHeadless --test [test name...]" << std::endl;
+  return 1;
+}
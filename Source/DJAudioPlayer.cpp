@@ -1,75 +1,404 @@
 #include "DJAudioPlayer.h"
 
-DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager)
+DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager,
+                             juce::TimeSliceThread& _readAheadThread,
+                             DecodedTrackCache& _decodedTrackCache,
+                             PeakFileStore& _peakFileStore)
   : formatManager(_formatManager),
-    lastSampleRate(0.0)
+    readAheadThread(_readAheadThread),
+    decodedTrackCache(_decodedTrackCache),
+    peakFileStore(_peakFileStore)
 {
+  equaliserSource.setCutoff(EqualiserAudioSource::Band::low, 20'000);
+  equaliserSource.setCutoff(EqualiserAudioSource::Band::mid, 1'000);
+  equaliserSource.setCutoff(EqualiserAudioSource::Band::high, 20);
 }
 
 DJAudioPlayer::~DJAudioPlayer()
 {
+  // Stop any load in progress, then detach the source before it is deleted
+  ++latestLoadNumber;
+  loadingPool.removeAllJobs(true, 5'000);
+  transportSource.setSource(nullptr);
 }
 
 void DJAudioPlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
   transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+  tempoSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
 
   lastSampleRate = sampleRate;
-  lowFilterSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  midFilterSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  highFilterSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+  equaliserSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+  gain.reset(sampleRate, gainRampSeconds);
+  playGain.reset(sampleRate, playRampSeconds);
+
+  const juce::ScopedLock sl(preparedLock);
+  isPrepared = true;
 }
 
 void DJAudioPlayer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-  highFilterSource.getNextAudioBlock(bufferToFill);
+  juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+
+  // Apply every change made since the last block, before any audio is processed
+  commandQueue.drain([this](const DeckCommand& command) { applyCommand(command); });
+
+  // Stopped (and faded out), so the track is not read and its position does not move
+  if (playGain.getTargetValue() == 0.0f && !playGain.isSmoothing())
+  {
+    bufferToFill.clearActiveBufferRegion();
+  }
+  else
+  {
+    equaliserSource.getNextAudioBlock(bufferToFill);
+    applyGain(bufferToFill);
+
+    // Reached the end of the track (juce::AudioTransportSource stops itself there)
+    if (!transportSource.isPlaying())
+    {
+      playing = false;
+      playGain.setCurrentAndTargetValue(0.0f);
+    }
+  }
+
+  // A seek made while stopping waits for the fade out, so it does not click
+  if (pendingPosition >= 0 && !playGain.isSmoothing())
+  {
+    seek(pendingPosition);
+    pendingPosition = -1.0;
+  }
+
+  publishedPositionInSeconds = transportSource.getCurrentPosition();
+
+  // Time taken, as a share of how long the block lasts when played
+  if (lastSampleRate > 0 && bufferToFill.numSamples > 0)
+  {
+    double secondsTaken = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    float load = static_cast<float>(secondsTaken / (bufferToFill.numSamples / lastSampleRate));
+    std::atomic<float>& smoothedLoad = processingLoads[static_cast<int>(tempoSource.getMode())];
+    smoothedLoad = (smoothedLoad.load() == 0.0f) ? load : (smoothedLoad.load() * 0.9f) + (load * 0.1f);
+  }
 }
 
 void DJAudioPlayer::releaseResources()
 {
-  resampleSource.releaseResources();
-  lowFilterSource.releaseResources();
-  midFilterSource.releaseResources();
-  highFilterSource.releaseResources();
+  // From now on the message thread applies commands, so apply what is still queued first
+  {
+    const juce::ScopedLock sl(preparedLock);
+    isPrepared = false;
+    commandQueue.drain([this](const DeckCommand& command) { applyCommand(command); });
+  }
+
+  tempoSource.releaseResources();
+  equaliserSource.releaseResources();
 }
 
 void DJAudioPlayer::loadURL(juce::URL audioURL)
 {
-  auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
+  // Also cancels any load still running in the background
+  int loadNumber = ++latestLoadNumber;
+  loadInProgress = false;
+  currentURL = audioURL;
+
+  LoadedSource newSource = createSource(audioURL, loadIntoRam, loadNumber);
+  if (newSource.source != nullptr) setSource(std::move(newSource), false);
+
+  // Peak file (and RAM copy) of a streamed track, built in the background
+  if (!loadIntoRam && audioURL.isLocalFile() && peakFileStore.beginBuild(audioURL.getLocalFile()))
+  {
+    loadingPool.addJob([this, audioURL, loadNumber]() { analyseStreamedTrack(audioURL, loadNumber); });
+  }
+}
+
+void DJAudioPlayer::loadURLAsync(juce::URL audioURL, std::function<void(bool loaded)> onLoaded)
+{
+  startLoad(audioURL, false, onLoaded);
+}
+
+void DJAudioPlayer::setReadAheadSeconds(double seconds)
+{
+  readAheadSeconds = juce::jmax(0.1, seconds);
+}
+
+int DJAudioPlayer::getNumUnderruns() const
+{
+  return readAheadSource != nullptr ? readAheadSource->getNumUnderruns() : 0;
+}
+
+void DJAudioPlayer::setLoadIntoRam(bool shouldLoadIntoRam)
+{
+  if (shouldLoadIntoRam == loadIntoRam) return;
+  loadIntoRam = shouldLoadIntoRam;
+
+  // Swap the loaded track over (a load that is already in progress keeps the setting it started with)
+  if (currentSource != nullptr && !loadInProgress && !currentURL.isEmpty()) startLoad(currentURL, true, nullptr);
+}
+
+bool DJAudioPlayer::isLoadIntoRamEnabled() const
+{
+  return loadIntoRam;
+}
+
+bool DJAudioPlayer::isLoadedIntoRam() const
+{
+  return currentSource != nullptr && readAheadSource == nullptr;
+}
+
+void DJAudioPlayer::startLoad(juce::URL audioURL, bool keepPlaybackState, std::function<void(bool loaded)> onLoaded)
+{
+  int loadNumber = ++latestLoadNumber;
+  bool intoRam = loadIntoRam;
+  loadInProgress = true;
+  currentURL = audioURL;
+
+  // Streaming starts straight away, then (if the track has no peak file yet) the same job reads it once for its peak file and RAM copy
+  bool analyse = !intoRam && audioURL.isLocalFile() && peakFileStore.beginBuild(audioURL.getLocalFile());
+
+  // Filled in on 'loadingPool', then handed to the message thread (shared so the lambdas stay copyable)
+  auto loadedSource = std::make_shared<LoadedSource>();
+  juce::WeakReference<DJAudioPlayer> weakThis(this);
+
+  loadingPool.addJob([this, audioURL, intoRam, analyse, loadNumber, loadedSource, weakThis, keepPlaybackState, onLoaded]()
+    {
+      *loadedSource = createSource(audioURL, intoRam, loadNumber);
+
+      juce::MessageManager::callAsync([loadedSource, loadNumber, weakThis, keepPlaybackState, onLoaded]()
+        {
+          // Ignore if this player is gone, or a newer load has been requested since
+          DJAudioPlayer* player = weakThis.get();
+          if (player == nullptr || loadNumber != player->latestLoadNumber.load()) return;
+
+          player->loadInProgress = false;
+          bool loaded = loadedSource->source != nullptr;
+          if (loaded) player->setSource(std::move(*loadedSource), keepPlaybackState);
+          if (onLoaded) onLoaded(loaded);
+        });
+
+      if (analyse) analyseStreamedTrack(audioURL, loadNumber);
+    });
+}
+
+DJAudioPlayer::LoadedSource DJAudioPlayer::createSource(juce::URL audioURL, bool intoRam, int loadNumber)
+{
+  LoadedSource loadedSource;
+
+  if (intoRam)
+  {
+    // Reuse a recently decoded copy if there is one
+    juce::String cacheKey = audioURL.toString(false);
+    std::shared_ptr<const DecodedTrack> track = decodedTrackCache.find(cacheKey);
+
+    if (track == nullptr)
+    {
+      if (!audioURL.isLocalFile()) return loadedSource;
+
+      juce::File audioFile = audioURL.getLocalFile();
+      TrackAnalyser::Stats stats;
+      std::unique_ptr<juce::AudioFormatReader> reader = TrackAnalyser::createReader(formatManager, audioFile, stats);
+      if (reader == nullptr) return loadedSource;
+
+      // Decode once, building the peak file from the same pass if it is missing
+      DecodedTrackBuilder trackBuilder(decodedTrackCache.getSampleFormat());
+      PeakFileBuilder peakFileBuilder(peakFileStore.getPeakFileFor(audioFile));
+      std::vector<TrackAnalyser::Consumer*> consumers{ &trackBuilder };
+      if (!peakFileStore.getPeakFileFor(audioFile).existsAsFile()) consumers.push_back(&peakFileBuilder);
+
+      // Stop decoding as soon as a newer load is requested
+      TrackAnalyser::run(*reader, consumers, [this, loadNumber]() { return loadNumber != latestLoadNumber.load(); }, stats);
+      track = trackBuilder.getTrack();
+      if (track == nullptr) return loadedSource;
+
+      decodedTrackCache.insert(cacheKey, track);
+    }
+
+    loadedSource.sampleRate = track->getSampleRate();
+    loadedSource.source = std::make_unique<DecodedTrackAudioSource>(track);
+    return loadedSource;
+  }
+
+  juce::AudioFormatReader* reader = audioURL.isLocalFile() ? TrackAnalyser::createReader(formatManager, audioURL.getLocalFile()).release()
+                                                          : formatManager.createReaderFor(audioURL.createInputStream(false));
+  if (reader == nullptr) return loadedSource;
+
+  loadedSource.sampleRate = reader->sampleRate;
+  int samplesToBuffer = static_cast<int>(readAheadSeconds * reader->sampleRate);
+
+  std::unique_ptr<juce::PositionableAudioSource> readerSource(new juce::AudioFormatReaderSource(reader, true));
+  auto newReadAheadSource = std::make_unique<ReadAheadAudioSource>(std::move(readerSource), readAheadThread, samplesToBuffer);
+  loadedSource.readAheadSource = newReadAheadSource.get();
+  loadedSource.source = std::move(newReadAheadSource);
+  return loadedSource;
+}
+
+void DJAudioPlayer::analyseStreamedTrack(juce::URL audioURL, int loadNumber)
+{
+  juce::File audioFile = audioURL.getLocalFile();
+  juce::File peakFile = peakFileStore.getPeakFileFor(audioFile);
+  std::shared_ptr<const DecodedTrack> track;
+
+  TrackAnalyser::Stats stats;
+  std::unique_ptr<juce::AudioFormatReader> reader = TrackAnalyser::createReader(formatManager, audioFile, stats);
   if (reader != nullptr)
   {
-    std::unique_ptr<juce::AudioFormatReaderSource> newSource(new juce::AudioFormatReaderSource(reader, true));
-    transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-    readerSource.reset(newSource.release());
+    // Stop reading as soon as a newer load is requested
+    DecodedTrackBuilder trackBuilder(decodedTrackCache.getSampleFormat());
+    PeakFileBuilder peakFileBuilder(peakFile);
+    if (TrackAnalyser::run(*reader, { &trackBuilder, &peakFileBuilder }, [this, loadNumber]() { return loadNumber != latestLoadNumber.load(); }, stats))
+    {
+      track = trackBuilder.getTrack();
+    }
   }
+
+  if (track != nullptr) decodedTrackCache.insert(audioURL.toString(false), track);
+  bool built = peakFile.existsAsFile();
+
+  juce::WeakReference<DJAudioPlayer> weakThis(this);
+  juce::WeakReference<PeakFileStore> weakStore(&peakFileStore);
+  juce::MessageManager::callAsync([weakThis, weakStore, audioFile, built, track, loadNumber]()
+    {
+      // The waveform views waiting on this pass get its peak file (or the store builds it for them, if it failed)
+      if (PeakFileStore* store = weakStore.get()) store->endBuild(audioFile, built);
+
+      // Switch the deck from streaming to the RAM copy, unless another track (or setting) has been loaded since
+      DJAudioPlayer* player = weakThis.get();
+      if (player == nullptr || track == nullptr || loadNumber != player->latestLoadNumber.load() || player->currentSource == nullptr) return;
+
+      LoadedSource ramSource;
+      ramSource.sampleRate = track->getSampleRate();
+      ramSource.source = std::make_unique<DecodedTrackAudioSource>(track);
+      player->setSource(std::move(ramSource), true);
+    });
 }
 
-void DJAudioPlayer::start()
+void DJAudioPlayer::setSource(LoadedSource newSource, bool keepPlaybackState)
 {
+  // The same track in another form (eg. switching to RAM mid-track) takes over on the audio thread, at a block boundary and from the live play position,
+  // so it carries on without a gap or a jump (transportSource, and whether the deck is playing, are left as they are)
+  if (keepPlaybackState && currentSource != nullptr && newSource.sampleRate == currentSampleRate)
+  {
+    currentSource->replaceInput(std::move(newSource.source));
+    readAheadSource = newSource.readAheadSource;
+    updateLoopStartHint();
+    return;
+  }
+
+  double position = transportSource.getCurrentPosition();
+  bool wasPlaying = isPlaying();
+
+  // The old source is only deleted after transportSource has stopped using it
+  auto loopingSource = std::make_unique<LoopingAudioSource>(std::move(newSource.source), loopSettings, newSource.sampleRate);
+  transportSource.setSource(loopingSource.get(), 0, nullptr, newSource.sampleRate);
+  currentSource = std::move(loopingSource);
+  currentSampleRate = newSource.sampleRate;
+  readAheadSource = newSource.readAheadSource;
+  updateLoopStartHint();
+
+  // Always running from here on (starting it never waits, unlike stopping it), DJAudioPlayer::start() and stop() fade the deck in and out instead
   transportSource.start();
+
+  // Carry on from about the same place (only when the new source could not simply replace the old one's input)
+  if (keepPlaybackState)
+  {
+    setPosition(position);
+    if (wasPlaying) start();
+  }
+  // Otherwise start from the top, stopped (which also drops what tempoSource read ahead from the old track)
+  else
+  {
+    stop();
+    setPosition(0.0);
+  }
+}
+
+void DJAudioPlayer::setLooping(bool shouldLoop)
+{
+  loopSettings.enabled = shouldLoop;
+  updateLoopStartHint();
+}
+
+void DJAudioPlayer::setLoopRegion(double startInSeconds, double endInSeconds)
+{
+  if (startInSeconds < 0 || endInSeconds <= startInSeconds) DBG("> DJAudioPlayer::setLoopRegion says: Loop should start at or after 0, and end after it starts!\n");
+  else
+  {
+    loopSettings.startSeconds = startInSeconds;
+    loopSettings.endSeconds = endInSeconds;
+    updateLoopStartHint();
+  }
+}
+
+void DJAudioPlayer::clearLoopRegion()
+{
+  loopSettings.startSeconds = 0.0;
+  loopSettings.endSeconds = -1.0;
+  updateLoopStartHint();
+}
+
+bool DJAudioPlayer::isLooping() const
+{
+  return loopSettings.enabled.load();
+}
+
+void DJAudioPlayer::updateLoopStartHint()
+{
+  if (readAheadSource == nullptr) return;
+
+  juce::int64 loopStart = 0;
+  juce::int64 loopEnd = 0;
+  readAheadSource->setLoopStartHint(currentSource->getLoopRange(loopStart, loopEnd) ? loopStart : -1);
+}
+
+void DJAudioPlayer::start()
+{
+  // Only stops by itself at the end of the track (starting it again is safe from this thread)
+  if (!transportSource.isPlaying()) transportSource.start();
+
+  playing = true;
+  pushCommand({ DeckCommand::Type::start });
 }
 
 void DJAudioPlayer::stop()
 {
-  transportSource.stop();
+  playing = false;
+  pushCommand({ DeckCommand::Type::stop });
+}
+
+bool DJAudioPlayer::isPlaying() const
+{
+  return playing.load();
 }
 
 void DJAudioPlayer::setGain(double gain)
 {
   if (gain < 0 || gain > 1.0) DBG("> DJAudioPlayer::setGain says: Gain should be between 0 and 1!\n");
-  else transportSource.setGain(gain);
+  else pushCommand({ DeckCommand::Type::setGain, gain });
 }
 
 void DJAudioPlayer::setSpeed(double ratio)
 {
   if (ratio < 0 || ratio > 100.0) DBG("> DJAudioPlayer::setSpeed says: Ratio should be between 0 and 100!\n");
-  else resampleSource.setResamplingRatio(ratio);
+  else pushCommand({ DeckCommand::Type::setSpeed, ratio });
+}
+
+void DJAudioPlayer::setTempoMode(TempoAudioSource::Mode mode)
+{
+  tempoMode = mode;
+  pushCommand({ DeckCommand::Type::setTempoMode, static_cast<double>(mode) });
+}
+
+TempoAudioSource::Mode DJAudioPlayer::getTempoMode() const
+{
+  return tempoMode;
+}
+
+double DJAudioPlayer::getProcessingLoad(TempoAudioSource::Mode mode) const
+{
+  return processingLoads[static_cast<int>(mode)];
 }
 
 void DJAudioPlayer::setPosition(double posInSeconds)
 {
-  transportSource.setPosition(posInSeconds);
+  pushCommand({ DeckCommand::Type::setPosition, posInSeconds });
 }
 
 void DJAudioPlayer::setPositionRelative(double pos)
@@ -80,12 +409,14 @@ void DJAudioPlayer::setPositionRelative(double pos)
 
 double DJAudioPlayer::getPositionRelative()
 {
-  return transportSource.getCurrentPosition() / transportSource.getLengthInSeconds();
+  return getCurrentLengthInSeconds() / transportSource.getLengthInSeconds();
 }
 
 double DJAudioPlayer::getCurrentLengthInSeconds()
 {
-  return transportSource.getCurrentPosition();
+  // Nothing is published while audio is not running
+  if (!isPrepared) return transportSource.getCurrentPosition();
+  return publishedPositionInSeconds.load();
 }
 
 double DJAudioPlayer::getTotalLengthInSeconds()
@@ -95,15 +426,130 @@ double DJAudioPlayer::getTotalLengthInSeconds()
 
 void DJAudioPlayer::setLowFilter(double freq)
 {
-  lowFilterSource.setCoefficients(juce::IIRCoefficients::makeLowPass(lastSampleRate, freq, 1.0 / juce::MathConstants<double>::sqrt2));
+  pushCommand({ DeckCommand::Type::setLowFilter, freq });
 }
 
 void DJAudioPlayer::setMidFilter(double freq)
 {
-  midFilterSource.setCoefficients(juce::IIRCoefficients::makeBandPass(lastSampleRate, freq, 1.0 / juce::MathConstants<double>::sqrt2));
+  pushCommand({ DeckCommand::Type::setMidFilter, freq });
 }
 
 void DJAudioPlayer::setHighFilter(double freq)
 {
-  highFilterSource.setCoefficients(juce::IIRCoefficients::makeHighPass(lastSampleRate, freq, 1.0 / juce::MathConstants<double>::sqrt2));
+  pushCommand({ DeckCommand::Type::setHighFilter, freq });
+}
+
+void DJAudioPlayer::pushCommand(const DeckCommand& command)
+{
+  // Always queued (behind any that did not fit earlier), so commands are applied in the order they were made whichever thread applies them
+  overflowCommands.push_back(command);
+  flushCommands();
+}
+
+void DJAudioPlayer::flushCommands()
+{
+  for (;;)
+  {
+    size_t numPushed = 0;
+    while (numPushed < overflowCommands.size() && commandQueue.push(overflowCommands[numPushed])) ++numPushed;
+    overflowCommands.erase(overflowCommands.begin(), overflowCommands.begin() + static_cast<std::ptrdiff_t>(numPushed));
+
+    // Nothing drains the queue while audio is not running, so it is applied here
+    const juce::ScopedLock sl(preparedLock);
+    if (isPrepared) break;
+    commandQueue.drain([this](const DeckCommand& command) { applyCommand(command); });
+    if (overflowCommands.empty()) return;
+  }
+
+  // The queue is full, so the rest are pushed once the audio thread has made room (never dropped)
+  if (overflowCommands.empty() || isFlushScheduled) return;
+  isFlushScheduled = true;
+
+  juce::WeakReference<DJAudioPlayer> weakThis(this);
+  juce::Timer::callAfterDelay(5, [weakThis]()
+    {
+      if (DJAudioPlayer* player = weakThis.get())
+      {
+        player->isFlushScheduled = false;
+        player->flushCommands();
+      }
+    });
+}
+
+void DJAudioPlayer::applyCommand(const DeckCommand& command)
+{
+  switch (command.type)
+  {
+    case DeckCommand::Type::start:
+      // A seek still waiting for the fade out happens now, as there is nothing left to fade
+      if (pendingPosition >= 0)
+      {
+        seek(pendingPosition);
+        pendingPosition = -1.0;
+      }
+      playing = true;
+      playGain.setTargetValue(1.0f);
+      break;
+
+    case DeckCommand::Type::stop:
+      playing = false;
+      playGain.setTargetValue(0.0f);
+      break;
+
+    case DeckCommand::Type::setGain:
+      gain.setTargetValue(static_cast<float>(command.value));
+      break;
+
+    case DeckCommand::Type::setSpeed:
+      tempoSource.setSpeed(command.value);
+      break;
+
+    case DeckCommand::Type::setPosition:
+      if (playGain.getTargetValue() == 0.0f && playGain.isSmoothing()) pendingPosition = command.value;
+      else seek(command.value);
+      break;
+
+    case DeckCommand::Type::setLowFilter:
+      equaliserSource.setCutoff(EqualiserAudioSource::Band::low, static_cast<float>(command.value));
+      break;
+
+    case DeckCommand::Type::setMidFilter:
+      equaliserSource.setCutoff(EqualiserAudioSource::Band::mid, static_cast<float>(command.value));
+      break;
+
+    case DeckCommand::Type::setHighFilter:
+      equaliserSource.setCutoff(EqualiserAudioSource::Band::high, static_cast<float>(command.value));
+      break;
+
+    case DeckCommand::Type::setTempoMode:
+      tempoSource.setMode(static_cast<TempoAudioSource::Mode>(static_cast<int>(command.value)));
+      break;
+  }
+}
+
+void DJAudioPlayer::applyGain(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  juce::AudioBuffer<float>& buffer = *bufferToFill.buffer;
+
+  if (!gain.isSmoothing() && !playGain.isSmoothing())
+  {
+    buffer.applyGain(bufferToFill.startSample, bufferToFill.numSamples, gain.getTargetValue() * playGain.getTargetValue());
+    return;
+  }
+
+  // Ramp sample by sample while a change (or starting or stopping) is still gliding in
+  for (int i = 0; i < bufferToFill.numSamples; ++i)
+  {
+    float sampleGain = gain.getNextValue() * playGain.getNextValue();
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+      buffer.getWritePointer(channel, bufferToFill.startSample)[i] *= sampleGain;
+    }
+  }
+}
+
+void DJAudioPlayer::seek(double posInSeconds)
+{
+  transportSource.setPosition(posInSeconds);
+  tempoSource.flush();
 }
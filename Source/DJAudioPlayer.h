@@ -1,25 +1,77 @@
 #pragma once
 #include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "ReadAheadAudioSource.h"
+#include "DecodedTrackCache.h"
+#include "DecodedTrackAudioSource.h"
+#include "LoopingAudioSource.h"
+#include "DeckCommandQueue.h"
+#include "EqualiserAudioSource.h"
+#include "TempoAudioSource.h"
+#include "PeakFileStore.h"
 
 class DJAudioPlayer : public juce::AudioSource
 {
 public:
-  DJAudioPlayer(juce::AudioFormatManager& _formatManager);
+  DJAudioPlayer(juce::AudioFormatManager& _formatManager,
+                juce::TimeSliceThread& _readAheadThread,
+                DecodedTrackCache& _decodedTrackCache,
+                PeakFileStore& _peakFileStore);
   ~DJAudioPlayer();
 
   void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
   void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
   void releaseResources() override;
 
+  // Blocks until the file is opened (or fully decoded, when loading into RAM)
   void loadURL(juce::URL audioURL);
-  
+
+  // Opens the file on a background thread, then calls 'onLoaded' on the message thread (only the most recent load is kept)
+  void loadURLAsync(juce::URL audioURL, std::function<void(bool loaded)> onLoaded);
+
+  // How much audio is decoded ahead of the play position (applies to the next load)
+  void setReadAheadSeconds(double seconds);
+
+  // Number of audio blocks that had to play silence because decoding fell behind (since the current track was loaded, always 0 in RAM)
+  int getNumUnderruns() const;
+
+  // When on, the whole track is decoded into RAM (via 'decodedTrackCache') before it plays, so playing, seeking and looping never touch the disk
+  // The same pass also writes the track's peak file if it does not have one yet (so the waveforms do not decode it again)
+  // When off, the track streams from disk straight away, and if it has no peak file yet, the one pass that builds it also decodes the track into RAM,
+  // which the deck then switches to (so the file is not decoded once for playing and again for the waveforms)
+  // Switching this while a track is loaded swaps it over in the background without stopping it
+  void setLoadIntoRam(bool shouldLoadIntoRam);
+  bool isLoadIntoRamEnabled() const;
+  bool isLoadedIntoRam() const;
+
+  // These are queued and applied at the start of the next audio block (or straight away if audio is not running)
+  // Gain and filter changes glide to their new value rather than jumping, so moving a knob (or the crossfader) does not click
+  // Starting and stopping fade in and out the same way (and never wait on the audio thread)
   void start();
   void stop();
+  bool isPlaying() const;
   void setGain(double gain);
   void setSpeed(double ratio);
 
+  // How speed is changed (see TempoAudioSource), key lock keeps the pitch the same at any speed
+  void setTempoMode(TempoAudioSource::Mode mode);
+  TempoAudioSource::Mode getTempoMode() const;
+
+  // Share of each audio block's time this deck took, the last time it ran in 'mode' (0 if it has not yet)
+  double getProcessingLoad(TempoAudioSource::Mode mode) const;
+
+  // Looping happens on the audio thread, so the jump back is sample-accurate (the whole track is looped unless a region is set)
+  void setLooping(bool shouldLoop);
+  void setLoopRegion(double startInSeconds, double endInSeconds);
+  void clearLoopRegion();
+  bool isLooping() const;
+
   void setPosition(double posInSeconds);
   void setPositionRelative(double pos);
+
+  // Position is read from what the audio thread last published (cheap enough to call every frame)
   double getPositionRelative();
   double getCurrentLengthInSeconds();
   double getTotalLengthInSeconds();
@@ -29,13 +81,84 @@ public:
   void setHighFilter(double freq);
 
 private:
+  struct LoadedSource
+  {
+    std::unique_ptr<juce::PositionableAudioSource> source; // Wrapped in a LoopingAudioSource by setSource()
+    ReadAheadAudioSource* readAheadSource = nullptr; // Only set when streaming from disk
+    double sampleRate = 0.0;
+  };
+
+  void startLoad(juce::URL audioURL, bool keepPlaybackState, std::function<void(bool loaded)> onLoaded);
+
+  // Called on 'loadingPool' or the message thread
+  LoadedSource createSource(juce::URL audioURL, bool intoRam, int loadNumber);
+  void setSource(LoadedSource newSource, bool keepPlaybackState);
+
+  // Called on 'loadingPool' after a streamed track was loaded, if 'peakFileStore' left building its peak file to this player
+  void analyseStreamedTrack(juce::URL audioURL, int loadNumber);
+
+  // Tells 'readAheadSource' where the loop starts, so it keeps that part buffered
+  void updateLoopStartHint();
+
+  // Called on the message thread
+  void pushCommand(const DeckCommand& command);
+  void flushCommands();
+
+  // Called on the audio thread (or the message thread while audio is not running)
+  void applyCommand(const DeckCommand& command);
+
+  // Called on the audio thread
+  void applyGain(const juce::AudioSourceChannelInfo& bufferToFill);
+  void seek(double posInSeconds);
+
   juce::AudioFormatManager& formatManager;
+  juce::TimeSliceThread& readAheadThread;
+  DecodedTrackCache& decodedTrackCache;
+  PeakFileStore& peakFileStore;
+  double readAheadSeconds = 2.0;
+  bool loadIntoRam = false;
+
+  // Opening (and reading the header of, or decoding) a file happens here instead of on the message thread
+  juce::ThreadPool loadingPool{ 1 };
+  std::atomic<int> latestLoadNumber{ 0 };
+  bool loadInProgress = false;
+  juce::URL currentURL;
+  LoopingAudioSource::LoopSettings loopSettings;
+
   juce::AudioTransportSource transportSource;
-  juce::ResamplingAudioSource resampleSource{ &transportSource, false, 2 };
-  std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+  TempoAudioSource tempoSource{ &transportSource };
+  TempoAudioSource::Mode tempoMode = TempoAudioSource::Mode::standard; // Last mode set on the message thread
+  std::unique_ptr<LoopingAudioSource> currentSource;
+  double currentSampleRate = 0.0;
+  ReadAheadAudioSource* readAheadSource = nullptr;
   
-  double lastSampleRate;
-  juce::IIRFilterAudioSource lowFilterSource{ &resampleSource, false };
-  juce::IIRFilterAudioSource midFilterSource{ &lowFilterSource, false };
-  juce::IIRFilterAudioSource highFilterSource{ &midFilterSource, false };
+  // Changes from the message thread, drained at the start of getNextAudioBlock() (or by the message thread while audio is not running)
+  // 'preparedLock' stops audio starting or stopping while the message thread checks 'isPrepared' and drains, so only one thread ever drains at a time
+  DeckCommandQueue commandQueue;
+  juce::CriticalSection preparedLock;
+  std::atomic<bool> isPrepared{ false };
+
+  // Commands that did not fit in 'commandQueue' (the audio thread is behind), pushed in order before any newer ones
+  std::vector<DeckCommand> overflowCommands;
+  bool isFlushScheduled = false;
+
+  // Play position at the end of the last audio block
+  std::atomic<double> publishedPositionInSeconds{ 0.0 };
+
+  // Written on the audio thread, smoothed over several blocks
+  double lastSampleRate = 0.0;
+  std::atomic<float> processingLoads[TempoAudioSource::numModes]{};
+
+  EqualiserAudioSource equaliserSource{ &tempoSource }; // Low, mid and high filters in one pass
+  juce::SmoothedValue<float> gain{ 1.0f };
+  double gainRampSeconds = 0.02;
+
+  // Playing and stopping only fade this in and out ('transportSource' itself is always running once a track is loaded, as stopping it waits on the audio thread)
+  // Once it has faded out, nothing is read from the track, so the play position stays where it stopped
+  std::atomic<bool> playing{ false };
+  juce::SmoothedValue<float> playGain{ 0.0f };
+  double playRampSeconds = 0.005;
+  double pendingPosition = -1.0; // A seek made while fading out, applied once the fade has finished
+
+  JUCE_DECLARE_WEAK_REFERENCEABLE(DJAudioPlayer)
 };
@@ -0,0 +1,23 @@
+#include <JuceHeader.h>
+#include "DeckCommandQueue.h"
+
+DeckCommandQueue::DeckCommandQueue(int _capacity)
+  : fifo(_capacity),
+    commands(static_cast<size_t>(_capacity))
+{
+}
+
+DeckCommandQueue::~DeckCommandQueue()
+{
+}
+
+bool DeckCommandQueue::push(const DeckCommand& command)
+{
+  int start1, size1, start2, size2;
+  fifo.prepareToWrite(1, start1, size1, start2, size2);
+  if (size1 + size2 < 1) return false;
+
+  commands[static_cast<size_t>(size1 > 0 ? start1 : start2)] = command;
+  fifo.finishedWrite(1);
+  return true;
+}
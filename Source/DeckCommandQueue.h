@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// A change to one deck, made on the message thread and applied on the audio thread
+struct DeckCommand
+{
+  enum class Type
+  {
+    start,
+    stop,
+    setGain,
+    setSpeed,
+    setPosition,
+    setLowFilter,
+    setMidFilter,
+    setHighFilter,
+    setTempoMode
+  };
+
+  Type type;
+  double value = 0.0;
+};
+
+/*
+Lock-free queue of DeckCommands (one writer, one reader).
+1. the message thread pushes commands in the order they are made
+2. the audio thread drains them all at the start of each block, so every change lands on a block boundary
+*/
+class DeckCommandQueue
+{
+public:
+  DeckCommandQueue(int _capacity = 256);
+  ~DeckCommandQueue();
+
+  // Writer only (returns false if the queue is full)
+  bool push(const DeckCommand& command);
+
+  // Reader only, calls 'apply' for every queued command (oldest first)
+  template <typename ApplyFunction>
+  void drain(ApplyFunction&& apply)
+  {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i) apply(commands[static_cast<size_t>(start1 + i)]);
+    for (int i = 0; i < size2; ++i) apply(commands[static_cast<size_t>(start2 + i)]);
+
+    fifo.finishedRead(size1 + size2);
+  }
+
+private:
+  juce::AbstractFifo fifo;
+  std::vector<DeckCommand> commands;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckCommandQueue)
+};
@@ -2,12 +2,11 @@
 #include "DeckGUI.h"
 
 DeckGUI::DeckGUI(DJAudioPlayer* _player,
-                 juce::AudioFormatManager& formatManagerToUse,
-                 juce::AudioThumbnailCache& cacheToUse,
+                 PeakFileStore& peakFileStoreToUse,
                  juce::Colour _incomingColour)
   : player(_player),
-    waveformDisplay(formatManagerToUse, cacheToUse, _incomingColour),
-    waveformDisplayZoomedIn(formatManagerToUse, cacheToUse, _incomingColour),
+    waveformDisplay(peakFileStoreToUse, _incomingColour),
+    waveformDisplayZoomedIn(peakFileStoreToUse, _incomingColour),
     incomingColour(_incomingColour)
 {
   // Add variables to array
@@ -65,6 +64,16 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player,
   timestampLabel.setJustificationType(juce::Justification::right);
   
   loopButton.setClickingTogglesState(true);
+
+  // Not part of 'buttons' array, as the array's indexes are used in DeckGUI::paint()
+  addAndMakeVisible(ramButton);
+  ramButton.addListener(this);
+  ramButton.setClickingTogglesState(true);
+  ramButton.setTooltip("Decode the whole track into RAM, so playing, seeking and looping never read from disk");
+  addAndMakeVisible(tempoModeButton);
+  tempoModeButton.addListener(this);
+  updateTempoModeButton();
+  addAndMakeVisible(levelMeter);
   
   posSlider.setRange(0, 1);
   
@@ -89,14 +98,10 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player,
   speedSlider.setDoubleClickReturnValue(true, speedSliderDefaultValue);
   volSlider.setTextValueSuffix("%");
   speedSlider.setTextValueSuffix("x");
-
-  // calls timerCallback() at the bottom of this .cpp
-  startTimer(1);
 }
 
 DeckGUI::~DeckGUI()
 {
-  stopTimer();
 }
 
 void DeckGUI::paint(juce::Graphics& g)
@@ -147,6 +152,13 @@ void DeckGUI::paint(juce::Graphics& g)
     }
   }
 
+  // RAM button (same colours as other buttons)
+  ramButton.setLookAndFeel(&customLookAndFeel);
+  ramButton.setColour(juce::TextButton::buttonColourId, ramButton.isMouseOver() ? incomingColour : incomingColour.withAlpha(0.25f));
+  ramButton.setColour(juce::TextButton::buttonOnColourId, incomingColour);
+  tempoModeButton.setLookAndFeel(&customLookAndFeel);
+  tempoModeButton.setColour(juce::TextButton::buttonColourId, tempoModeButton.isMouseOver() ? incomingColour : incomingColour.withAlpha(0.25f));
+
   // This includes posSlider that is transparent over the waveform
   for (auto slider : sliders)
   {
@@ -198,8 +210,11 @@ void DeckGUI::resized()
   // Row 1: title, timestamp
   double y1 = waveformDisplay.getY() + waveformDisplay.getHeight();
   double titleWidth = (getWidth() / static_cast<double>(5)) * 3;
-  titleLabel.setBounds(margin, y1, titleWidth - margin, cellHeight);
-  timestampLabel.setBounds(titleLabel.getX() + titleLabel.getWidth(), y1, getWidth() - titleWidth - margin, cellHeight);
+  double ramButtonWidth = cellWidth / 2;
+  titleLabel.setBounds(margin, y1, titleWidth - margin - (ramButtonWidth * 2), cellHeight);
+  ramButton.setBounds(titleLabel.getX() + titleLabel.getWidth(), y1 + (cellHeight / 4), ramButtonWidth, cellHeight / 2);
+  tempoModeButton.setBounds(ramButton.getX() + ramButton.getWidth(), y1 + (cellHeight / 4), ramButtonWidth, cellHeight / 2);
+  timestampLabel.setBounds(tempoModeButton.getX() + tempoModeButton.getWidth(), y1, getWidth() - titleWidth - margin, cellHeight);
 
   // Row 2~3: play, pause, stop
   double y2 = titleLabel.getY() + titleLabel.getHeight();
@@ -220,6 +235,7 @@ void DeckGUI::resized()
   // Side
   volSlider.setBounds(loopButton.getX() + loopButton.getWidth(), y2 + cellHeight / 2, cellWidth - (margin / 2), cellHeight * 5);
   speedSlider.setBounds(volSlider.getX() + volSlider.getWidth(), y2 + cellHeight / 2, cellWidth - (margin / 2), cellHeight * 5);
+  levelMeter.setBounds(getWidth() - (margin * 0.75), y2 + cellHeight / 2, margin / 2, cellHeight * 5);
   
   // Row 6~7: low, mid, high labels
   double y4 = backwardButton.getY() + backwardButton.getHeight();
@@ -266,14 +282,27 @@ void DeckGUI::buttonClicked(juce::Button* button)
 
   if (button == &forwardButton) player->setPositionRelative((player->getCurrentLengthInSeconds() + skipLengthInSeconds) / player->getTotalLengthInSeconds());
 
+  if (button == &ramButton) player->setLoadIntoRam(ramButton.getToggleState());
+
+  if (button == &tempoModeButton)
+  {
+    // Standard -> high quality -> key lock -> standard
+    int nextMode = (static_cast<int>(player->getTempoMode()) + 1) % TempoAudioSource::numModes;
+    player->setTempoMode(static_cast<TempoAudioSource::Mode>(nextMode));
+    updateTempoModeButton();
+  }
+
   if (button == &loopButton)
   {
-    // Update text (loop functionality found at timerCallback() below)
+    // Update text
     if (loopButton.getToggleState()) loopStatusText = "On";
     else loopStatusText = "Off";
 
     // Set updated text
     loopButton.setButtonText("Loop\n(" + loopStatusText + ")");
+
+    // Functionality (the looping itself happens in DJAudioPlayer)
+    updateLoop();
   }
 
   if (button == &unloadButton)
@@ -305,6 +334,7 @@ void DeckGUI::buttonClicked(juce::Button* button)
 
     // Functionality
     cueFromHereInSeconds1 = player->getCurrentLengthInSeconds();
+    updateLoop();
   }
 
   if (button == &cuePlayButton1)
@@ -321,6 +351,7 @@ void DeckGUI::buttonClicked(juce::Button* button)
 
     // Functionality
     cueFromHereInSeconds2 = player->getCurrentLengthInSeconds();
+    updateLoop();
   }
 
   if (button == &cuePlayButton2)
@@ -334,7 +365,7 @@ void DeckGUI::sliderValueChanged(juce::Slider* slider)
 {
   if (slider == &posSlider) player->setPositionRelative(slider->getValue());
 
-  if (slider == &volSlider) player->setGain(slider->getValue() / 100);
+  if (slider == &volSlider && onVolumeChanged) onVolumeChanged(slider->getValue() / 100);
 
   if (slider == &speedSlider) player->setSpeed(slider->getValue());
 
@@ -351,34 +382,39 @@ This updates...
 2. normal waveform's playhead (aka. the vertical line)
 3. timestamp text
 4. posSlider's value (aka. its width)
-5. loop button's functionality
+(called once per display refresh, and does nothing if the position has not changed)
 */
-void DeckGUI::timerCallback()
+void DeckGUI::vBlankCallback()
 {
+  // Before the check below, so the meter still falls back to silence while paused
+  levelMeter.update();
+
+  // Nothing to update (also skips repainting while paused)
+  double position = player->getPositionRelative();
+  if (!std::isfinite(position)) position = 0.0;
+  if (position == lastDrawnPosition) return;
+  lastDrawnPosition = position;
+
   // Update position of waveform's start and end (to create "scrolling" effect)
-  waveformDisplayZoomedIn.setPositionRelativeOfWaveform(player->getPositionRelative());
+  waveformDisplayZoomedIn.setPositionRelativeOfWaveform(position);
   
   // Update position of playhead (aka. vertical line)
-  waveformDisplay.setPositionRelative(player->getPositionRelative());
+  waveformDisplay.setPositionRelative(position);
 
-  // Update and set timestamp text, and update and set posSlider value (aka. its width)
+  // Update and set timestamp text (only when the second changes), and update and set posSlider value (aka. its width)
   if (audioLoaded)
   {
     currentTimestampInSeconds = player->getCurrentLengthInSeconds();
-    timestampLabel.setText(juce::String(formatSecondsToMMSS(currentTimestampInSeconds)) + " / " + juce::String(formatSecondsToMMSS(totalTimestampInSeconds)), juce::NotificationType::dontSendNotification);
-  
-    currentSliderPosition = player->getPositionRelative();
-    posSlider.setValue(currentSliderPosition);
-  }
-
-  // Loop button's functionality
-  if (loopButton.getToggleState())
-  {
-    if (player->getPositionRelative() >= 1)
+    if (static_cast<int>(currentTimestampInSeconds) != lastDrawnSecond)
     {
-      player->setPositionRelative(0);
-      player->start();
+      lastDrawnSecond = static_cast<int>(currentTimestampInSeconds);
+      timestampLabel.setText(juce::String(formatSecondsToMMSS(currentTimestampInSeconds)) + " / " + juce::String(formatSecondsToMMSS(totalTimestampInSeconds)), juce::NotificationType::dontSendNotification);
+      updateTempoModeButton();
     }
+  
+    // Without notification, otherwise every frame would queue a seek to where the player already is
+    currentSliderPosition = position;
+    posSlider.setValue(currentSliderPosition, juce::NotificationType::dontSendNotification);
   }
 }
 
@@ -386,33 +422,71 @@ void DeckGUI::loadFromPlaylist(std::string fileURL)
 {
   // Retrieve file from fileURL
   juce::File chosenFile = fileURL;
-  
-  // Load into DJAudioPlayer
-  player->loadURL(juce::URL{ chosenFile });
 
+  // Set title (until DJAudioPlayer has finished loading)
+  titleLabel.setText("Loading " + chosenFile.getFileNameWithoutExtension() + "...", juce::NotificationType::dontSendNotification);
+
+  // Load into DJAudioPlayer (in the background, so the message thread never waits on the disk)
+  // Waveforms are loaded afterwards, as the deck also builds the peak file they read (while decoding into RAM, or in the background once streaming)
+  juce::Component::SafePointer<DeckGUI> safeThis(this);
+  player->loadURLAsync(juce::URL{ chosenFile }, [safeThis, chosenFile](bool loaded)
+    {
+      if (safeThis != nullptr) safeThis->loadFinished(chosenFile, loaded);
+    });
+}
+
+void DeckGUI::loadFinished(juce::File chosenFile, bool loaded)
+{
   // Load waveforms
-  waveformDisplayZoomedIn.loadURL(juce::URL{ chosenFile });
-  waveformDisplay.loadURL(juce::URL{ chosenFile });
+  waveformDisplayZoomedIn.loadURL(loaded ? juce::URL{ chosenFile } : juce::URL{ "" });
+  waveformDisplay.loadURL(loaded ? juce::URL{ chosenFile } : juce::URL{ "" });
 
   // Set title
-  titleLabel.setText(chosenFile.getFileNameWithoutExtension(), juce::NotificationType::dontSendNotification);
+  if (loaded) titleLabel.setText(chosenFile.getFileNameWithoutExtension(), juce::NotificationType::dontSendNotification);
+  else titleLabel.setText("Unable to load " + chosenFile.getFileNameWithoutExtension(), juce::NotificationType::dontSendNotification);
 
   // Update and set timestamp
   totalTimestampInSeconds = player->getTotalLengthInSeconds();
   timestampLabel.setText(juce::String(formatSecondsToMMSS(currentTimestampInSeconds)) + " / " + juce::String(formatSecondsToMMSS(totalTimestampInSeconds)), juce::NotificationType::dontSendNotification);
-  audioLoaded = true;
+  audioLoaded = loaded;
 
   // Reset cue and slider
   resetValues();
 }
 
+void DeckGUI::setLevelMeter(LevelMeter* meter)
+{
+  levelMeter.setMeter(meter);
+}
+
+void DeckGUI::updateTempoModeButton()
+{
+  juce::StringArray names{ "Std", "HQ", "Key" };
+  juce::StringArray descriptions{ "Standard", "High quality", "Key lock" };
+  tempoModeButton.setButtonText(names[static_cast<int>(player->getTempoMode())]);
+
+  // Load is the share of each audio block's time this deck took (measured while playing in that mode)
+  juce::String tooltip = "Tempo mode (key lock keeps the pitch when changing speed)";
+  for (int mode = 0; mode < TempoAudioSource::numModes; ++mode)
+  {
+    double load = player->getProcessingLoad(static_cast<TempoAudioSource::Mode>(mode));
+    tooltip << "\n" << descriptions[mode] << ": " << (load > 0 ? juce::String(load * 100, 2) + "% CPU" : juce::String("not used yet"));
+  }
+  tempoModeButton.setTooltip(tooltip);
+}
+
 void DeckGUI::resetValues()
 {
+  // Redraw the playhead and timestamp on the next frame, even if the position has not changed
+  lastDrawnPosition = -1.0;
+  lastDrawnSecond = -1;
+
   // Reset cue-related items
   cueCounter1 = 0;
   cueSetButton1.setButtonText("Cue\n" + juce::String(cueCounter1));
   cueCounter2 = 0;
   cueSetButton2.setButtonText("Cue\n" + juce::String(cueCounter2));
+  updateLoop();
 
   // Reset sliders
   player->setPositionRelative(0.0);
@@ -423,3 +497,15 @@ void DeckGUI::resetValues()
   volSlider.setValue(volDefaultValue);
   speedSlider.setValue(speedSliderDefaultValue);
 }
+
+void DeckGUI::updateLoop()
+{
+  // Cue points can be set in either order
+  if (cueCounter1 > 0 && cueCounter2 > 0 && cueFromHereInSeconds1 != cueFromHereInSeconds2)
+  {
+    player->setLoopRegion(juce::jmin(cueFromHereInSeconds1, cueFromHereInSeconds2), juce::jmax(cueFromHereInSeconds1, cueFromHereInSeconds2));
+  }
+  else player->clearLoopRegion();
+
+  player->setLooping(loopButton.getToggleState());
+}
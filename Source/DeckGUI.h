@@ -1,19 +1,19 @@
 #pragma once
 #include <JuceHeader.h>
+#include <functional>
 #include "DJAudioPlayer.h"
 #include "WaveformDisplay.h"
 #include "WaveformDisplayZoomedIn.h"
+#include "LevelMeterComponent.h"
 #include "customLookAndFeel.h"
 
 class DeckGUI : public juce::Component,
                 public juce::Button::Listener,
-                public juce::Slider::Listener,
-                public juce::Timer
+                public juce::Slider::Listener
 {
 public:
   DeckGUI(DJAudioPlayer* player,
-          juce::AudioFormatManager& formatManagerToUse,
-          juce::AudioThumbnailCache& cacheToUse,
+          PeakFileStore& peakFileStoreToUse,
           juce::Colour _incomingColour);
   ~DeckGUI() override;
 
@@ -30,14 +30,20 @@ public:
   2. normal waveform's playhead (aka. the vertical line)
   3. timestamp text
   4. posSlider's value (aka. its width)
-  5. loop button's functionality
+  (called once per display refresh, and does nothing if the position has not changed)
   */
-  void timerCallback() override;
+  void vBlankCallback();
 
   // Made public to be accessed in MainComponent
   juce::Slider volSlider{ juce::Slider::SliderStyle::LinearVertical, juce::Slider::TextEntryBoxPosition::TextBoxAbove };
   void loadFromPlaylist(std::string fileURL);
 
+  // Set by MainComponent, called with 'volSlider's value (from 0 to 1) whenever it moves, to set this deck's fader in the mixer
+  std::function<void(double level)> onVolumeChanged;
+
+  // Set by MainComponent, shows this deck's level in the mixer (before its fader)
+  void setLevelMeter(LevelMeter* meter);
+
 private:
   // General variables
   juce::Colour incomingColour;
@@ -45,6 +51,15 @@ private:
   CustomLookAndFeel customLookAndFeel;
   void resetValues();
 
+  // Loops between the two cue points if both are set, otherwise the whole track
+  void updateLoop();
+
+  // Called once DJAudioPlayer has finished loading in the background
+  void loadFinished(juce::File chosenFile, bool loaded);
+
+  // Shows the current tempo mode, with what each mode has cost this deck in its tooltip
+  void updateTempoModeButton();
+
   // Arrays to easily apply whatever is needed
   juce::Array<juce::Button*> buttons;
   juce::Array<juce::Slider*> sliders;
@@ -58,6 +73,8 @@ private:
   // Position (is transparent over 'waveformDisplay')
   juce::Slider posSlider{ juce::Slider::SliderStyle::LinearBar, juce::Slider::TextEntryBoxPosition::NoTextBox };
   double currentSliderPosition = 0.0;
+  double lastDrawnPosition = -1.0;
+  int lastDrawnSecond = -1;
 
   // ----- Bottom half ----- //
   // Row 1: title, timestamp (variables are initialised and declared here due to being used in resetValues())
@@ -66,6 +83,8 @@ private:
   bool audioLoaded = false;
   juce::Label titleLabel;
   juce::Label timestampLabel;
+  juce::TextButton ramButton{ "RAM" }; // Toggles DJAudioPlayer's "load into RAM" mode
+  juce::TextButton tempoModeButton{ "Std" }; // Cycles DJAudioPlayer's tempo mode (standard, high quality, key lock)
 
   // Row 2~3: play, pause, stop
   juce::TextButton playButton{ "Play" };
@@ -118,5 +137,11 @@ private:
   int volDefaultValue = 50;
   int speedSliderDefaultValue = 1;
 
+  // Level (in the right-hand margin, beside 'speedSlider')
+  LevelMeterComponent levelMeter{ incomingColour };
+
+  // Declared last, so everything vBlankCallback() uses already exists when it is first called
+  juce::VBlankAttachment vBlankAttachment{ this, [this]() { vBlankCallback(); } };
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckGUI)
 };
@@ -0,0 +1,53 @@
+#include <JuceHeader.h>
+#include "DeckManager.h"
+
+DeckManager::DeckManager(juce::AudioFormatManager& _formatManager,
+                         juce::TimeSliceThread& _readAheadThread,
+                         DecodedTrackCache& _decodedTrackCache,
+                         PeakFileStore& _peakFileStore)
+  : formatManager(_formatManager),
+    readAheadThread(_readAheadThread),
+    decodedTrackCache(_decodedTrackCache),
+    peakFileStore(_peakFileStore)
+{
+}
+
+DeckManager::~DeckManager()
+{
+  // The mixer must let go of every deck before they are deleted
+  mixer.removeAllInputs();
+}
+
+DJAudioPlayer* DeckManager::addDeck()
+{
+  if (getNumDecks() >= maxDecks) return nullptr;
+
+  decks.push_back(std::make_unique<DJAudioPlayer>(formatManager, readAheadThread, decodedTrackCache, peakFileStore));
+  // Deck 1, 3, ... on the crossfader's left, deck 2, 4, ... on its right
+  bool isOddNumbered = decks.size() % 2 == 1;
+  mixer.addInputSource(decks.back().get(), isOddNumbered ? DeckMixerAudioSource::CrossfadeSide::left : DeckMixerAudioSource::CrossfadeSide::right);
+  return decks.back().get();
+}
+
+void DeckManager::removeLastDeck()
+{
+  if (decks.empty()) return;
+
+  mixer.removeInputSource(decks.back().get());
+  decks.pop_back();
+}
+
+int DeckManager::getNumDecks() const
+{
+  return static_cast<int>(decks.size());
+}
+
+DJAudioPlayer* DeckManager::getDeck(int index) const
+{
+  return juce::isPositiveAndBelow(index, getNumDecks()) ? decks[static_cast<size_t>(index)].get() : nullptr;
+}
+
+DeckMixerAudioSource& DeckManager::getMixer()
+{
+  return mixer;
+}
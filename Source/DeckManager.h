@@ -0,0 +1,47 @@
+#pragma once
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+#include "DJAudioPlayer.h"
+#include "DeckMixerAudioSource.h"
+
+/*
+Creates decks at runtime and mixes them.
+1. every deck is a DJAudioPlayer sharing the same format manager, read-ahead thread, RAM cache and peak file store
+2. decks are mixed by 'mixer' (see DeckMixerAudioSource), which is the only source the audio device needs, and where each deck's fader and the crossfader are set
+3. decks are numbered from 0 in the order they were added, and only the most recently added one can be removed
+4. deck 1, 3, ... are put on the crossfader's left, and deck 2, 4, ... on its right
+*/
+class DeckManager
+{
+public:
+  DeckManager(juce::AudioFormatManager& _formatManager,
+              juce::TimeSliceThread& _readAheadThread,
+              DecodedTrackCache& _decodedTrackCache,
+              PeakFileStore& _peakFileStore);
+  ~DeckManager();
+
+  // Returns the new deck (already being mixed), or nullptr once there are 'maxDecks'
+  DJAudioPlayer* addDeck();
+
+  // Anything still using the last deck (eg. its DeckGUI) must be deleted first
+  void removeLastDeck();
+
+  int getNumDecks() const;
+  DJAudioPlayer* getDeck(int index) const;
+
+  DeckMixerAudioSource& getMixer();
+
+  static constexpr int maxDecks = 8;
+
+private:
+  juce::AudioFormatManager& formatManager;
+  juce::TimeSliceThread& readAheadThread;
+  DecodedTrackCache& decodedTrackCache;
+  PeakFileStore& peakFileStore;
+
+  DeckMixerAudioSource mixer;
+  std::vector<std::unique_ptr<DJAudioPlayer>> decks;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckManager)
+};
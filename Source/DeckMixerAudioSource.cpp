@@ -0,0 +1,259 @@
+#include <JuceHeader.h>
+#include "DeckMixerAudioSource.h"
+
+DeckMixerAudioSource::DeckMixerAudioSource()
+{
+  for (int i = 0; i < maxInputs; ++i)
+  {
+    faderLevels[i].store(1.0f);
+    crossfadeSides[i].store(static_cast<int>(CrossfadeSide::thru));
+  }
+}
+
+DeckMixerAudioSource::~DeckMixerAudioSource()
+{
+  removeAllInputs();
+}
+
+bool DeckMixerAudioSource::addInputSource(juce::AudioSource* input, CrossfadeSide side)
+{
+  jassert(input != nullptr);
+
+  double sampleRate;
+  bool shouldPrepare;
+  {
+    const juce::ScopedLock sl(lock);
+    if (inputs.size() >= maxInputs || inputs.contains(input)) return false;
+    sampleRate = currentSampleRate;
+    shouldPrepare = isPrepared;
+  }
+
+  // Prepared outside the lock, so the audio thread is not held up by it
+  if (shouldPrepare) input->prepareToPlay(chunkSize, sampleRate);
+
+  // Starts at its gain, rather than gliding up from silence
+  const juce::ScopedLock sl(lock);
+  faderLevels[inputs.size()].store(1.0f);
+  crossfadeSides[inputs.size()].store(static_cast<int>(side));
+  gains[inputs.size()].setCurrentAndTargetValue(getTargetGain(inputs.size()));
+  inputs.add(input);
+  return true;
+}
+
+void DeckMixerAudioSource::removeInputSource(juce::AudioSource* input)
+{
+  bool wasPrepared;
+  {
+    const juce::ScopedLock sl(lock);
+    int inputIndex = inputs.indexOf(input);
+    if (inputIndex < 0) return;
+
+    // Later inputs move down a place, along with their settings (their meters start again)
+    for (int i = inputIndex; i < inputs.size() - 1; ++i)
+    {
+      faderLevels[i].store(faderLevels[i + 1].load());
+      crossfadeSides[i].store(crossfadeSides[i + 1].load());
+      gains[i] = gains[i + 1];
+      inputMeters[i].reset();
+    }
+    inputMeters[inputs.size() - 1].reset();
+    inputs.remove(inputIndex);
+    wasPrepared = isPrepared;
+  }
+
+  if (wasPrepared) input->releaseResources();
+}
+
+void DeckMixerAudioSource::removeAllInputs()
+{
+  juce::Array<juce::AudioSource*> removedInputs;
+  bool wasPrepared;
+  {
+    const juce::ScopedLock sl(lock);
+    removedInputs.swapWith(inputs);
+    wasPrepared = isPrepared;
+  }
+
+  if (wasPrepared)
+    for (juce::AudioSource* input : removedInputs) input->releaseResources();
+}
+
+int DeckMixerAudioSource::getNumInputs() const
+{
+  const juce::ScopedLock sl(lock);
+  return inputs.size();
+}
+
+float DeckMixerAudioSource::getCrossfadeGain(CrossfadeSide side, float position, CrossfadeCurve curve)
+{
+  if (side == CrossfadeSide::thru) return 1.0f;
+
+  // 0 at this side's end of the crossfader, 1 at the other end
+  float distance = juce::jlimit(0.0f, 1.0f, (side == CrossfadeSide::left ? position + 1.0f : 1.0f - position) / 2.0f);
+
+  switch (curve)
+  {
+    case CrossfadeCurve::linear:
+      return 1.0f - distance;
+
+    case CrossfadeCurve::constantPower:
+      return std::cos(distance * juce::MathConstants<float>::halfPi);
+
+    case CrossfadeCurve::sharpCut:
+    {
+      // Cuts over the last few percent of the crossfader's travel
+      const float cutWidth = 0.05f;
+      return juce::jmin(1.0f, (1.0f - distance) / cutWidth);
+    }
+  }
+
+  return 1.0f;
+}
+
+void DeckMixerAudioSource::setFaderLevel(int inputIndex, float level)
+{
+  if (juce::isPositiveAndBelow(inputIndex, maxInputs)) faderLevels[inputIndex].store(juce::jlimit(0.0f, 1.0f, level));
+}
+
+void DeckMixerAudioSource::setCrossfadeSide(int inputIndex, CrossfadeSide side)
+{
+  if (juce::isPositiveAndBelow(inputIndex, maxInputs)) crossfadeSides[inputIndex].store(static_cast<int>(side));
+}
+
+void DeckMixerAudioSource::setCrossfadePosition(float position)
+{
+  crossfadePosition.store(juce::jlimit(-1.0f, 1.0f, position));
+}
+
+void DeckMixerAudioSource::setCrossfadeCurve(CrossfadeCurve curve)
+{
+  crossfadeCurve.store(static_cast<int>(curve));
+}
+
+DeckMixerAudioSource::CrossfadeCurve DeckMixerAudioSource::getCrossfadeCurve() const
+{
+  return static_cast<CrossfadeCurve>(crossfadeCurve.load());
+}
+
+LevelMeter& DeckMixerAudioSource::getInputMeter(int inputIndex)
+{
+  jassert(juce::isPositiveAndBelow(inputIndex, maxInputs));
+  return inputMeters[juce::jlimit(0, maxInputs - 1, inputIndex)];
+}
+
+void DeckMixerAudioSource::setNumWorkerThreads(int numThreads)
+{
+  if (numThreads == getNumWorkerThreads()) return;
+
+  // Threads are started and stopped outside the lock, so the audio thread is not held up by it
+  std::unique_ptr<DeckRenderPool> newPool = numThreads > 0 ? std::make_unique<DeckRenderPool>(numThreads) : nullptr;
+  {
+    const juce::ScopedLock sl(lock);
+    std::swap(renderPool, newPool);
+  }
+}
+
+int DeckMixerAudioSource::getNumWorkerThreads() const
+{
+  const juce::ScopedLock sl(lock);
+  return renderPool != nullptr ? renderPool->getNumThreads() : 0;
+}
+
+void DeckMixerAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+  juce::ignoreUnused(samplesPerBlockExpected);
+
+  // Inputs are never asked for more than one chunk at a time
+  const juce::ScopedLock sl(lock);
+  inputBuffers.setSize(maxInputs * numChannels, chunkSize);
+  for (juce::AudioSource* input : inputs) input->prepareToPlay(chunkSize, sampleRate);
+
+  for (int i = 0; i < maxInputs; ++i)
+  {
+    gains[i].reset(sampleRate, gainRampSeconds);
+    gains[i].setCurrentAndTargetValue(getTargetGain(i));
+    inputMeters[i].prepare(sampleRate);
+  }
+
+  currentSampleRate = sampleRate;
+  isPrepared = true;
+}
+
+void DeckMixerAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  const juce::ScopedLock sl(lock);
+
+  int numInputs = inputs.size();
+  int numOutputChannels = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+  if (numInputs == 0 || !isPrepared)
+  {
+    bufferToFill.clearActiveBufferRegion();
+    return;
+  }
+
+  // Any channels past the first two are left silent
+  for (int channel = numOutputChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+
+  float* const* inputChannels = inputBuffers.getArrayOfWritePointers();
+  for (int chunkStart = 0; chunkStart < bufferToFill.numSamples; chunkStart += chunkSize)
+  {
+    int numSamples = juce::jmin(chunkSize, bufferToFill.numSamples - chunkStart);
+
+    // Each input renders into its own channels of 'inputBuffers', so they can be rendered on any thread in any order
+    chunkNumSamples = numSamples;
+    if (renderPool != nullptr && numInputs > 1) renderPool->run(*this, numInputs);
+    else
+      for (int inputIndex = 0; inputIndex < numInputs; ++inputIndex) runJob(inputIndex);
+
+    // Fader and crossfade gains, from the latest settings
+    float chunkGains[maxInputs];
+    for (int inputIndex = 0; inputIndex < numInputs; ++inputIndex)
+    {
+      gains[inputIndex].setTargetValue(getTargetGain(inputIndex));
+      chunkGains[inputIndex] = applyGainRamp(inputIndex);
+    }
+
+    // Then the chunk is summed into the output while it is still in cache (the output is written once, never cleared first)
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+      float* output = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + chunkStart);
+      juce::FloatVectorOperations::copyWithMultiply(output, inputChannels[channel], chunkGains[0], numSamples);
+      for (int inputIndex = 1; inputIndex < numInputs; ++inputIndex)
+        juce::FloatVectorOperations::addWithMultiply(output, inputChannels[(inputIndex * numChannels) + channel], chunkGains[inputIndex], numSamples);
+    }
+  }
+}
+
+void DeckMixerAudioSource::runJob(int inputIndex)
+{
+  // Refers to the input's channels of 'inputBuffers', so nothing is allocated
+  juce::AudioBuffer<float> inputBuffer(inputBuffers.getArrayOfWritePointers() + (inputIndex * numChannels), numChannels, chunkNumSamples);
+  inputs.getUnchecked(inputIndex)->getNextAudioBlock(juce::AudioSourceChannelInfo(&inputBuffer, 0, chunkNumSamples));
+  inputMeters[inputIndex].process(inputBuffer, 0, chunkNumSamples);
+}
+
+float DeckMixerAudioSource::getTargetGain(int inputIndex) const
+{
+  CrossfadeSide side = static_cast<CrossfadeSide>(crossfadeSides[inputIndex].load());
+  return faderLevels[inputIndex].load() * getCrossfadeGain(side, crossfadePosition.load(), getCrossfadeCurve());
+}
+
+float DeckMixerAudioSource::applyGainRamp(int inputIndex)
+{
+  // Steady gains are applied while summing instead, which saves a pass over the chunk
+  if (!gains[inputIndex].isSmoothing()) return gains[inputIndex].getTargetValue();
+
+  juce::AudioBuffer<float> inputBuffer(inputBuffers.getArrayOfWritePointers() + (inputIndex * numChannels), numChannels, chunkNumSamples);
+  gains[inputIndex].applyGain(inputBuffer, chunkNumSamples);
+  return 1.0f;
+}
+
+void DeckMixerAudioSource::releaseResources()
+{
+  const juce::ScopedLock sl(lock);
+  for (juce::AudioSource* input : inputs) input->releaseResources();
+
+  inputBuffers.setSize(0, 0);
+  isPrepared = false;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include "DeckRenderPool.h"
+#include "LevelMeter.h"
+
+/*
+Sums any number of decks (up to 'maxInputs') into one output, in place of juce::MixerAudioSource.
+1. each block is worked through in chunks of 'chunkSize' samples, so every deck's output for the chunk is still in cache when it is summed
+2. all of the scratch space is allocated in prepareToPlay(), so adding a deck never allocates on the audio thread
+3. each deck costs one render plus one add per chunk, so the audio thread's cost grows linearly with the number of decks
+4. decks can be rendered in parallel on a DeckRenderPool, but are always summed on the audio thread in the order they were added (so the result is the same either way)
+5. each input has a fader and a crossfade side, and the gains they give are worked out on the audio thread every chunk, then glided to over 'gainRampSeconds'
+6. each input is metered before its fader (like a DJ mixer's channel meters), on whichever thread rendered it
+*/
+class DeckMixerAudioSource : public juce::AudioSource,
+                             private DeckRenderPool::Task
+{
+public:
+  DeckMixerAudioSource();
+  ~DeckMixerAudioSource() override;
+
+  // Which end of the crossfader an input is on ('thru' inputs are not affected by it)
+  enum class CrossfadeSide
+  {
+    left,
+    right,
+    thru
+  };
+
+  // How an input's gain falls as the crossfader moves away from its side
+  enum class CrossfadeCurve
+  {
+    linear,        // Each side fades evenly to silence at the other end (quieter in the middle)
+    constantPower, // Each side follows a quarter of a sine, so the overall loudness stays the same across the fade
+    sharpCut       // Both sides at full gain, except right at the other end (for scratching)
+  };
+  static constexpr int numCrossfadeCurves = 3;
+
+  // Called on the message thread, 'input' is prepared before it is added if audio is already running (returns false once 'maxInputs' are mixed)
+  // Its fader starts at full level
+  bool addInputSource(juce::AudioSource* input, CrossfadeSide side = CrossfadeSide::thru);
+
+  // Called on the message thread, 'input' is released once the audio thread can no longer be using it
+  void removeInputSource(juce::AudioSource* input);
+  void removeAllInputs();
+
+  int getNumInputs() const;
+
+  // Gain of an input on 'side' with the crossfader at 'position' (-1 is all the way to the left, 1 all the way to the right)
+  static float getCrossfadeGain(CrossfadeSide side, float position, CrossfadeCurve curve);
+
+  // Safe to call on any thread, and picked up by the audio thread at its next chunk ('inputIndex' is in the order inputs were added)
+  void setFaderLevel(int inputIndex, float level);
+  void setCrossfadeSide(int inputIndex, CrossfadeSide side);
+  void setCrossfadePosition(float position);
+  void setCrossfadeCurve(CrossfadeCurve curve);
+  CrossfadeCurve getCrossfadeCurve() const;
+
+  // Any thread, level of 'inputIndex' before its fader (reset whenever an earlier input is removed)
+  LevelMeter& getInputMeter(int inputIndex);
+
+  // Called on the message thread, renders decks on this many worker threads as well as the audio thread (0 renders every deck on the audio thread)
+  void setNumWorkerThreads(int numThreads);
+  int getNumWorkerThreads() const;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  static constexpr int maxInputs = 32;
+  static constexpr int numChannels = 2;
+  static constexpr int chunkSize = 256;
+
+private:
+  juce::CriticalSection lock;
+  juce::Array<juce::AudioSource*> inputs;
+
+  // 'numChannels' per input, 'chunkSize' samples long
+  juce::AudioBuffer<float> inputBuffers;
+
+  // Renders one input's part of the current chunk (called on the audio thread or one of 'renderPool's workers)
+  void runJob(int inputIndex) override;
+  int chunkNumSamples = 0;
+
+  // Fader level times crossfade gain of 'inputIndex', from the latest settings
+  float getTargetGain(int inputIndex) const;
+
+  // Glides 'inputIndex's gain over its part of the current chunk if it is still moving, and returns the gain left to apply while summing
+  float applyGainRamp(int inputIndex);
+
+  // Set from any thread, read on the audio thread
+  std::atomic<float> faderLevels[maxInputs];
+  std::atomic<int> crossfadeSides[maxInputs];
+  std::atomic<float> crossfadePosition{ 0.0f };
+  std::atomic<int> crossfadeCurve{ static_cast<int>(CrossfadeCurve::linear) };
+
+  // Audio thread only (or under 'lock')
+  juce::SmoothedValue<float> gains[maxInputs];
+  LevelMeter inputMeters[maxInputs];
+  double gainRampSeconds = 0.005; // Short enough for a clean cut while scratching, long enough not to click
+
+  std::unique_ptr<DeckRenderPool> renderPool; // nullptr when rendering on the audio thread only
+
+  double currentSampleRate = 0.0;
+  bool isPrepared = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckMixerAudioSource)
+};
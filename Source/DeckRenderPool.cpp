@@ -0,0 +1,131 @@
+#include <JuceHeader.h>
+#include <thread>
+#include "DeckRenderPool.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <xmmintrin.h>
+#endif
+
+// Called in spin loops, so the waiting thread eases off the core it shares with another hyperthread
+static void pauseWhileSpinning()
+{
+#if JUCE_USE_SSE_INTRINSICS
+  _mm_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+DeckRenderPool::Worker::Worker(DeckRenderPool& _pool, int workerIndex)
+  : juce::Thread("Deck render " + juce::String(workerIndex + 1)),
+    pool(_pool)
+{
+}
+
+void DeckRenderPool::Worker::run()
+{
+  juce::ScopedNoDenormals noDenormals;
+  juce::uint32 lastRunNumber = 0;
+  int spins = 0;
+
+  while (!threadShouldExit())
+  {
+    juce::uint32 latestRunNumber = static_cast<juce::uint32>(pool.nextJob.load() >> 32);
+    if (latestRunNumber != lastRunNumber)
+    {
+      lastRunNumber = latestRunNumber;
+      while (pool.doNextJob(latestRunNumber)) {}
+      spins = 0;
+      continue;
+    }
+
+    if (++spins < spinCount)
+    {
+      pauseWhileSpinning();
+      continue;
+    }
+
+    // run() checks 'isSleeping' after publishing each run, so a wake up is never missed
+    isSleeping.store(true);
+    if (static_cast<juce::uint32>(pool.nextJob.load() >> 32) == lastRunNumber) wakeEvent.wait(100);
+    isSleeping.store(false);
+    spins = 0;
+  }
+}
+
+DeckRenderPool::DeckRenderPool(int _numThreads)
+{
+  for (int i = 0; i < _numThreads; ++i)
+  {
+    workers.push_back(std::make_unique<Worker>(*this, i));
+
+    // Real-time priority where the OS allows it, otherwise as high as a normal thread can go
+    if (!workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+    {
+      DBG("> DeckRenderPool::DeckRenderPool says: unable to start a real-time thread, using the highest normal priority instead\n");
+      workers.back()->startThread(juce::Thread::Priority::highest);
+    }
+  }
+}
+
+DeckRenderPool::~DeckRenderPool()
+{
+  for (auto& worker : workers)
+  {
+    worker->signalThreadShouldExit();
+    worker->wakeEvent.signal();
+  }
+
+  for (auto& worker : workers) worker->stopThread(1'000);
+}
+
+void DeckRenderPool::run(Task& task, int numJobs)
+{
+  if (numJobs <= 0) return;
+  jassert(numJobs <= maxJobs);
+  numJobs = juce::jmin(numJobs, maxJobs);
+
+  // Every job of the last run has been claimed and done by now, so a thread late from it only ever sees its claim fail or find no jobs left
+  // (the task is set before the run is published below, and any thread that claims one of its jobs has seen it)
+  ++runNumber;
+  numJobsDone.store(0);
+  currentTask.store(&task);
+  nextJob.store((static_cast<juce::uint64>(runNumber) << 32) | (static_cast<juce::uint64>(numJobs) << 16));
+
+  for (auto& worker : workers)
+    if (worker->isSleeping.load()) worker->wakeEvent.signal();
+
+  // Work alongside the workers, then wait for any jobs they are still on
+  while (doNextJob(runNumber)) {}
+  while (numJobsDone.load() < numJobs) pauseWhileSpinning();
+}
+
+int DeckRenderPool::getNumThreads() const
+{
+  return static_cast<int>(workers.size());
+}
+
+bool DeckRenderPool::doNextJob(juce::uint32 runNumberToJoin)
+{
+  juce::uint64 claim = nextJob.load();
+
+  for (;;)
+  {
+    // A newer run has started (its jobs are claimed under its own run number)
+    if (static_cast<juce::uint32>(claim >> 32) != runNumberToJoin) return false;
+
+    // Read from the same word as the run number, so they always belong to the same run
+    int numJobs = static_cast<int>((claim >> 16) & 0xffff);
+    int jobIndex = static_cast<int>(claim & 0xffff);
+    if (jobIndex >= numJobs) return false;
+
+    // Only succeeds if nobody claimed this job (or started another run) in the meantime, in which case 'task' is still this run's
+    Task* task = currentTask.load();
+    if (nextJob.compare_exchange_weak(claim, claim + 1))
+    {
+      task->runJob(jobIndex);
+      numJobsDone.fetch_add(1);
+      return true;
+    }
+  }
+}
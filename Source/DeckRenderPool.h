@@ -0,0 +1,67 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/*
+Pre-spawned real-time worker threads that share out one audio block's jobs (eg. one job per deck) with the audio thread.
+1. jobs are claimed from a single atomic word (run number, number of jobs and next job together), so nothing is locked or allocated while a block is being worked on,
+   and a thread still finishing an old run can never claim a job of the next one
+2. the audio thread claims jobs too, so every job still gets done even if no worker wakes up in time
+3. workers spin for a short while after each block (the next one is usually close behind), then sleep until woken
+*/
+class DeckRenderPool
+{
+public:
+  // Work for one call to run()
+  class Task
+  {
+  public:
+    virtual ~Task() = default;
+
+    // Called once for every index from 0 to 'numJobs' - 1, on any of the threads (in no particular order)
+    virtual void runJob(int jobIndex) = 0;
+  };
+
+  DeckRenderPool(int _numThreads);
+  ~DeckRenderPool();
+
+  // Called on the audio thread, returns once every job of 'task' is done ('numJobs' is at most 'maxJobs')
+  void run(Task& task, int numJobs);
+
+  static constexpr int maxJobs = 0xffff;
+
+  int getNumThreads() const;
+
+private:
+  class Worker : public juce::Thread
+  {
+  public:
+    Worker(DeckRenderPool& _pool, int workerIndex);
+    void run() override;
+
+    std::atomic<bool> isSleeping{ false };
+    juce::WaitableEvent wakeEvent;
+
+  private:
+    DeckRenderPool& pool;
+  };
+
+  // Claims and runs one job of run number 'runNumberToJoin', returns false once there are none left
+  bool doNextJob(juce::uint32 runNumberToJoin);
+
+  // Run number in the top 32 bits, that run's number of jobs in the next 16, and the index of the next job to claim in the bottom 16
+  // (published in one store, so the number of jobs can never be seen paired with another run's number)
+  std::atomic<juce::uint64> nextJob{ 0 };
+  std::atomic<Task*> currentTask{ nullptr };
+  std::atomic<int> numJobsDone{ 0 };
+  juce::uint32 runNumber = 0; // Only used on the audio thread
+
+  // How many times a worker checks for the next block before it goes to sleep
+  static constexpr int spinCount = 20'000;
+
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckRenderPool)
+};
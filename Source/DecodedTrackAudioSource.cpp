@@ -0,0 +1,68 @@
+#include <JuceHeader.h>
+#include "DecodedTrackAudioSource.h"
+
+DecodedTrackAudioSource::DecodedTrackAudioSource(std::shared_ptr<const DecodedTrack> _track)
+  : track(std::move(_track))
+{
+}
+
+DecodedTrackAudioSource::~DecodedTrackAudioSource()
+{
+}
+
+void DecodedTrackAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+}
+
+void DecodedTrackAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  const juce::int64 playPos = nextPlayPos.load();
+  const juce::int64 playEnd = playPos + bufferToFill.numSamples;
+
+  // Part of this block that lies within the track
+  const juce::int64 copyStart = juce::jlimit(static_cast<juce::int64>(0), track->getLengthInSamples(), playPos);
+  const juce::int64 copyEnd = juce::jlimit(static_cast<juce::int64>(0), track->getLengthInSamples(), playEnd);
+
+  if (copyEnd <= copyStart)
+  {
+    bufferToFill.clearActiveBufferRegion();
+  }
+  else
+  {
+    // Silence before the start or after the end of the track
+    const int silenceBefore = static_cast<int>(copyStart - playPos);
+    const int silenceAfter = static_cast<int>(playEnd - copyEnd);
+    if (silenceBefore > 0) bufferToFill.buffer->clear(bufferToFill.startSample, silenceBefore);
+    if (silenceAfter > 0) bufferToFill.buffer->clear(bufferToFill.startSample + bufferToFill.numSamples - silenceAfter, silenceAfter);
+
+    track->read(*bufferToFill.buffer, bufferToFill.startSample + silenceBefore, copyStart, static_cast<int>(copyEnd - copyStart));
+  }
+
+  // Do not overwrite a seek that happened while this block was being copied
+  juce::int64 expectedPos = playPos;
+  nextPlayPos.compare_exchange_strong(expectedPos, playEnd);
+}
+
+void DecodedTrackAudioSource::releaseResources()
+{
+}
+
+void DecodedTrackAudioSource::setNextReadPosition(juce::int64 newPosition)
+{
+  nextPlayPos = newPosition;
+}
+
+juce::int64 DecodedTrackAudioSource::getNextReadPosition() const
+{
+  return nextPlayPos.load();
+}
+
+juce::int64 DecodedTrackAudioSource::getTotalLength() const
+{
+  return track->getLengthInSamples();
+}
+
+bool DecodedTrackAudioSource::isLooping() const
+{
+  return false;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include "DecodedTrackCache.h"
+
+// Plays a DecodedTrack straight from memory (no disk or decoder work on the audio thread)
+class DecodedTrackAudioSource : public juce::PositionableAudioSource
+{
+public:
+  DecodedTrackAudioSource(std::shared_ptr<const DecodedTrack> _track);
+  ~DecodedTrackAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  void setNextReadPosition(juce::int64 newPosition) override;
+  juce::int64 getNextReadPosition() const override;
+  juce::int64 getTotalLength() const override;
+  bool isLooping() const override;
+
+private:
+  std::shared_ptr<const DecodedTrack> track;
+  std::atomic<juce::int64> nextPlayPos{ 0 };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedTrackAudioSource)
+};
@@ -0,0 +1,206 @@
+#include <JuceHeader.h>
+#include "DecodedTrackCache.h"
+
+// ----- DecodedTrack ----- //
+DecodedTrack::DecodedTrack(int _numChannels, juce::int64 _numSamples, double _sampleRate, SampleFormat _sampleFormat)
+  : numChannels(_numChannels),
+    numSamples(_numSamples),
+    sampleRate(_sampleRate),
+    sampleFormat(_sampleFormat)
+{
+  if (sampleFormat == SampleFormat::float32) floatSamples.setSize(numChannels, static_cast<int>(numSamples));
+  else int16Samples.resize(static_cast<size_t>(numChannels) * static_cast<size_t>(numSamples));
+}
+
+std::shared_ptr<DecodedTrack> DecodedTrack::decode(juce::AudioFormatReader& reader, SampleFormat sampleFormat, std::function<bool()> shouldStop)
+{
+  DecodedTrackBuilder builder(sampleFormat);
+  TrackAnalyser::Stats stats;
+  if (!TrackAnalyser::run(reader, { &builder }, shouldStop, stats)) return nullptr;
+
+  return builder.getTrack();
+}
+
+void DecodedTrack::write(const juce::AudioBuffer<float>& source, juce::int64 destinationStartSample, int numSamplesToWrite)
+{
+  numSamplesToWrite = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamplesToWrite), numSamples - destinationStartSample));
+  if (numSamplesToWrite <= 0) return;
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    // Float tracks are copied straight into place
+    if (sampleFormat == SampleFormat::float32)
+    {
+      floatSamples.copyFrom(channel, static_cast<int>(destinationStartSample), source, channel, 0, numSamplesToWrite);
+      continue;
+    }
+
+    const float* input = source.getReadPointer(channel);
+    juce::int16* destination = int16Samples.data() + (channel * numSamples) + destinationStartSample;
+    for (int i = 0; i < numSamplesToWrite; ++i) destination[i] = static_cast<juce::int16>(juce::roundToInt(juce::jlimit(-1.0f, 1.0f, input[i]) * 32'767.0f));
+  }
+}
+
+void DecodedTrack::read(juce::AudioBuffer<float>& destination, int destinationStartSample, juce::int64 sourceStartSample, int numSamplesToRead) const
+{
+  for (int channel = 0; channel < destination.getNumChannels(); ++channel)
+  {
+    int sourceChannel = juce::jmin(channel, numChannels - 1);
+
+    if (sampleFormat == SampleFormat::float32)
+    {
+      destination.copyFrom(channel, destinationStartSample, floatSamples, sourceChannel, static_cast<int>(sourceStartSample), numSamplesToRead);
+    }
+    else
+    {
+      const juce::int16* source = int16Samples.data() + (sourceChannel * numSamples) + sourceStartSample;
+      float* output = destination.getWritePointer(channel, destinationStartSample);
+      for (int i = 0; i < numSamplesToRead; ++i) output[i] = source[i] * (1.0f / 32'767.0f);
+    }
+  }
+}
+
+int DecodedTrack::getNumChannels() const
+{
+  return numChannels;
+}
+
+juce::int64 DecodedTrack::getLengthInSamples() const
+{
+  return numSamples;
+}
+
+double DecodedTrack::getSampleRate() const
+{
+  return sampleRate;
+}
+
+size_t DecodedTrack::getSizeInBytes() const
+{
+  size_t bytesPerSample = sampleFormat == SampleFormat::float32 ? sizeof(float) : sizeof(juce::int16);
+  return static_cast<size_t>(numChannels) * static_cast<size_t>(numSamples) * bytesPerSample;
+}
+
+// ----- DecodedTrackBuilder ----- //
+DecodedTrackBuilder::DecodedTrackBuilder(DecodedTrack::SampleFormat _sampleFormat)
+  : sampleFormat(_sampleFormat)
+{
+}
+
+DecodedTrackBuilder::~DecodedTrackBuilder()
+{
+}
+
+void DecodedTrackBuilder::analysisStarted(int numChannels, double sampleRate, juce::int64 lengthInSamples)
+{
+  // juce::AudioBuffer is indexed by int
+  if (lengthInSamples > std::numeric_limits<int>::max()) return;
+
+  track = std::make_shared<DecodedTrack>(numChannels, lengthInSamples, sampleRate, sampleFormat);
+}
+
+void DecodedTrackBuilder::analysisBlock(const juce::AudioBuffer<float>& block, juce::int64 position, int numSamples)
+{
+  if (track != nullptr) track->write(block, position, numSamples);
+}
+
+bool DecodedTrackBuilder::analysisFinished()
+{
+  finished = true;
+  return track != nullptr;
+}
+
+std::shared_ptr<DecodedTrack> DecodedTrackBuilder::getTrack() const
+{
+  return finished ? track : nullptr;
+}
+
+// ----- DecodedTrackCache ----- //
+DecodedTrackCache::DecodedTrackCache(size_t _memoryBudgetInBytes)
+  : memoryBudget(_memoryBudgetInBytes)
+{
+}
+
+DecodedTrackCache::~DecodedTrackCache()
+{
+}
+
+void DecodedTrackCache::setMemoryBudget(size_t memoryBudgetInBytes)
+{
+  const juce::ScopedLock sl(cacheLock);
+  memoryBudget = memoryBudgetInBytes;
+  evictUntilWithinBudget();
+}
+
+size_t DecodedTrackCache::getMemoryBudget() const
+{
+  const juce::ScopedLock sl(cacheLock);
+  return memoryBudget;
+}
+
+size_t DecodedTrackCache::getMemoryUsage() const
+{
+  const juce::ScopedLock sl(cacheLock);
+  return memoryUsage;
+}
+
+void DecodedTrackCache::setSampleFormat(DecodedTrack::SampleFormat _sampleFormat)
+{
+  const juce::ScopedLock sl(cacheLock);
+  sampleFormat = _sampleFormat;
+}
+
+DecodedTrack::SampleFormat DecodedTrackCache::getSampleFormat() const
+{
+  const juce::ScopedLock sl(cacheLock);
+  return sampleFormat;
+}
+
+std::shared_ptr<const DecodedTrack> DecodedTrackCache::find(const juce::String& key)
+{
+  const juce::ScopedLock sl(cacheLock);
+
+  for (auto it = entries.begin(); it != entries.end(); ++it)
+  {
+    if (it->key == key)
+    {
+      // Move to the front (most recently used)
+      entries.splice(entries.begin(), entries, it);
+      return entries.front().track;
+    }
+  }
+
+  return nullptr;
+}
+
+void DecodedTrackCache::insert(const juce::String& key, std::shared_ptr<const DecodedTrack> track)
+{
+  if (track == nullptr) return;
+
+  const juce::ScopedLock sl(cacheLock);
+
+  // Replace any older copy of the same track
+  for (auto it = entries.begin(); it != entries.end(); ++it)
+  {
+    if (it->key == key)
+    {
+      memoryUsage -= it->track->getSizeInBytes();
+      entries.erase(it);
+      break;
+    }
+  }
+
+  memoryUsage += track->getSizeInBytes();
+  entries.push_front({ key, std::move(track) });
+  evictUntilWithinBudget();
+}
+
+void DecodedTrackCache::evictUntilWithinBudget()
+{
+  // Least recently used tracks are at the back
+  while (memoryUsage > memoryBudget && !entries.empty())
+  {
+    memoryUsage -= entries.back().track->getSizeInBytes();
+    entries.pop_back();
+  }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+#include "TrackAnalyser.h"
+
+// An entire track decoded into memory (as float, or as 16-bit to halve the memory used)
+class DecodedTrack
+{
+public:
+  enum class SampleFormat
+  {
+    float32,
+    int16
+  };
+
+  DecodedTrack(int _numChannels, juce::int64 _numSamples, double _sampleRate, SampleFormat _sampleFormat);
+
+  // Decodes all of 'reader' (returns nullptr if it fails, or if 'shouldStop' returns true part way through)
+  static std::shared_ptr<DecodedTrack> decode(juce::AudioFormatReader& reader, SampleFormat sampleFormat, std::function<bool()> shouldStop);
+
+  // Copies (and converts if needed) into 'destination', mono tracks are copied into every channel
+  void read(juce::AudioBuffer<float>& destination, int destinationStartSample, juce::int64 sourceStartSample, int numSamples) const;
+
+  int getNumChannels() const;
+  juce::int64 getLengthInSamples() const;
+  double getSampleRate() const;
+  size_t getSizeInBytes() const;
+
+private:
+  friend class DecodedTrackBuilder;
+
+  // Copies (and converts if needed) from 'source', which must have at least 'numChannels' channels
+  void write(const juce::AudioBuffer<float>& source, juce::int64 destinationStartSample, int numSamplesToWrite);
+
+  int numChannels;
+  juce::int64 numSamples;
+  double sampleRate;
+  SampleFormat sampleFormat;
+
+  // Only one of these is used, depending on 'sampleFormat'
+  juce::AudioBuffer<float> floatSamples;
+  std::vector<juce::int16> int16Samples; // One channel after another (not interleaved)
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedTrack)
+};
+
+// Fills a DecodedTrack from a TrackAnalyser pass (so it can share the pass with other consumers)
+class DecodedTrackBuilder : public TrackAnalyser::Consumer
+{
+public:
+  DecodedTrackBuilder(DecodedTrack::SampleFormat _sampleFormat);
+  ~DecodedTrackBuilder() override;
+
+  void analysisStarted(int numChannels, double sampleRate, juce::int64 lengthInSamples) override;
+  void analysisBlock(const juce::AudioBuffer<float>& block, juce::int64 position, int numSamples) override;
+  bool analysisFinished() override;
+
+  // nullptr until the pass has finished (or if the track is too long to hold)
+  std::shared_ptr<DecodedTrack> getTrack() const;
+
+private:
+  DecodedTrack::SampleFormat sampleFormat;
+  std::shared_ptr<DecodedTrack> track;
+  bool finished = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedTrackBuilder)
+};
+
+/*
+Keeps recently decoded tracks in memory, so loading them again is instant.
+When the memory budget is exceeded, the least recently used tracks are evicted
+(a deck that is still playing an evicted track keeps it alive until it loads something else).
+*/
+class DecodedTrackCache
+{
+public:
+  DecodedTrackCache(size_t _memoryBudgetInBytes = static_cast<size_t>(512) * 1024 * 1024);
+  ~DecodedTrackCache();
+
+  void setMemoryBudget(size_t memoryBudgetInBytes);
+  size_t getMemoryBudget() const;
+  size_t getMemoryUsage() const;
+
+  // Applies to tracks decoded after this is called
+  void setSampleFormat(DecodedTrack::SampleFormat _sampleFormat);
+  DecodedTrack::SampleFormat getSampleFormat() const;
+
+  // Returns nullptr if 'key' is not cached (also marks it as most recently used)
+  std::shared_ptr<const DecodedTrack> find(const juce::String& key);
+  void insert(const juce::String& key, std::shared_ptr<const DecodedTrack> track);
+
+private:
+  // 'cacheLock' must be held
+  void evictUntilWithinBudget();
+
+  struct Entry
+  {
+    juce::String key;
+    std::shared_ptr<const DecodedTrack> track;
+  };
+
+  juce::CriticalSection cacheLock;
+  std::list<Entry> entries; // Most recently used at the front
+  size_t memoryUsage = 0;
+  size_t memoryBudget;
+  DecodedTrack::SampleFormat sampleFormat = DecodedTrack::SampleFormat::float32;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedTrackCache)
+};
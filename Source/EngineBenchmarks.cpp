@@ -0,0 +1,1349 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "EngineBenchmarks.h"
+#include "DJAudioPlayer.h"
+#include "DeckManager.h"
+#include "LibraryImporter.h"
+#include "LibrarySearch.h"
+#include "TrackStore.h"
+#include "LibrarySort.h"
+#include "LibraryFile.h"
+#include "EqualiserAudioSource.h"
+#include "LevelMeter.h"
+#include "LookAheadLimiter.h"
+#include "TrackAnalyser.h"
+#include "LibraryCellPainter.h"
+
+// Heap allocations made by each thread, so the table benchmark can count what painting a frame allocates
+// (this file is only built into the headless app, so the app itself keeps the standard operator new)
+static thread_local juce::int64 numHeapAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+  ++numHeapAllocations;
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+EngineBenchmarks::EngineBenchmarks(Options _options)
+  : options(_options)
+{
+  formatManager.registerBasicFormats();
+  options.workingDirectory.createDirectory();
+}
+
+EngineBenchmarks::~EngineBenchmarks()
+{
+}
+
+juce::var EngineBenchmarks::runAll()
+{
+  juce::DynamicObject::Ptr machine = new juce::DynamicObject();
+  machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+  machine->setProperty("numCpus", juce::SystemStats::getNumCpus());
+  machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+  machine->setProperty("juce", juce::SystemStats::getJUCEVersion());
+
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+  results->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+  results->setProperty("machine", machine.get());
+  results->setProperty("decode", runDecode());
+  results->setProperty("deck", runDeck());
+  results->setProperty("mixer", runMixer());
+  results->setProperty("capacity", runCapacity());
+  results->setProperty("equaliser", runEqualiser());
+  results->setProperty("master", runMaster());
+  results->setProperty("import", runImport());
+  results->setProperty("startup", runStartup());
+  results->setProperty("search", runSearch());
+  results->setProperty("libraryFile", runLibraryFile());
+  results->setProperty("load", runLoad());
+  results->setProperty("waveform", runWaveform());
+  results->setProperty("table", runTable());
+  return results.get();
+}
+
+juce::var EngineBenchmarks::runDecode()
+{
+  // One generated track per format that can write, then whatever else was given
+  juce::Array<juce::File> files;
+  for (int i = 0; i < formatManager.getNumKnownFormats(); ++i)
+  {
+    juce::AudioFormat* format = formatManager.getKnownFormat(i);
+    juce::File file = options.workingDirectory.getChildFile("decode").getChildFile("test" + format->getFileExtensions()[0]);
+    if (writeTestTrack(*format, file, options.secondsOfAudio)) files.add(file);
+  }
+  files.addArray(options.extraFiles);
+
+  // Takes every block and does nothing with it, so what is timed is the decoding alone (TrackAnalyser::run() needs at least one consumer)
+  struct DecodeOnly : public TrackAnalyser::Consumer
+  {
+    void analysisStarted(int, double, juce::int64) override {}
+    void analysisBlock(const juce::AudioBuffer<float>&, juce::int64, int) override {}
+    bool analysisFinished() override { return true; }
+  };
+
+  juce::Array<juce::var> results;
+  for (const juce::File& file : files)
+  {
+    TrackAnalyser::Stats stats;
+    std::unique_ptr<juce::AudioFormatReader> reader = TrackAnalyser::createReader(formatManager, file, stats);
+    if (reader == nullptr) continue;
+
+    DecodeOnly decodeOnly;
+    bool decoded = TrackAnalyser::run(*reader, { &decodeOnly }, []() { return false; }, stats);
+    double seconds = stats.milliseconds / 1'000.0;
+    double audioSeconds = reader->lengthInSamples / reader->sampleRate;
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("file", file.getFileName());
+    result->setProperty("format", reader->getFormatName());
+    result->setProperty("audioSeconds", audioSeconds);
+
+    // Reported as failed rather than as 0 MB/s
+    if (!decoded || stats.bytesRead <= 0 || seconds <= 0)
+    {
+      std::cerr << "Decode benchmark: unable to decode " << file.getFullPathName() << std::endl;
+      result->setProperty("error", "Nothing was decoded");
+      results.add(result.get());
+      continue;
+    }
+
+    result->setProperty("megabytesPerSecond", (stats.bytesRead / (1024.0 * 1024.0)) / seconds);
+    result->setProperty("timesRealTime", audioSeconds / seconds);
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runDeck()
+{
+  // Same dependencies as in MainComponent, with the track in RAM so the disk is not part of the timing
+  juce::TimeSliceThread readAheadThread{ "Benchmark read-ahead" };
+  DecodedTrackCache decodedTrackCache;
+  PeakFileStore peakFileStore{ formatManager, options.workingDirectory.getChildFile("peak-cache") };
+  DJAudioPlayer player{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+
+  juce::Array<juce::var> results;
+  player.setLoadIntoRam(true);
+  player.loadURL(juce::URL{ getTestWavFile() });
+  if (!player.isLoadedIntoRam()) return results;
+
+  const double sampleRate = 44'100;
+  const int blockSizes[] = { 64, 128, 256, 512, 1'024, 2'048 };
+  const char* modeNames[] = { "standard", "highQuality", "keyLock" };
+
+  // Looping so the track never runs out, and started once (before audio starts, so straight away) rather than around each timing
+  player.setLooping(true);
+  player.start();
+
+  for (int mode = 0; mode < TempoAudioSource::numModes; ++mode)
+  {
+    for (int blockSize : blockSizes)
+    {
+      player.prepareToPlay(blockSize, sampleRate);
+
+      // Slightly off 1x, so the tempo stage has real work to do
+      player.setTempoMode(static_cast<TempoAudioSource::Mode>(mode));
+      player.setSpeed(1.08);
+      player.setPosition(0);
+
+      juce::AudioBuffer<float> buffer(2, blockSize);
+      juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+      int numBlocks = juce::jmax(1, static_cast<int>((options.secondsOfAudio * sampleRate) / blockSize));
+
+      // Warm up (also applies the commands above), then time
+      for (int i = 0; i < 16; ++i) player.getNextAudioBlock(info);
+
+      juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+      for (int i = 0; i < numBlocks; ++i) player.getNextAudioBlock(info);
+      double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+      player.releaseResources();
+
+      double numSamples = static_cast<double>(numBlocks) * blockSize;
+      juce::DynamicObject::Ptr result = new juce::DynamicObject();
+      result->setProperty("tempoMode", modeNames[mode]);
+      result->setProperty("blockSize", blockSize);
+      result->setProperty("nanosecondsPerSample", (seconds * 1.0e9) / numSamples);
+      result->setProperty("shareOfRealTime", seconds / (numSamples / sampleRate));
+      results.add(result.get());
+    }
+  }
+
+  player.stop();
+  return results;
+}
+
+juce::var EngineBenchmarks::runMixer()
+{
+  juce::TimeSliceThread readAheadThread{ "Benchmark read-ahead" };
+  DecodedTrackCache decodedTrackCache; // Every deck shares the one decoded copy of the test track
+  PeakFileStore peakFileStore{ formatManager, options.workingDirectory.getChildFile("peak-cache") };
+
+  juce::Array<juce::var> results;
+  const double sampleRate = 44'100;
+  const int blockSize = 512;
+  const int deckCounts[] = { 1, 2, 4, 8 };
+  double oneDeckNanoseconds = 0.0;
+
+  for (int numDecks : deckCounts)
+  {
+    DeckManager deckManager{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+    for (int i = 0; i < numDecks; ++i)
+    {
+      DJAudioPlayer* player = deckManager.addDeck();
+      player->setLoadIntoRam(true);
+      player->loadURL(juce::URL{ getTestWavFile() });
+      if (!player->isLoadedIntoRam()) return results;
+
+      // Looping so the track never runs out, and each deck at its own speed so they do not line up
+      player->setSpeed(1.0 + (i * 0.01));
+      player->setLooping(true);
+      player->start();
+    }
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+    int numBlocks = juce::jmax(1, static_cast<int>((options.secondsOfAudio * sampleRate) / blockSize));
+
+    // Times 'mixer' over the same number of blocks, after a warm up
+    auto timeMixer = [&](juce::AudioSource& mixer)
+      {
+        mixer.prepareToPlay(blockSize, sampleRate);
+        for (int i = 0; i < 16; ++i) mixer.getNextAudioBlock(info);
+
+        juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numBlocks; ++i) mixer.getNextAudioBlock(info);
+        double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        mixer.releaseResources();
+        return seconds;
+      };
+
+    double deckMixerSeconds = timeMixer(deckManager.getMixer());
+
+    juce::MixerAudioSource mixerSource;
+    for (int i = 0; i < numDecks; ++i) mixerSource.addInputSource(deckManager.getDeck(i), false);
+    double mixerSourceSeconds = timeMixer(mixerSource);
+    mixerSource.removeAllInputs();
+
+    // The decks rendering into one buffer without being mixed, so what each mixer adds on top (clearing, copying and summing) can be told apart
+    for (int i = 0; i < numDecks; ++i) deckManager.getDeck(i)->prepareToPlay(blockSize, sampleRate);
+    juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+    for (int block = 0; block < numBlocks; ++block)
+    {
+      for (int i = 0; i < numDecks; ++i) deckManager.getDeck(i)->getNextAudioBlock(info);
+    }
+    double decksOnlySeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    for (int i = 0; i < numDecks; ++i) deckManager.getDeck(i)->releaseResources();
+
+    double numSamples = static_cast<double>(numBlocks) * blockSize;
+    double nanosecondsPerSample = (deckMixerSeconds * 1.0e9) / numSamples;
+    if (numDecks == 1) oneDeckNanoseconds = nanosecondsPerSample;
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("numDecks", numDecks);
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("nanosecondsPerSample", nanosecondsPerSample);
+    result->setProperty("nanosecondsPerSamplePerDeck", nanosecondsPerSample / numDecks);
+    result->setProperty("shareOfRealTime", deckMixerSeconds / (numSamples / sampleRate));
+    result->setProperty("mixerAudioSourceNanosecondsPerSample", (mixerSourceSeconds * 1.0e9) / numSamples);
+    result->setProperty("decksOnlyNanosecondsPerSample", (decksOnlySeconds * 1.0e9) / numSamples);
+    result->setProperty("mixingNanosecondsPerSample", ((deckMixerSeconds - decksOnlySeconds) * 1.0e9) / numSamples);
+    result->setProperty("mixerAudioSourceMixingNanosecondsPerSample", ((mixerSourceSeconds - decksOnlySeconds) * 1.0e9) / numSamples);
+
+    // 1 when each extra deck costs exactly what the first one did (linear scaling), above 1 when decks slow each other down
+    result->setProperty("costPerDeckVersusOneDeck", oneDeckNanoseconds > 0 ? (nanosecondsPerSample / numDecks) / oneDeckNanoseconds : 0.0);
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runCapacity()
+{
+  juce::TimeSliceThread readAheadThread{ "Benchmark read-ahead" };
+  DecodedTrackCache decodedTrackCache;
+  PeakFileStore peakFileStore{ formatManager, options.workingDirectory.getChildFile("peak-cache") };
+
+  // As many decks as the mixer takes, in key lock (the heaviest tempo mode) and each at its own speed
+  juce::Array<juce::var> results;
+  std::vector<std::unique_ptr<DJAudioPlayer>> players;
+  for (int i = 0; i < DeckMixerAudioSource::maxInputs; ++i)
+  {
+    players.push_back(std::make_unique<DJAudioPlayer>(formatManager, readAheadThread, decodedTrackCache, peakFileStore));
+    DJAudioPlayer& player = *players.back();
+    player.setLoadIntoRam(true);
+    player.loadURL(juce::URL{ getTestWavFile() });
+    if (!player.isLoadedIntoRam()) return results;
+
+    player.setTempoMode(TempoAudioSource::Mode::keyLock);
+    player.setSpeed(1.0 + (i * 0.01));
+    player.setLooping(true);
+    player.start();
+  }
+
+  const double sampleRate = 44'100;
+  const double secondsPerTrial = juce::jmin(1.0, options.secondsOfAudio);
+  const int blockSizes[] = { 64, 128, 256 };
+  int maxWorkerThreads = juce::jlimit(0, 3, juce::SystemStats::getNumCpus() - 1);
+
+  for (int numWorkerThreads = 0; numWorkerThreads <= maxWorkerThreads; ++numWorkerThreads)
+  {
+    for (int blockSize : blockSizes)
+    {
+      DeckMixerAudioSource mixer;
+      mixer.setNumWorkerThreads(numWorkerThreads);
+
+      // Whether 'numDecks' decks get through 'secondsPerTrial' without a single xrun
+      auto fitsInRealTime = [&](int numDecks)
+        {
+          for (int i = 0; i < numDecks; ++i) mixer.addInputSource(players[static_cast<size_t>(i)].get());
+          mixer.prepareToPlay(blockSize, sampleRate);
+
+          juce::AudioBuffer<float> buffer(2, blockSize);
+          juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+          int numBlocks = juce::jmax(1, static_cast<int>((secondsPerTrial * sampleRate) / blockSize));
+          double blockSeconds = blockSize / sampleRate;
+
+          // Warm up (also applies the commands above), then time every block against how long it lasts
+          for (int i = 0; i < 16; ++i) mixer.getNextAudioBlock(info);
+
+          bool fits = true;
+          for (int i = 0; i < numBlocks && fits; ++i)
+          {
+            juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+            mixer.getNextAudioBlock(info);
+            fits = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) <= blockSeconds;
+          }
+
+          mixer.releaseResources();
+          mixer.removeAllInputs();
+          return fits;
+        };
+
+      // Double the deck count until it no longer fits, then narrow down between the last count that did and the first that did not
+      int mostThatFit = 0;
+      int fewestThatDoNot = DeckMixerAudioSource::maxInputs + 1;
+      for (int numDecks = 1; numDecks <= DeckMixerAudioSource::maxInputs; numDecks *= 2)
+      {
+        if (!fitsInRealTime(numDecks))
+        {
+          fewestThatDoNot = numDecks;
+          break;
+        }
+        mostThatFit = numDecks;
+      }
+
+      while (fewestThatDoNot - mostThatFit > 1)
+      {
+        int numDecks = (mostThatFit + fewestThatDoNot) / 2;
+        if (fitsInRealTime(numDecks)) mostThatFit = numDecks;
+        else fewestThatDoNot = numDecks;
+      }
+
+      int numCores = numWorkerThreads + 1;
+      juce::DynamicObject::Ptr result = new juce::DynamicObject();
+      result->setProperty("blockSize", blockSize);
+      result->setProperty("cores", numCores);
+      result->setProperty("maxDecks", mostThatFit);
+      result->setProperty("maxDecksPerCore", mostThatFit / static_cast<double>(numCores));
+      result->setProperty("reachedDeckLimit", mostThatFit == DeckMixerAudioSource::maxInputs); // More decks may have fit, had the mixer taken them
+      results.add(result.get());
+    }
+  }
+
+  for (auto& player : players) player->stop();
+  return results;
+}
+
+juce::var EngineBenchmarks::runEqualiser()
+{
+  // Plays a second of noise over and over, so the filters are all that is being timed
+  class NoiseSource : public juce::AudioSource
+  {
+  public:
+    NoiseSource()
+    {
+      juce::Random random{ 1 };
+      for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+      {
+        for (int i = 0; i < noise.getNumSamples(); ++i) noise.setSample(channel, i, random.nextFloat() - 0.5f);
+      }
+    }
+
+    void prepareToPlay(int, double) override {}
+    void releaseResources() override {}
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
+    {
+      for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+      {
+        bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, noise, channel, position, bufferToFill.numSamples);
+      }
+      position = (position + bufferToFill.numSamples) % (noise.getNumSamples() - 4'096);
+    }
+
+  private:
+    juce::AudioBuffer<float> noise{ 2, 44'100 };
+    int position = 0;
+  };
+
+  juce::Array<juce::var> results;
+  const double sampleRate = 44'100;
+  const int blockSizes[] = { 64, 256, 1'024 };
+
+  for (int blockSize : blockSizes)
+  {
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+    int numBlocks = juce::jmax(1, static_cast<int>((options.secondsOfAudio * sampleRate) / blockSize));
+
+    // Cost of 'source' (over its input), in ns per sample
+    auto timeSource = [&](juce::AudioSource& source, NoiseSource& input)
+      {
+        source.prepareToPlay(blockSize, sampleRate);
+        for (int i = 0; i < 16; ++i) source.getNextAudioBlock(info);
+
+        juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numBlocks; ++i) source.getNextAudioBlock(info);
+        double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        // Just the noise, taken off again
+        startTicks = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numBlocks; ++i) input.getNextAudioBlock(info);
+        seconds -= juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        source.releaseResources();
+        return (juce::jmax(0.0, seconds) * 1.0e9) / (static_cast<double>(numBlocks) * blockSize);
+      };
+
+    // Every band doing something audible (the deck's defaults leave the low- and high-pass almost open)
+    const float lowCutoff = 8'000.0f;
+    const float midCutoff = 1'000.0f;
+    const float highCutoff = 100.0f;
+
+    NoiseSource equaliserInput;
+    EqualiserAudioSource equaliser{ &equaliserInput };
+    equaliser.setCutoff(EqualiserAudioSource::Band::low, lowCutoff);
+    equaliser.setCutoff(EqualiserAudioSource::Band::mid, midCutoff);
+    equaliser.setCutoff(EqualiserAudioSource::Band::high, highCutoff);
+    double vectorNanoseconds = timeSource(equaliser, equaliserInput);
+    equaliser.setUseVector(false);
+    double scalarNanoseconds = timeSource(equaliser, equaliserInput);
+
+    // The chain DJAudioPlayer used before, with the same Q
+    NoiseSource chainInput;
+    const double q = 1.0 / juce::MathConstants<double>::sqrt2;
+    juce::IIRFilterAudioSource lowFilterSource{ &chainInput, false };
+    juce::IIRFilterAudioSource midFilterSource{ &lowFilterSource, false };
+    juce::IIRFilterAudioSource highFilterSource{ &midFilterSource, false };
+    lowFilterSource.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, lowCutoff, q));
+    midFilterSource.setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, midCutoff, q));
+    highFilterSource.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, highCutoff, q));
+    double chainNanoseconds = timeSource(highFilterSource, chainInput);
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("vectorNanosecondsPerSample", vectorNanoseconds);
+    result->setProperty("scalarNanosecondsPerSample", scalarNanoseconds);
+    result->setProperty("iirChainNanosecondsPerSample", chainNanoseconds);
+    result->setProperty("speedupOverChain", vectorNanoseconds > 0 ? chainNanoseconds / vectorNanoseconds : 0.0);
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runMaster()
+{
+  juce::Array<juce::var> results;
+  const double sampleRate = 44'100;
+  const int blockSizes[] = { 64, 128, 256, 512 };
+
+  // A second of noise at up to +6dBFS, looped, so the limiter is kept busy the whole time
+  juce::AudioBuffer<float> signal(2, static_cast<int>(sampleRate));
+  juce::Random random{ 1 };
+  for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+  {
+    for (int i = 0; i < signal.getNumSamples(); ++i) signal.setSample(channel, i, (random.nextFloat() * 4.0f) - 2.0f);
+  }
+
+  for (int blockSize : blockSizes)
+  {
+    LookAheadLimiter limiter;
+    LevelMeter meter;
+    limiter.prepare(sampleRate);
+    meter.prepare(sampleRate);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    int numBlocks = juce::jmax(1, static_cast<int>((options.secondsOfAudio * sampleRate) / blockSize));
+    int signalPosition = 0;
+    double seconds = 0.0;
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+      // Copying the signal in is left out of the timing
+      for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+      {
+        for (int sample = 0; sample < blockSize; ++sample) buffer.setSample(channel, sample, signal.getSample(channel, (signalPosition + sample) % signal.getNumSamples()));
+      }
+      signalPosition = (signalPosition + blockSize) % signal.getNumSamples();
+
+      juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+      limiter.process(buffer, 0, blockSize);
+      meter.process(buffer, 0, blockSize);
+      seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    double numSamples = static_cast<double>(numBlocks) * blockSize;
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("nanosecondsPerSample", (seconds * 1.0e9) / numSamples);
+    result->setProperty("shareOfRealTime", seconds / (numSamples / sampleRate));
+    result->setProperty("latencySamples", limiter.getLatencyInSamples());
+    result->setProperty("latencyMilliseconds", (limiter.getLatencyInSamples() * 1000.0) / sampleRate);
+    result->setProperty("gainReductionDb", limiter.getGainReductionSinceLastRead());
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runImport()
+{
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+
+  // Different names, so every one has to be opened
+  juce::StringArray filePaths = getLibraryFilePaths();
+  if (filePaths.isEmpty()) return results.get();
+
+  // Finishes when the importer says so
+  struct ImportListener : public LibraryImporter::Listener
+  {
+    void importBatchReady(const std::vector<LibraryImporter::ImportedTrack>&) override {}
+    void importProgressChanged(const LibraryImporter::Progress&) override {}
+    void importFinished(const LibraryImporter::Progress& _progress, const juce::StringArray&, bool) override
+    {
+      progress = _progress;
+      finished = true;
+    }
+
+    LibraryImporter::Progress progress;
+    bool finished = false;
+  };
+
+  TrackMetadataCache metadataCache;
+  LibraryImporter importer{ formatManager, metadataCache };
+  const char* runNames[] = { "cold", "warm" };
+
+  // The second run finds everything in 'metadataCache'
+  for (const char* runName : runNames)
+  {
+    ImportListener listener;
+    importer.setListener(&listener);
+
+    double startTime = juce::Time::getMillisecondCounterHiRes();
+    importer.importFiles(filePaths);
+    while (!listener.finished && juce::Time::getMillisecondCounterHiRes() - startTime < 120'000)
+    {
+      juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+    }
+    double seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1'000.0;
+    importer.setListener(nullptr);
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("files", listener.progress.filesDone);
+    result->setProperty("filesFromCache", listener.progress.filesFromCache);
+    result->setProperty("filesPerSecond", seconds > 0 ? listener.progress.filesDone / seconds : 0.0);
+    result->setProperty("finished", listener.finished);
+    results->setProperty(runName, result.get());
+  }
+
+  return results.get();
+}
+
+juce::var EngineBenchmarks::runStartup()
+{
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+  juce::StringArray filePaths = getLibraryFilePaths();
+  if (filePaths.isEmpty()) return results.get();
+
+  struct ImportListener : public LibraryImporter::Listener
+  {
+    void importBatchReady(const std::vector<LibraryImporter::ImportedTrack>&) override {}
+    void importProgressChanged(const LibraryImporter::Progress&) override {}
+    void importFinished(const LibraryImporter::Progress& _progress, const juce::StringArray&, bool) override
+    {
+      progress = _progress;
+      finished = true;
+    }
+
+    LibraryImporter::Progress progress;
+    bool finished = false;
+  };
+
+  // The cold start has no cache file, and saves the one the warm start loads (both start with an empty TrackMetadataCache, as the app does)
+  juce::File cacheFile = options.workingDirectory.getChildFile("track-metadata-cache.bin");
+  cacheFile.deleteFile();
+  const char* runNames[] = { "cold", "warm" };
+
+  for (const char* runName : runNames)
+  {
+    ImportListener listener;
+    TrackMetadataCache metadataCache;
+    LibraryImporter importer{ formatManager, metadataCache };
+    importer.setListener(&listener);
+
+    // As PlaylistComponent's constructor, then its importFinished()
+    double startTime = juce::Time::getMillisecondCounterHiRes();
+    metadataCache.loadFromFile(cacheFile);
+    double cacheLoadMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    importer.importFiles(filePaths);
+    while (!listener.finished && juce::Time::getMillisecondCounterHiRes() - startTime < 600'000)
+    {
+      juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+    }
+    metadataCache.saveToFile(cacheFile);
+    double milliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+    importer.setListener(nullptr);
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("files", listener.progress.filesDone);
+    result->setProperty("filesFromCache", listener.progress.filesFromCache);
+    result->setProperty("milliseconds", milliseconds);
+    result->setProperty("cacheLoadMilliseconds", cacheLoadMilliseconds);
+    result->setProperty("cacheFileBytes", cacheFile.getSize());
+    result->setProperty("finished", listener.finished);
+    results->setProperty(runName, result.get());
+  }
+
+  return results.get();
+}
+
+juce::var EngineBenchmarks::runLibraryFile()
+{
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+  juce::File textLibrary = options.workingDirectory.getChildFile("library.txt");
+  juce::File binaryLibrary = options.workingDirectory.getChildFile("library.otolib");
+
+  // Where a loaded library's tracks go, the same way as PlaylistComponent::addTrack()
+  struct Library
+  {
+    void addTrack(const juce::String& fileURL, const juce::String& fileTitle, double fileDuration, double sampleRate, int numChannels, juce::int64 dateAdded = 0)
+    {
+      TrackStore::TrackId trackId = trackStore.add(fileURL, fileTitle, fileDuration, sampleRate, numChannels, dateAdded);
+      librarySearch.addTitle(fileTitle);
+      librarySort.trackAdded(trackId);
+    }
+
+    TrackStore trackStore;
+    LibrarySearch librarySearch;
+    LibrarySort librarySort{ trackStore };
+  };
+
+  // Both formats are timed from opening the file until every track is in the library and sorted (as PlaylistComponent::importFinished()
+  // and readIncomingBinaryLibraryAndUpdateTable() leave it), in milliseconds
+  auto timeLoads = [&textLibrary, &binaryLibrary](std::function<void(Library&)> loadText) -> juce::var
+  {
+    auto textLoaded = std::make_unique<Library>();
+    double startTime = juce::Time::getMillisecondCounterHiRes();
+    loadText(*textLoaded);
+    textLoaded->librarySort.prepareAll();
+    double textMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    auto binaryLoaded = std::make_unique<Library>();
+    std::vector<LibraryFile::Track> tracks;
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    bool binaryRead = LibraryFile::read(binaryLibrary, tracks);
+    for (const LibraryFile::Track& track : tracks) binaryLoaded->addTrack(track.fileURL, track.fileTitle, track.fileDuration, track.sampleRate, track.numChannels, track.dateAdded);
+    binaryLoaded->librarySort.prepareAll();
+    double binaryMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("txtTracks", textLoaded->trackStore.getNumTracks());
+    result->setProperty("txtMilliseconds", textMilliseconds);
+    result->setProperty("txtBytes", textLibrary.getSize());
+    result->setProperty("otolibTracks", binaryRead ? binaryLoaded->trackStore.getNumTracks() : 0);
+    result->setProperty("otolibMilliseconds", binaryMilliseconds);
+    result->setProperty("otolibBytes", binaryLibrary.getSize());
+    result->setProperty("speedup", binaryMilliseconds > 0 ? textMilliseconds / binaryMilliseconds : 0.0);
+    return result.get();
+  };
+
+  // ----- The import benchmark's files (as PlaylistComponent loads each format) ----- //
+  juce::StringArray filePaths = getLibraryFilePaths();
+  if (!filePaths.isEmpty())
+  {
+    // Tracks are added as each batch arrives, as PlaylistComponent::importBatchReady() does
+    struct ImportListener : public LibraryImporter::Listener
+    {
+      ImportListener(Library& _library) : library(_library) {}
+
+      void importBatchReady(const std::vector<LibraryImporter::ImportedTrack>& batch) override
+      {
+        for (const LibraryImporter::ImportedTrack& track : batch)
+        {
+          if (track.fileExists) library.addTrack(track.fileURL, track.fileTitle, track.fileDuration, track.sampleRate, track.numChannels);
+        }
+      }
+      void importProgressChanged(const LibraryImporter::Progress&) override {}
+      void importFinished(const LibraryImporter::Progress&, const juce::StringArray&, bool) override { finished = true; }
+
+      Library& library;
+      bool finished = false;
+    };
+
+    TrackMetadataCache metadataCache;
+    LibraryImporter importer{ formatManager, metadataCache };
+    auto importTextLibrary = [&importer, &textLibrary](Library& library)
+    {
+      ImportListener listener{ library };
+      importer.setListener(&listener);
+
+      juce::FileInputStream fileInputStream(textLibrary);
+      juce::StringArray incomingFiles;
+      while (fileInputStream.openedOk() && !fileInputStream.isExhausted())
+      {
+        juce::String line = fileInputStream.readNextLine().trim();
+        if (line.isNotEmpty()) incomingFiles.add(line);
+      }
+      importer.importFiles(incomingFiles);
+
+      double startTime = juce::Time::getMillisecondCounterHiRes();
+      while (!listener.finished && juce::Time::getMillisecondCounterHiRes() - startTime < 120'000)
+      {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(1);
+      }
+      importer.setListener(nullptr);
+    };
+
+    // Imported once so TrackMetadataCache is filled (as it would be on a second start), and saved in both formats
+    textLibrary.replaceWithText(filePaths.joinIntoString("\n") + "\n");
+    {
+      Library library;
+      importTextLibrary(library);
+
+      std::vector<LibraryFile::Track> tracks;
+      for (TrackStore::TrackId trackId : library.trackStore.getTrackIds())
+      {
+        const TrackStore& trackStore = library.trackStore;
+        tracks.push_back({ trackStore.getURL(trackId), trackStore.getTitle(trackId), trackStore.getDuration(trackId), trackStore.getSampleRate(trackId), trackStore.getNumChannels(trackId), trackStore.getDateAdded(trackId) });
+      }
+      LibraryFile::write(binaryLibrary, tracks);
+    }
+
+    results->setProperty("files", timeLoads(importTextLibrary));
+  }
+
+  // ----- A generated library too big to import (the .txt is only read, and each file checked) ----- //
+  {
+    std::vector<LibraryFile::Track> tracks(static_cast<size_t>(options.numLibraryFileTracks));
+    juce::String text;
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+      juce::String title = "Track " + juce::String(static_cast<int>(i)).paddedLeft('0', 6);
+      tracks[i] = { "/Music/Library/" + title + ".wav", title, 60.0 + static_cast<double>((i * 7'919) % 540), 44'100.0, 2 };
+      text << tracks[i].fileURL << "\n";
+    }
+    textLibrary.replaceWithText(text);
+    LibraryFile::write(binaryLibrary, tracks);
+
+    results->setProperty("generated", timeLoads([&textLibrary](Library& library)
+    {
+      juce::FileInputStream fileInputStream(textLibrary);
+      while (fileInputStream.openedOk() && !fileInputStream.isExhausted())
+      {
+        juce::String incomingFile = fileInputStream.readNextLine().trim();
+        if (incomingFile.isEmpty()) continue;
+
+        // As LibraryImporter does for each file (none of them exist, so this is the cheapest the check can be), then added with the title
+        // it would give the track (its duration would need the file decoding, so it is left unknown)
+        juce::File file(incomingFile);
+        file.existsAsFile();
+        library.addTrack(incomingFile, file.getFileNameWithoutExtension(), 0.0, 0.0, 0);
+      }
+    }));
+  }
+
+  textLibrary.deleteFile();
+  binaryLibrary.deleteFile();
+  return results.get();
+}
+
+juce::var EngineBenchmarks::runLoad()
+{
+  juce::File track = getTestWavFile();
+  juce::File peakFolder = options.workingDirectory.getChildFile("load").getChildFile("peak-cache");
+  peakFolder.deleteRecursively();
+
+  juce::TimeSliceThread readAheadThread{ "Benchmark read-ahead" };
+  readAheadThread.startThread();
+
+  // Cold has no peak file yet, warm has the one the cold load left behind
+  juce::Array<juce::var> results;
+  const bool intoRamModes[] = { false, true };
+  const char* runNames[] = { "cold", "warm" };
+
+  for (bool intoRam : intoRamModes)
+  {
+    for (const char* runName : runNames)
+    {
+      if (juce::String(runName) == "cold") peakFolder.deleteRecursively();
+
+      // Nothing decoded in RAM yet, as after starting the app
+      DecodedTrackCache decodedTrackCache;
+      PeakFileStore peakFileStore{ formatManager, peakFolder };
+      DJAudioPlayer player{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+      player.setLoadIntoRam(intoRam);
+
+      // The same order as DeckGUI: the deck loads, then both waveform views ask for the peaks
+      double loadMilliseconds = -1.0;
+      double waveformMilliseconds = -1.0;
+      juce::int64 startBytes = TrackAnalyser::getTotalBytesRead();
+      double startTime = juce::Time::getMillisecondCounterHiRes();
+
+      player.loadURLAsync(juce::URL{ track }, [&](bool loaded)
+        {
+          loadMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+          if (!loaded) return;
+
+          for (int view = 0; view < 2; ++view)
+          {
+            peakFileStore.requestPeaks(track, [&](std::shared_ptr<const PeakFile> peaks)
+              {
+                if (peaks != nullptr && waveformMilliseconds < 0) waveformMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+              });
+          }
+        });
+
+      // Also waits for a streamed deck's background pass to finish (it switches the deck over to RAM), so every byte it reads is counted
+      auto isFinished = [&]()
+        {
+          if (loadMilliseconds < 0 || waveformMilliseconds < 0) return false;
+          return intoRam || juce::String(runName) == "warm" || player.isLoadedIntoRam();
+        };
+      while (!isFinished() && juce::Time::getMillisecondCounterHiRes() - startTime < 60'000)
+      {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(1);
+      }
+      double finishedMilliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+      juce::int64 bytesRead = TrackAnalyser::getTotalBytesRead() - startBytes;
+
+      juce::DynamicObject::Ptr result = new juce::DynamicObject();
+      result->setProperty("mode", intoRam ? "ram" : "streaming");
+      result->setProperty("run", runName);
+      result->setProperty("loadMilliseconds", loadMilliseconds);
+      result->setProperty("firstWaveformMilliseconds", waveformMilliseconds);
+      result->setProperty("finishedMilliseconds", finishedMilliseconds);
+      result->setProperty("bytesRead", bytesRead);
+      result->setProperty("fileBytes", track.getSize());
+      result->setProperty("timesFileRead", track.getSize() > 0 ? bytesRead / static_cast<double>(track.getSize()) : 0.0);
+      result->setProperty("finished", isFinished());
+      results.add(result.get());
+    }
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runWaveform()
+{
+  // A 5 minute track, and its peak file built the same way PeakFileStore does
+  juce::File folder = options.workingDirectory.getChildFile("waveform");
+  juce::File track = folder.getChildFile("long.wav");
+  juce::File peakFile = folder.getChildFile("long.otpk");
+  juce::WavAudioFormat wavFormat;
+  if (!track.existsAsFile() && !writeTestTrack(wavFormat, track, 300.0)) return {};
+
+  TrackAnalyser::Stats stats;
+  std::unique_ptr<juce::AudioFormatReader> reader = TrackAnalyser::createReader(formatManager, track, stats);
+  if (reader == nullptr) return {};
+  PeakFileBuilder peakFileBuilder(peakFile);
+  if (!TrackAnalyser::run(*reader, { &peakFileBuilder }, []() { return false; }, stats)) return {};
+
+  PeakFile peaks;
+  if (!peaks.open(peakFile)) return {};
+
+  // Same colours and playhead as WaveformDisplay, at a typical deck's size and at twice its pixel density
+  const juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
+  const juce::Colour incomingColour = juce::Colours::orange;
+  const float lineThickness = 2.0f;
+  const int numFrames = 200;
+  const juce::Point<int> sizes[] = { { 1'000, 100 }, { 2'000, 200 } };
+
+  juce::Array<juce::var> results;
+  for (juce::Point<int> size : sizes)
+  {
+    juce::Rectangle<int> bounds(0, 0, size.x, size.y);
+    juce::Image frame(juce::Image::RGB, size.x, size.y, false);
+
+    auto drawPlayhead = [&](juce::Graphics& g, double position)
+      {
+        g.setColour(juce::Colours::white);
+        g.fillRect((position * size.x) - (lineThickness / 2.0f), 0.0f, lineThickness, static_cast<float>(size.y));
+      };
+    auto getPlayheadBounds = [&](double position)
+      {
+        int x = static_cast<int>(std::floor((position * size.x) - (lineThickness / 2.0f))) - 1;
+        return juce::Rectangle<int>(x, 0, static_cast<int>(std::ceil(lineThickness)) + 2, size.y);
+      };
+
+    // The playhead moves a little every frame, as it does while playing
+    auto timeFrames = [&](std::function<void(double previousPosition, double position)> paintFrame)
+      {
+        juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+        for (int i = 1; i <= numFrames; ++i) paintFrame((i - 1) / static_cast<double>(numFrames), i / static_cast<double>(numFrames));
+        return (juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6) / numFrames;
+      };
+
+    // Every frame draws the whole track's waveform
+    double fullMicroseconds = timeFrames([&](double, double position)
+      {
+        juce::Graphics g(frame);
+        g.fillAll(myBlack);
+        peaks.drawChannel(g, bounds, 0, peaks.getLengthInSeconds(), 0, incomingColour.darker(), incomingColour);
+        drawPlayhead(g, position);
+      });
+
+    // The waveform is drawn once, then every frame copies it
+    juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+    juce::Image cachedWaveform(juce::Image::RGB, size.x, size.y, false);
+    {
+      juce::Graphics imageGraphics(cachedWaveform);
+      imageGraphics.fillAll(myBlack);
+      peaks.drawChannel(imageGraphics, bounds, 0, peaks.getLengthInSeconds(), 0, incomingColour.darker(), incomingColour);
+    }
+    double cacheMicroseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+
+    double cachedMicroseconds = timeFrames([&](double, double position)
+      {
+        juce::Graphics g(frame);
+        g.drawImage(cachedWaveform, bounds.toFloat());
+        drawPlayhead(g, position);
+      });
+
+    // Only the strips under the old and new playhead are repainted (what WaveformDisplay::setPositionRelative() asks for)
+    double stripMicroseconds = timeFrames([&](double previousPosition, double position)
+      {
+        juce::RectangleList<int> dirty(getPlayheadBounds(previousPosition));
+        dirty.add(getPlayheadBounds(position));
+
+        juce::Graphics g(frame);
+        g.reduceClipRegion(dirty);
+        g.drawImage(cachedWaveform, bounds.toFloat());
+        drawPlayhead(g, position);
+      });
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("width", size.x);
+    result->setProperty("height", size.y);
+    result->setProperty("trackSeconds", peaks.getLengthInSeconds());
+    result->setProperty("fullRedrawMicrosecondsPerFrame", fullMicroseconds);
+    result->setProperty("cacheMicroseconds", cacheMicroseconds);
+    result->setProperty("cachedMicrosecondsPerFrame", cachedMicroseconds);
+    result->setProperty("playheadStripMicrosecondsPerFrame", stripMicroseconds);
+    result->setProperty("speedup", stripMicroseconds > 0 ? fullMicroseconds / stripMicroseconds : 0.0);
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+juce::var EngineBenchmarks::runTable()
+{
+  // A library of 'numLibraryFileTracks' generated tracks, added the same way as PlaylistComponent::importBatchReady()
+  TrackStore trackStore;
+  for (int i = 0; i < options.numLibraryFileTracks; ++i)
+  {
+    juce::String title = "Artist " + juce::String(i % 997) + " - Track " + juce::String(i);
+    trackStore.add("/Music/Library/" + title + ".wav", title, 60.0 + static_cast<double>((i * 7'919) % 540));
+  }
+  const std::vector<TrackStore::TrackId>& trackIds = trackStore.getTrackIds();
+  if (trackIds.empty()) return {};
+  const int numRows = static_cast<int>(trackIds.size());
+
+  // Every column shown, with the widths PlaylistComponent::resized() gives them, for two decks in a 1000x600 table
+  const juce::Array<juce::Colour> deckColours{ juce::Colours::orange, juce::Colours::cyan };
+  const int width = 1'000;
+  const int height = 600;
+  const int rowHeight = 22; // juce::ListBox's default
+  const double widthPart = width / 6.0;
+  const std::pair<int, double> columns[] = { { LibraryCellPainter::titleColumnId, widthPart * 1.25 }, { LibraryCellPainter::pathColumnId, widthPart * 0.75 },
+                                             { LibraryCellPainter::durationColumnId, widthPart * 0.5 }, { LibraryCellPainter::addedColumnId, widthPart * 0.5 },
+                                             { LibraryCellPainter::firstLoadColumnId, widthPart * 1.25 }, { LibraryCellPainter::firstLoadColumnId + 1, widthPart * 1.25 },
+                                             { LibraryCellPainter::removeColumnId, (widthPart / 2) - 10 } };
+  const int numVisibleRows = (height / rowHeight) + 1;
+  const int numFrames = 600;
+  juce::Image frame(juce::Image::RGB, width, height, false);
+
+  // Paints 'numFrames' frames, scrolling 'rowsPerFrame' rows each time, with a new LibraryCellPainter (so nothing is cached from an earlier run)
+  // Every allocation in the frame is counted, including juce::Graphics' own when each row and cell is clipped (as juce::TableListBox does)
+  // 'paintCell' is null to only clip, so what the clipping allocates can be told apart from what painting the cells does
+  using PaintCell = std::function<void(LibraryCellPainter& cellPainter, juce::Graphics& g, TrackStore::TrackId trackId, int columnId, int columnWidth)>;
+  auto timeFrames = [&](int rowsPerFrame, PaintCell paintCell)
+    {
+      LibraryCellPainter cellPainter{ trackStore };
+      cellPainter.setDeckColours(deckColours);
+
+      juce::Graphics g(frame);
+      juce::int64 allocationsBefore = numHeapAllocations;
+      juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+      for (int i = 0; i < numFrames; ++i)
+      {
+        int firstRow = (i * rowsPerFrame) % numRows;
+        for (int row = firstRow; row < juce::jmin(firstRow + numVisibleRows, numRows); ++row)
+        {
+          juce::Graphics::ScopedSaveState rowState(g);
+          g.setOrigin(0, (row - firstRow) * rowHeight);
+          g.reduceClipRegion(0, 0, width, rowHeight);
+          if (paintCell) cellPainter.paintRowBackground(g, row, width, rowHeight, false);
+
+          int x = 0;
+          for (auto [columnId, columnWidth] : columns)
+          {
+            juce::Graphics::ScopedSaveState cellState(g);
+            g.reduceClipRegion(x, 0, static_cast<int>(columnWidth), rowHeight);
+            g.setOrigin(x, 0);
+            if (paintCell) paintCell(cellPainter, g, trackIds[static_cast<size_t>(row)], columnId, static_cast<int>(columnWidth));
+            x += static_cast<int>(columnWidth);
+          }
+        }
+      }
+      double microseconds = (juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6) / numFrames;
+      return std::make_pair(microseconds, static_cast<double>(numHeapAllocations - allocationsBefore) / numFrames);
+    };
+
+  // What the table does now: cells draw the strings formatted when each track was added, with each column's text laid out once
+  PaintCell paintStored = [](LibraryCellPainter& cellPainter, juce::Graphics& g, TrackStore::TrackId trackId, int columnId, int columnWidth)
+    {
+      cellPainter.paintCell(g, trackId, columnId, columnWidth, rowHeight);
+    };
+
+  // What it used to do: the duration formatted again, and every cell's text laid out again, on every paint
+  PaintCell paintFormatted = [&trackStore](LibraryCellPainter& cellPainter, juce::Graphics& g, TrackStore::TrackId trackId, int columnId, int columnWidth)
+    {
+      g.setColour(juce::Colours::white);
+      if (columnId == LibraryCellPainter::durationColumnId) g.drawText(TrackStore::formatDuration(trackStore.getDuration(trackId)), 2, 0, columnWidth - 4, rowHeight, juce::Justification::centredLeft, true);
+      else g.drawText(cellPainter.getCellText(trackId, columnId), 2, 0, columnWidth - 4, rowHeight, juce::Justification::centredLeft, true);
+    };
+
+  // Scrolling a row a frame (dragging the scrollbar or turning the mouse wheel), and the whole library in 'numFrames' frames (so no frame shares a row with the last)
+  const std::pair<const char*, int> scrollSpeeds[] = { { "rowPerFrame", 1 }, { "wholeLibrary", juce::jmax(1, numRows / numFrames) } };
+
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+  results->setProperty("numTracks", numRows);
+  results->setProperty("width", width);
+  results->setProperty("height", height);
+  results->setProperty("rowsPerFrame", numVisibleRows);
+
+  for (auto [name, rowsPerFrame] : scrollSpeeds)
+  {
+    auto [microseconds, allocations] = timeFrames(rowsPerFrame, paintStored);
+    auto [clipMicroseconds, clipAllocations] = timeFrames(rowsPerFrame, nullptr);
+    auto [formattedMicroseconds, formattedAllocations] = timeFrames(rowsPerFrame, paintFormatted);
+
+    // A 60Hz display leaves 16.7ms for each frame, and a 120Hz one 8.3ms
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("scrolledRowsPerFrame", rowsPerFrame);
+    result->setProperty("microsecondsPerFrame", microseconds);
+    result->setProperty("framesPerSecond", microseconds > 0 ? 1.0e6 / microseconds : 0.0);
+    result->setProperty("shareOf60HzFrame", microseconds / (1.0e6 / 60.0));
+    result->setProperty("shareOf120HzFrame", microseconds / (1.0e6 / 120.0));
+    result->setProperty("heapAllocationsPerFrame", allocations);
+    result->setProperty("clippingHeapAllocationsPerFrame", clipAllocations);
+    result->setProperty("paintingHeapAllocationsPerFrame", allocations - clipAllocations);
+    result->setProperty("formattedOnPaintMicrosecondsPerFrame", formattedMicroseconds);
+    result->setProperty("formattedOnPaintHeapAllocationsPerFrame", formattedAllocations);
+    results->setProperty(name, result.get());
+  }
+
+  return results.get();
+}
+
+juce::var EngineBenchmarks::runSearch()
+{
+  // Generated titles, the same every run
+  const char* words[] = { "Midnight", "Echo", "Sunrise", "Bass", "Dream", "City", "Lights", "Remix", "Original", "Mix", "Feat", "Love",
+                          "Drive", "Ocean", "Fire", "Groove", "Deep", "House", "Night", "Summer", "Electric", "Soul", "Rain", "Vibes" };
+  const int numWords = static_cast<int>(std::size(words));
+
+  juce::Array<juce::var> results;
+  const int queriesPerSize = 50;
+  const int maxQueryLength = 12;
+  const int linearQueriesPerSize = 5; // Checking every title is slow enough with a big library that fewer queries are timed
+
+  for (int numTitles : options.searchLibrarySizes)
+  {
+    juce::Random random(42);
+    std::vector<std::string> titles;
+    titles.reserve(static_cast<size_t>(numTitles));
+    for (int i = 0; i < numTitles; ++i)
+    {
+      juce::String title;
+      int numTitleWords = 2 + random.nextInt(4);
+      for (int word = 0; word < numTitleWords; ++word) title << words[random.nextInt(numWords)] << " ";
+      title << juce::String(i);
+      titles.push_back(title.toStdString());
+    }
+
+    // Added the same way as PlaylistComponent::importBatchReady() (with durations from 1 to 10 minutes)
+    TrackStore trackStore;
+    LibrarySearch librarySearch;
+    LibrarySort librarySort{ trackStore };
+    juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+    for (size_t i = 0; i < titles.size(); ++i)
+    {
+      TrackStore::TrackId trackId = trackStore.add("/Music/Library/" + titles[i] + ".wav", titles[i], 60.0 + static_cast<double>((i * 7'919) % 540));
+      librarySearch.addTitle(titles[i]);
+      librarySort.trackAdded(trackId);
+    }
+    double addSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    double storeBytesPerTrack = static_cast<double>(trackStore.getMemoryUsage()) / numTitles;
+    double indexBytesPerTrack = static_cast<double>(librarySearch.getMemoryUsage()) / numTitles;
+
+    // Every column sorted once (as when an import finishes), then switching between them (as when a header is clicked)
+    startTicks = juce::Time::getHighResolutionTicks();
+    librarySort.prepareAll();
+    double sortSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    startTicks = juce::Time::getHighResolutionTicks();
+    size_t numSorted = 0;
+    for (int key = 0; key < LibrarySort::numKeys; ++key) numSorted += librarySort.getOrder(static_cast<LibrarySort::Key>(key)).size();
+    double switchSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) / LibrarySort::numKeys;
+    jassert(numSorted == titles.size() * LibrarySort::numKeys);
+
+    // Latencies by how many letters have been typed so far (queries are cut from random titles, so most of them match something)
+    std::vector<std::vector<double>> latencies(maxQueryLength);
+    std::vector<std::vector<double>> linearLatencies(maxQueryLength);
+    std::vector<std::vector<double>> sortLatencies(maxQueryLength);
+    std::vector<double> totalMatches(maxQueryLength, 0.0);
+    std::vector<size_t> linearMatches;
+    std::vector<TrackStore::TrackId> sortedMatches;
+
+    for (int i = 0; i < queriesPerSize; ++i)
+    {
+      juce::String title(titles[static_cast<size_t>(random.nextInt(numTitles))]);
+      int start = random.nextInt(juce::jmax(1, title.length() - maxQueryLength));
+      juce::String query = title.substring(start, start + maxQueryLength).toLowerCase();
+
+      for (int length = 1; length <= query.length(); ++length)
+      {
+        juce::String typed = query.substring(0, length);
+
+        startTicks = juce::Time::getHighResolutionTicks();
+        const std::vector<size_t>& matches = librarySearch.findMatches(typed);
+        latencies[length - 1].push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+        totalMatches[length - 1] += static_cast<double>(matches.size());
+
+        // Matches put in title order, the same way as PlaylistComponent::updateSortedMatches()
+        startTicks = juce::Time::getHighResolutionTicks();
+        sortedMatches.clear();
+        for (size_t match : matches) sortedMatches.push_back(static_cast<TrackStore::TrackId>(match));
+        librarySort.sortIds(LibrarySort::Key::title, sortedMatches);
+        sortLatencies[length - 1].push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+
+        // What PlaylistComponent used to do on every keystroke
+        if (i < linearQueriesPerSize)
+        {
+          startTicks = juce::Time::getHighResolutionTicks();
+          linearMatches.clear();
+          for (size_t titleIndex = 0; titleIndex < titles.size(); ++titleIndex)
+          {
+            if (juce::String(titles[titleIndex]).containsIgnoreCase(typed)) linearMatches.push_back(titleIndex);
+          }
+          linearLatencies[length - 1].push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+          jassert(linearMatches == matches);
+        }
+      }
+
+      // Search box cleared before the next query is typed
+      librarySearch.findMatches({});
+    }
+
+    juce::Array<juce::var> byQueryLength;
+    for (int length = 1; length <= maxQueryLength; ++length)
+    {
+      std::vector<double>& lengthLatencies = latencies[length - 1];
+      std::vector<double>& lengthLinearLatencies = linearLatencies[length - 1];
+      std::vector<double>& lengthSortLatencies = sortLatencies[length - 1];
+      if (lengthLatencies.empty()) continue;
+      std::sort(lengthLatencies.begin(), lengthLatencies.end());
+      std::sort(lengthLinearLatencies.begin(), lengthLinearLatencies.end());
+      std::sort(lengthSortLatencies.begin(), lengthSortLatencies.end());
+
+      juce::DynamicObject::Ptr result = new juce::DynamicObject();
+      result->setProperty("queryLength", length);
+      result->setProperty("medianMicroseconds", lengthLatencies[lengthLatencies.size() / 2]);
+      result->setProperty("maxMicroseconds", lengthLatencies.back());
+      result->setProperty("averageMatches", totalMatches[length - 1] / static_cast<double>(lengthLatencies.size()));
+      result->setProperty("sortMatchesMedianMicroseconds", lengthSortLatencies[lengthSortLatencies.size() / 2]);
+      if (!lengthLinearLatencies.empty()) result->setProperty("linearMedianMicroseconds", lengthLinearLatencies[lengthLinearLatencies.size() / 2]);
+      byQueryLength.add(result.get());
+    }
+
+    // Removing tracks (from anywhere in the library) once searching is done, the same way as PlaylistComponent's 'Remove' buttons
+    const int numRemoved = 100;
+    startTicks = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numRemoved; ++i)
+    {
+      TrackStore::TrackId trackId = static_cast<TrackStore::TrackId>(random.nextInt(numTitles));
+      trackStore.remove(trackId);
+      librarySearch.removeTitle(trackId);
+      librarySort.trackRemoved(trackId);
+    }
+    double removeSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    // Another import's worth of tracks merged into the title order (instead of sorting every track again)
+    const int numAdded = 1'000;
+    for (int i = 0; i < numAdded; ++i)
+    {
+      const std::string& title = titles[static_cast<size_t>(random.nextInt(numTitles))];
+      librarySort.trackAdded(trackStore.add("/Music/New/" + title + ".wav", title, 180.0));
+    }
+    startTicks = juce::Time::getHighResolutionTicks();
+    librarySort.getOrder(LibrarySort::Key::title);
+    double mergeSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    result->setProperty("titles", numTitles);
+    result->setProperty("addMicrosecondsPerTrack", (addSeconds * 1.0e6) / numTitles);
+    result->setProperty("removeMicrosecondsPerTrack", (removeSeconds * 1.0e6) / numRemoved);
+    result->setProperty("storeBytesPerTrack", storeBytesPerTrack);
+    result->setProperty("indexBytesPerTrack", indexBytesPerTrack);
+    result->setProperty("sortAllColumnsMilliseconds", sortSeconds * 1.0e3);
+    result->setProperty("switchSortMicroseconds", switchSeconds * 1.0e6);
+    result->setProperty("mergeAddedMilliseconds", mergeSeconds * 1.0e3);
+    result->setProperty("mergeAddedTracks", numAdded);
+    result->setProperty("byQueryLength", byQueryLength);
+    results.add(result.get());
+  }
+
+  return results;
+}
+
+bool EngineBenchmarks::writeTestTrack(juce::AudioFormat& format, const juce::File& file, double seconds)
+{
+  if (!format.canDoStereo() || !format.getPossibleBitDepths().contains(16)) return false;
+
+  file.getParentDirectory().createDirectory();
+  file.deleteFile();
+  std::unique_ptr<juce::FileOutputStream> outputStream = file.createOutputStream();
+  if (outputStream == nullptr) return false;
+
+  const double sampleRate = 44'100;
+  std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(outputStream.get(), sampleRate, 2, 16, {}, 0));
+  if (writer == nullptr)
+  {
+    // Formats that can only be read (eg. MP3)
+    outputStream.reset();
+    file.deleteFile();
+    return false;
+  }
+  outputStream.release(); // Now owned by 'writer'
+
+  // Sweep from 40Hz to 4kHz, with quiet noise on top (so lossy and lossless formats both have real work to do)
+  juce::Random random(1);
+  juce::AudioBuffer<float> buffer(2, 4'096);
+  juce::int64 totalSamples = static_cast<juce::int64>(seconds * sampleRate);
+  double phase = 0.0;
+  for (juce::int64 position = 0; position < totalSamples; position += buffer.getNumSamples())
+  {
+    int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(buffer.getNumSamples()), totalSamples - position));
+    for (int i = 0; i < numSamples; ++i)
+    {
+      double frequency = 40.0 * std::pow(100.0, static_cast<double>(position + i) / static_cast<double>(totalSamples));
+      phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+      float sample = 0.5f * static_cast<float>(std::sin(phase));
+      buffer.setSample(0, i, sample + (random.nextFloat() - 0.5f) * 0.05f);
+      buffer.setSample(1, i, sample + (random.nextFloat() - 0.5f) * 0.05f);
+    }
+
+    if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples)) return false;
+  }
+
+  return true;
+}
+
+juce::File EngineBenchmarks::getTestWavFile()
+{
+  if (testWavFile == juce::File())
+  {
+    juce::WavAudioFormat wavFormat;
+    testWavFile = options.workingDirectory.getChildFile("deck").getChildFile("test.wav");
+    writeTestTrack(wavFormat, testWavFile, options.secondsOfAudio);
+  }
+
+  return testWavFile;
+}
+
+juce::StringArray EngineBenchmarks::getLibraryFilePaths()
+{
+  juce::File libraryFolder = options.workingDirectory.getChildFile("library");
+  juce::WavAudioFormat wavFormat;
+  juce::StringArray filePaths;
+  for (int i = 0; i < options.numLibraryFiles; ++i)
+  {
+    juce::File file = libraryFolder.getChildFile("track" + juce::String(i).paddedLeft('0', 5) + ".wav");
+    if (!file.existsAsFile() && !writeTestTrack(wavFormat, file, 0.05)) return {}; // Only their headers are read, so they are kept short
+    filePaths.add(file.getFullPathName());
+  }
+
+  return filePaths;
+}
+
+int EngineBenchmarks::runFromCommandLine(const juce::StringArray& arguments)
+{
+  Options benchmarkOptions;
+  benchmarkOptions.workingDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OtoDecks-benchmarks");
+  juce::File jsonFile;
+
+  for (int i = arguments.indexOf("--bench") + 1; i < arguments.size(); ++i)
+  {
+    juce::String argument = arguments[i].unquoted();
+    bool hasValue = i + 1 < arguments.size();
+
+    if (argument == "--json" && hasValue) jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[++i].unquoted());
+    else if (argument == "--dir" && hasValue) benchmarkOptions.workingDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[++i].unquoted());
+    else if (argument == "--seconds" && hasValue) benchmarkOptions.secondsOfAudio = juce::jmax(1.0, arguments[++i].getDoubleValue());
+    else if (argument == "--files" && hasValue) benchmarkOptions.numLibraryFiles = juce::jmax(1, arguments[++i].getIntValue());
+    else if (argument.startsWith("--"))
+    {
+      std::cerr << "Usage: --bench [--json <file>] [--dir <folder>] [--seconds <n>] [--files <n>] [extra audio files...]" << std::endl;
+      return 1;
+    }
+    else benchmarkOptions.extraFiles.add(juce::File::getCurrentWorkingDirectory().getChildFile(argument));
+  }
+
+  EngineBenchmarks benchmarks(benchmarkOptions);
+  juce::String json = juce::JSON::toString(benchmarks.runAll());
+
+  // Printed if no file was given
+  if (jsonFile == juce::File()) std::cout << json << std::endl;
+  else if (!jsonFile.replaceWithText(json))
+  {
+    std::cerr << "Unable to write " << jsonFile.getFullPathName() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <JuceHeader.h>
+
+/*
+Times the audio engine and library code without a GUI, and reports the results as JSON (so runs can be compared for regressions).
+1. decode: MB/s and times real time for each format that can be written (using a generated track), plus any extra files given
+2. deck: cost of DJAudioPlayer::getNextAudioBlock() for each block size and tempo mode, in ns per sample and share of real time
+3. mixer: cost of mixing 1, 2, 4 and 8 decks with DeckMixerAudioSource, next to juce::MixerAudioSource doing the same, how much of it is the mixing itself
+   (over the decks rendering on their own), and each deck's cost next to a lone deck's (so how linearly the cost grows with the number of decks)
+4. capacity: most key lock decks that can be mixed without a block taking longer than it lasts (an xrun), at 64, 128 and 256 sample blocks, on 1 to 4 cores
+   (plus equaliser: EqualiserAudioSource's fused filters with SSE and with plain loops, next to the 3 chained juce::IIRFilterAudioSource it replaced, in ns per sample)
+5. master: cost of the master bus' LookAheadLimiter and LevelMeter for each block size (on a mix loud enough to be limited), and the latency the limiter adds
+6. import: files/sec for LibraryImporter, first with an empty TrackMetadataCache, then with it filled
+   (plus startup: the same library loaded the way PlaylistComponent does at startup, cold with no cache file, then warm from the one the cold start saved)
+7. search: latency of LibrarySearch per keystroke (a query typed a letter at a time) over generated libraries of 10k, 100k and 1M titles, next to checking every title with juce::String::containsIgnoreCase()
+   (plus, for each library, the TrackStore and search index's memory per track, how long adding and removing a track takes,
+   and how long LibrarySort takes to sort every column, switch between them, put each keystroke's matches in order and merge in new tracks)
+8. libraryFile: time to load a library saved as .txt (read a line at a time, then imported) next to the same library saved as .otolib (memory mapped),
+   both until every track is in a TrackStore, LibrarySearch and LibrarySort and every column is sorted (as the table has it once loaded),
+   for the import benchmark's files and for a generated library of 100k tracks (where the .txt's files are only checked to exist, not decoded)
+9. load: time from asking a deck to load a track (streamed or into RAM, with and without a peak file already built) until it can play, and until its
+   first waveform is ready (as DeckGUI loads them), plus how many bytes were read from the file meanwhile (so a second decode shows up as twice the file's size)
+10. waveform: time to paint WaveformDisplay's overview of a long track into an offscreen image, drawing the whole waveform every frame (as it used to),
+   copying it from the cached image, and repainting only the playhead's strips (as moving the playhead now does)
+11. table: time and heap allocations per frame to paint the library table's visible rows into an offscreen image while scrolling through 'numLibraryFileTracks' tracks,
+   a row a frame and the whole library in 600 frames, next to formatting each duration and laying out each cell's text again on every paint (as it used to)
+   (every allocation is counted, with what clipping each row and cell takes, as juce::TableListBox does, also given on its own)
+*/
+class EngineBenchmarks
+{
+public:
+  struct Options
+  {
+    juce::File workingDirectory; // Generated tracks and caches go here
+    juce::Array<juce::File> extraFiles; // Also decoded (eg. MP3s, which cannot be generated)
+    double secondsOfAudio = 30.0;
+    int numLibraryFiles = 10'000; // Tracks in the import, startup and libraryFile benchmarks' library
+    juce::Array<int> searchLibrarySizes{ 10'000, 100'000, 1'000'000 };
+    int numLibraryFileTracks = 100'000; // Also the table benchmark's library
+  };
+
+  EngineBenchmarks(Options _options);
+  ~EngineBenchmarks();
+
+  // Every benchmark, along with details of the machine they ran on
+  juce::var runAll();
+
+  juce::var runDecode();
+  juce::var runDeck();
+  juce::var runMixer();
+  juce::var runCapacity();
+  juce::var runEqualiser();
+  juce::var runMaster();
+  juce::var runImport();
+  juce::var runStartup();
+  juce::var runSearch();
+  juce::var runLibraryFile();
+  juce::var runLoad();
+  juce::var runWaveform();
+  juce::var runTable();
+
+  // Handles "--bench [--json <file>] [--dir <folder>] [--seconds <n>] [--files <n>] [extra audio files...]", returns the process' exit code
+  static int runFromCommandLine(const juce::StringArray& arguments);
+
+private:
+  // Stereo 44.1kHz test signal (a sweep with some noise), returns false if 'format' cannot write it
+  bool writeTestTrack(juce::AudioFormat& format, const juce::File& file, double seconds);
+
+  // Generated WAV the deck and import benchmarks play (written on first use)
+  juce::File getTestWavFile();
+
+  // Short copies of the test track under different names for the import benchmarks (written on first use), empty if they could not be written
+  juce::StringArray getLibraryFilePaths();
+
+  Options options;
+  juce::AudioFormatManager formatManager;
+  juce::File testWavFile;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EngineBenchmarks)
+};
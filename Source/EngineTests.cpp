@@ -0,0 +1,439 @@
+#include <JuceHeader.h>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "EngineTests.h"
+#include "OfflineRenderer.h"
+#include "DJAudioPlayer.h"
+#include "DeckRenderPool.h"
+
+int EngineTests::runFromCommandLine(const juce::StringArray& arguments)
+{
+  getWorkingDirectory().deleteRecursively();
+  getWorkingDirectory().createDirectory();
+
+  // Every test, or only the ones named after "--test"
+  juce::StringArray testNames;
+  for (int i = arguments.indexOf("--test") + 1; i < arguments.size(); ++i) testNames.add(arguments[i].unquoted());
+
+  juce::Array<juce::UnitTest*> tests;
+  for (juce::UnitTest* test : juce::UnitTest::getAllTests())
+  {
+    if (testNames.isEmpty() || testNames.contains(test->getName())) tests.add(test);
+  }
+
+  juce::UnitTestRunner runner;
+  runner.setAssertOnFailure(false);
+  runner.runTests(tests);
+
+  int numFailures = 0;
+  for (int i = 0; i < runner.getNumResults(); ++i) numFailures += runner.getResult(i)->failures;
+
+  getWorkingDirectory().deleteRecursively();
+  std::cout << (numFailures == 0 ? "All tests passed" : juce::String(numFailures) + " check(s) failed") << std::endl;
+  return numFailures == 0 ? 0 : 1;
+}
+
+juce::File EngineTests::getWorkingDirectory()
+{
+  return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OtoDecks-tests");
+}
+
+bool EngineTests::writeSineTrack(const juce::File& file, double frequency, double seconds, float amplitude)
+{
+  const double sampleRate = 44'100;
+  juce::AudioBuffer<float> buffer(1, static_cast<int>(seconds * sampleRate));
+  for (int i = 0; i < buffer.getNumSamples(); ++i)
+  {
+    buffer.setSample(0, i, amplitude * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate)));
+  }
+
+  file.deleteFile();
+  std::unique_ptr<juce::FileOutputStream> outputStream = file.createOutputStream();
+  if (outputStream == nullptr) return false;
+
+  juce::WavAudioFormat wavFormat;
+  std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(outputStream.get(), sampleRate, 1, 24, {}, 0));
+  if (writer == nullptr) return false;
+  outputStream.release(); // Now owned by 'writer'
+
+  return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+juce::Result EngineTests::render(const juce::String& script, juce::AudioBuffer<float>& output)
+{
+  OfflineRenderer::Timeline timeline;
+  juce::Result result = OfflineRenderer::parseTimeline(script, getWorkingDirectory(), timeline);
+  if (result.failed()) return result;
+
+  juce::File outputFile = getWorkingDirectory().getChildFile("render.wav");
+  OfflineRenderer renderer;
+  OfflineRenderer::Stats stats;
+  result = renderer.render(timeline, outputFile, stats);
+  if (result.failed()) return result;
+
+  juce::WavAudioFormat wavFormat;
+  std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(new juce::FileInputStream(outputFile), true));
+  if (reader == nullptr) return juce::Result::fail("Unable to read " + outputFile.getFullPathName());
+
+  output.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+  reader->read(&output, 0, output.getNumSamples(), 0, true, true);
+  return juce::Result::ok();
+}
+
+float EngineTests::getMaxStep(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  float maxStep = 0.0f;
+  for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+  {
+    const float* samples = buffer.getReadPointer(channel);
+    for (int i = startSample + 1; i < startSample + numSamples; ++i) maxStep = juce::jmax(maxStep, std::abs(samples[i] - samples[i - 1]));
+  }
+
+  return maxStep;
+}
+
+float EngineTests::getLevelAt(const juce::AudioBuffer<float>& buffer, double frequency, int startSample, int numSamples)
+{
+  const double coefficient = 2.0 * std::cos(juce::MathConstants<double>::twoPi * frequency / 44'100.0);
+  const float* samples = buffer.getReadPointer(0);
+  double s1 = 0.0;
+  double s2 = 0.0;
+  for (int i = startSample; i < startSample + numSamples; ++i)
+  {
+    double s0 = samples[i] + (coefficient * s1) - s2;
+    s2 = s1;
+    s1 = s0;
+  }
+
+  double power = (s1 * s1) + (s2 * s2) - (coefficient * s1 * s2);
+  return numSamples > 0 ? static_cast<float>((2.0 * std::sqrt(juce::jmax(0.0, power))) / numSamples) : 0.0f;
+}
+
+// ----- 1. loop ----- //
+class LoopSeamTest : public juce::UnitTest
+{
+public:
+  LoopSeamTest() : juce::UnitTest("loop", "OtoDecks") {}
+
+  void runTest() override
+  {
+    // Neither the track's nor the loop's length is a whole number of cycles, so every jump back lands on a different phase
+    juce::File track = EngineTests::getWorkingDirectory().getChildFile("sine.wav");
+    expect(EngineTests::writeSineTrack(track, 440.0, 0.4987, 0.5f), "Unable to write the test track");
+
+    struct LoopCase
+    {
+      const char* name;
+      double start;
+      double end;
+    };
+    const LoopCase loopCases[] = { { "in and out points", 0.1013, 0.3507 }, { "whole track", 0.0, 0.4987 } };
+
+    for (const LoopCase& loopCase : loopCases)
+    {
+      beginTest(loopCase.name);
+
+      juce::String script;
+      script << "length 2\n"
+             << "0 load 1 sine.wav\n"
+             << "0 loop 1 " << loopCase.start << " " << loopCase.end << "\n"
+             << "0 play 1\n";
+
+      juce::AudioBuffer<float> mix;
+      juce::Result result = EngineTests::render(script, mix);
+      expect(result.wasOk(), result.getErrorMessage());
+      if (result.failed()) continue;
+
+      // The sine's own biggest step, from the first pass through (after the deck's gain has settled, well before the first jump back)
+      const int sampleRate = 44'100;
+      float sineStep = EngineTests::getMaxStep(mix, sampleRate / 20, sampleRate / 20);
+      expectGreaterThan(sineStep, 0.0f, "Nothing played");
+
+      // A jump to another phase without the crossfade would be up to twice the sine's height
+      float maxStep = EngineTests::getMaxStep(mix, sampleRate / 10, mix.getNumSamples() - (sampleRate / 10));
+      expectLessThan(maxStep, sineStep * 1.5f, "Discontinuity at the loop's seam");
+
+      // Still playing long after the track (or the loop) would have ended
+      int lastQuarter = mix.getNumSamples() * 3 / 4;
+      expectGreaterThan(mix.getRMSLevel(0, lastQuarter, mix.getNumSamples() - lastQuarter), 0.01f, "Loop stopped playing");
+    }
+  }
+};
+
+static LoopSeamTest loopSeamTest;
+
+// ----- 2. commands ----- //
+class DeckCommandStressTest : public juce::UnitTest
+{
+public:
+  DeckCommandStressTest() : juce::UnitTest("commands", "OtoDecks") {}
+
+  void runTest() override
+  {
+    beginTest("play, stop and seek while rendering");
+
+    juce::File track = EngineTests::getWorkingDirectory().getChildFile("commands.wav");
+    expect(EngineTests::writeSineTrack(track, 440.0, 2.0, 0.5f), "Unable to write the test track");
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    juce::TimeSliceThread readAheadThread{ "Test read-ahead" };
+    DecodedTrackCache decodedTrackCache;
+    PeakFileStore peakFileStore{ formatManager, EngineTests::getWorkingDirectory().getChildFile("peak-cache") };
+    DJAudioPlayer player{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+    player.setLoadIntoRam(true);
+    player.loadURL(juce::URL{ track });
+    expect(player.isLoadedIntoRam(), "Unable to load the test track");
+
+    const double sampleRate = 44'100;
+    const int blockSize = 512;
+    const double blockSeconds = blockSize / sampleRate;
+    player.prepareToPlay(blockSize, sampleRate);
+
+    // Renders as fast as it can (like a sound card that is never kept waiting), timing every callback
+    std::atomic<bool> rendering{ true };
+    std::atomic<bool> finite{ true };
+    double maxCallbackSeconds = 0.0;
+    int numBlocks = 0;
+    std::thread renderThread([&]()
+      {
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+        while (rendering)
+        {
+          double startTime = juce::Time::getMillisecondCounterHiRes();
+          player.getNextAudioBlock(info);
+          maxCallbackSeconds = juce::jmax(maxCallbackSeconds, (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0);
+          ++numBlocks;
+
+          for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+          {
+            juce::Range<float> range = buffer.findMinMax(channel, 0, blockSize);
+            if (!std::isfinite(range.getStart()) || !std::isfinite(range.getEnd())) finite = false;
+          }
+        }
+      });
+
+    // The message thread's side: a burst of commands, then a short wait so the queue (and a few fades) drain
+    juce::Random random{ 42 };
+    const int numCommands = 20'000;
+    for (int i = 0; i < numCommands; ++i)
+    {
+      switch (random.nextInt(6))
+      {
+        case 0: player.start(); break;
+        case 1: player.stop(); break;
+        case 2: player.setPosition(random.nextDouble() * 2.0); break;
+        case 3: player.setPositionRelative(random.nextDouble()); break;
+        case 4: player.setGain(random.nextDouble()); break;
+        default: player.setLowFilter(20.0 + random.nextDouble() * 1'000.0); break;
+      }
+
+      if (i % 64 == 63) juce::Thread::sleep(1);
+    }
+
+    rendering = false;
+    renderThread.join();
+    player.releaseResources();
+
+    expectGreaterThan(numBlocks, 0, "Nothing was rendered");
+    expect(finite.load(), "Rendered a sample that is not a number");
+
+    // Stopping used to wait (up to a second) on the audio thread for the transport to fade out
+    expectLessThan(maxCallbackSeconds, blockSeconds, "A callback took longer than the block it rendered (" + juce::String(maxCallbackSeconds * 1000.0, 2) + " ms)");
+  }
+};
+
+static DeckCommandStressTest deckCommandStressTest;
+
+// ----- 3. sweep ----- //
+class FilterSweepTest : public juce::UnitTest
+{
+public:
+  FilterSweepTest() : juce::UnitTest("sweep", "OtoDecks") {}
+
+  void runTest() override
+  {
+    juce::File track = EngineTests::getWorkingDirectory().getChildFile("sweep.wav");
+    expect(EngineTests::writeSineTrack(track, 440.0, 3.0, 0.5f), "Unable to write the test track");
+
+    // Each knob is swept away from where the deck starts it and back, in steps as coarse as a slider's, a tick every 5ms
+    // (always further from the sine, so each filter only takes more away from it)
+    struct SweepCase
+    {
+      const char* name;
+      const char* action;
+      double from;
+      double to;
+    };
+    const SweepCase sweepCases[] = { { "low-pass", "low", 20'000.0, 100.0 }, { "band-pass", "mid", 1'000.0, 10'000.0 }, { "high-pass", "high", 20.0, 5'000.0 } };
+
+    for (const SweepCase& sweepCase : sweepCases)
+    {
+      beginTest(sweepCase.name);
+
+      juce::String script;
+      script << "length 2.5\n"
+             << "0 load 1 sweep.wav\n"
+             << "0 play 1\n";
+
+      const int numTicks = 200;
+      for (int tick = 0; tick <= numTicks * 2; ++tick)
+      {
+        // Out and back, in equal ratios (as the knobs move)
+        double position = (tick <= numTicks ? tick : (numTicks * 2) - tick) / static_cast<double>(numTicks);
+        double cutoff = sweepCase.from * std::pow(sweepCase.to / sweepCase.from, position);
+        script << (0.25 + tick * 0.005) << " " << sweepCase.action << " 1 " << cutoff << "\n";
+      }
+
+      juce::AudioBuffer<float> mix;
+      juce::Result result = EngineTests::render(script, mix);
+      expect(result.wasOk(), result.getErrorMessage());
+      if (result.failed()) continue;
+
+      // The sine's own biggest step, after the deck's gain has settled and before the sweep starts
+      const int sampleRate = 44'100;
+      float sineStep = EngineTests::getMaxStep(mix, sampleRate / 20, sampleRate / 10);
+      expectGreaterThan(sineStep, 0.0f, "Nothing played");
+
+      // A filter only ever takes away from a sine, so any bigger step is a click or zipper from the cutoff moving
+      float maxStep = EngineTests::getMaxStep(mix, sampleRate / 10, mix.getNumSamples() - (sampleRate / 10));
+      expectLessThan(maxStep, sineStep * 1.2f, "Discontinuity while the cutoff moved");
+
+      for (int channel = 0; channel < mix.getNumChannels(); ++channel)
+      {
+        juce::Range<float> range = mix.findMinMax(channel, 0, mix.getNumSamples());
+        expect(std::isfinite(range.getStart()) && std::isfinite(range.getEnd()), "Filter became unstable");
+      }
+    }
+  }
+};
+
+static FilterSweepTest filterSweepTest;
+
+// ----- 4. mix ----- //
+class MixRegressionTest : public juce::UnitTest
+{
+public:
+  MixRegressionTest() : juce::UnitTest("mix", "OtoDecks") {}
+
+  void runTest() override
+  {
+    // A different pitch on each deck, so each one's share of the mix can be told apart
+    const double deck1Frequency = 440.0;
+    const double deck2Frequency = 1'000.0;
+    expect(EngineTests::writeSineTrack(EngineTests::getWorkingDirectory().getChildFile("deck1.wav"), deck1Frequency, 5.0, 0.5f), "Unable to write the test track");
+    expect(EngineTests::writeSineTrack(EngineTests::getWorkingDirectory().getChildFile("deck2.wav"), deck2Frequency, 5.0, 0.5f), "Unable to write the test track");
+
+    juce::String script;
+    script << "length 4.5\n"
+           << "0 load 1 deck1.wav\n"
+           << "0 load 2 deck2.wav\n"
+           << "0 crossfade -1\n"
+           << "0 play 1\n"
+           << "0 play 2\n"
+           << "1 crossfade 1\n"
+           << "2 crossfade 0\n"
+           << "2 stop 2\n"
+           << "3 gain 1 0\n";
+
+    beginTest("each part of the mix");
+
+    juce::AudioBuffer<float> mix;
+    juce::Result result = EngineTests::render(script, mix);
+    expect(result.wasOk(), result.getErrorMessage());
+    if (result.failed()) return;
+
+    // Each second is checked after its changes have had time to glide in
+    const int sampleRate = 44'100;
+    expectEquals(mix.getNumSamples(), sampleRate * 9 / 2, "Mix is not as long as the script");
+    auto checkPart = [&](const juce::String& name, double startSeconds, double endSeconds, bool deck1Heard, bool deck2Heard)
+      {
+        int start = static_cast<int>(startSeconds * sampleRate);
+        int num = static_cast<int>((endSeconds - startSeconds) * sampleRate);
+        float deck1Level = EngineTests::getLevelAt(mix, deck1Frequency, start, num);
+        float deck2Level = EngineTests::getLevelAt(mix, deck2Frequency, start, num);
+
+        if (deck1Heard) expectGreaterThan(deck1Level, 0.02f, name + ": deck 1 is missing");
+        else expectLessThan(deck1Level, 0.001f, name + ": deck 1 should be silent");
+        if (deck2Heard) expectGreaterThan(deck2Level, 0.02f, name + ": deck 2 is missing");
+        else expectLessThan(deck2Level, 0.001f, name + ": deck 2 should be silent");
+      };
+
+    checkPart("crossfade left", 0.2, 0.9, true, false);
+    checkPart("crossfade right", 1.2, 1.9, false, true);
+    checkPart("deck 2 stopped", 2.2, 2.9, true, false);
+    checkPart("deck 1 faded down", 3.2, 4.4, false, false);
+
+    beginTest("same script, same samples");
+
+    juce::AudioBuffer<float> secondMix;
+    result = EngineTests::render(script, secondMix);
+    expect(result.wasOk(), result.getErrorMessage());
+    if (result.failed()) return;
+
+    bool identical = secondMix.getNumChannels() == mix.getNumChannels() && secondMix.getNumSamples() == mix.getNumSamples();
+    for (int channel = 0; identical && channel < mix.getNumChannels(); ++channel)
+    {
+      identical = std::memcmp(mix.getReadPointer(channel), secondMix.getReadPointer(channel), sizeof(float) * static_cast<size_t>(mix.getNumSamples())) == 0;
+    }
+    expect(identical, "Rendering the same script again gave a different mix");
+  }
+};
+
+static MixRegressionTest mixRegressionTest;
+
+// ----- 5. renderpool ----- //
+class DeckRenderPoolTest : public juce::UnitTest
+{
+public:
+  DeckRenderPoolTest() : juce::UnitTest("renderpool", "OtoDecks") {}
+
+  void runTest() override
+  {
+    beginTest("back-to-back runs with different numbers of jobs");
+
+    // Counts how many times each of its jobs ran
+    struct CountingTask : public DeckRenderPool::Task
+    {
+      void runJob(int jobIndex) override { runs[jobIndex].fetch_add(1); }
+
+      std::atomic<int> runs[maxJobs];
+    };
+
+    // Two tasks taking turns, so a job of the last run done late would land on the other one and be caught
+    CountingTask tasks[2];
+    DeckRenderPool pool{ 3 };
+    juce::Random random{ 42 };
+    const int numRuns = 200'000;
+    int numWrongRuns = 0;
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+      CountingTask& task = tasks[run % 2];
+      for (std::atomic<int>& runs : task.runs) runs.store(0);
+
+      int numJobs = 1 + random.nextInt(maxJobs);
+      pool.run(task, numJobs);
+
+      // Every job once, and nothing past the last one
+      for (int i = 0; i < maxJobs; ++i)
+      {
+        if (task.runs[i].load() != (i < numJobs ? 1 : 0))
+        {
+          ++numWrongRuns;
+          break;
+        }
+      }
+    }
+
+    expectEquals(numWrongRuns, 0, "Runs where a job ran twice, or not at all");
+  }
+
+private:
+  static constexpr int maxJobs = 8; // As many as the mixer has decks
+};
+
+static DeckRenderPoolTest deckRenderPoolTest;
@@ -0,0 +1,34 @@
+#pragma once
+#include <JuceHeader.h>
+
+/*
+Checks of the audio engine that need no sound card, run by juce::UnitTestRunner (each one is a juce::UnitTest in EngineTests.cpp).
+1. loop: a looped sine is rendered offline, and no step between samples at the loop's seam is bigger than the sine's own
+2. commands: play, stop and seek are hammered while another thread renders the deck, and no callback takes as long as its block lasts
+3. sweep: each filter's cutoff is swept in coarse steps over a sine, and no step between samples is bigger than the sine's own (no zipper noise)
+4. mix: two decks are rendered through the crossfader, stopped and faded down, and each part of the mix only holds the decks the script says
+   (and rendering the same script twice gives the same samples)
+5. renderpool: DeckRenderPool runs many blocks back to back, each with a different number of jobs, and every job runs exactly once per block
+*/
+class EngineTests
+{
+public:
+  // Handles "--test [test name...]", returns the process' exit code (1 if any check failed)
+  static int runFromCommandLine(const juce::StringArray& arguments);
+
+  // ----- Shared by the tests ----- //
+  // Generated tracks and renders go here (emptied before each run)
+  static juce::File getWorkingDirectory();
+
+  // Mono 44.1kHz sine, returns false if it could not be written
+  static bool writeSineTrack(const juce::File& file, double frequency, double seconds, float amplitude);
+
+  // Renders an OfflineRenderer timeline script (relative paths are relative to getWorkingDirectory()), and reads the mix back into 'output'
+  static juce::Result render(const juce::String& script, juce::AudioBuffer<float>& output);
+
+  // Biggest difference between one sample and the next, on any channel
+  static float getMaxStep(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  // Amplitude of the sine at 'frequency' in the first channel (Goertzel), for 44.1kHz audio
+  static float getLevelAt(const juce::AudioBuffer<float>& buffer, double frequency, int startSample, int numSamples);
+};
@@ -0,0 +1,262 @@
+#include <JuceHeader.h>
+#include "EqualiserAudioSource.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <xmmintrin.h>
+#endif
+
+EqualiserAudioSource::EqualiserAudioSource(juce::AudioSource* _input)
+  : input(_input)
+{
+  jassert(input != nullptr);
+
+  // Pass-through until audio starts
+  for (int band = 0; band < numBands; ++band) bandCoefficients[band] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+
+  reset();
+}
+
+EqualiserAudioSource::~EqualiserAudioSource()
+{
+}
+
+void EqualiserAudioSource::prepareToPlay(int samplesPerBlockExpected, double _sampleRate)
+{
+  input->prepareToPlay(samplesPerBlockExpected, _sampleRate);
+
+  sampleRate = _sampleRate;
+  for (int band = 0; band < numBands; ++band)
+  {
+    // Also jumps straight to the cutoff last set
+    cutoffs[band].reset(sampleRate, cutoffRampSeconds);
+    updateCoefficients(band);
+  }
+
+  reset();
+}
+
+void EqualiserAudioSource::releaseResources()
+{
+  input->releaseResources();
+}
+
+void EqualiserAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  input->getNextAudioBlock(bufferToFill);
+
+  // Anything past 'maxChannels' is left unfiltered (decks only ever play stereo)
+  int numChannels = bufferToFill.buffer->getNumChannels();
+  jassert(numChannels <= maxChannels);
+  numChannels = juce::jmin(numChannels, maxChannels);
+  if (numChannels == 0 || bufferToFill.numSamples <= 0) return;
+
+  float* channels[maxChannels];
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    channels[channel] = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
+  }
+
+  // Coefficients only change between sub-blocks, so the cost per block stays bounded however fast a knob moves
+  for (int startSample = 0; startSample < bufferToFill.numSamples; startSample += subBlockSize)
+  {
+    int numSamples = juce::jmin(subBlockSize, bufferToFill.numSamples - startSample);
+
+    for (int band = 0; band < numBands; ++band)
+    {
+      if (cutoffs[band].isSmoothing())
+      {
+        cutoffs[band].skip(numSamples);
+        updateCoefficients(band);
+      }
+    }
+
+#if JUCE_USE_SSE_INTRINSICS
+    if (useVector) processVector(channels, numChannels, startSample, numSamples);
+    else processScalar(channels, numChannels, startSample, numSamples);
+#else
+    processScalar(channels, numChannels, startSample, numSamples);
+#endif
+  }
+
+  // Silence after a loud part would otherwise leave the states full of denormals
+  for (int band = 0; band < numBands; ++band)
+  {
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+      JUCE_SNAP_TO_ZERO(state1[band][channel]);
+      JUCE_SNAP_TO_ZERO(state2[band][channel]);
+    }
+  }
+}
+
+void EqualiserAudioSource::setCutoff(Band band, float frequency)
+{
+  int index = static_cast<int>(band);
+
+  // Smoothing is multiplicative, so the cutoff must stay above 0
+  cutoffs[index].setTargetValue(juce::jmax(1.0f, frequency));
+  if (!cutoffs[index].isSmoothing()) updateCoefficients(index);
+}
+
+void EqualiserAudioSource::setUseVector(bool shouldUseVector)
+{
+  useVector = shouldUseVector;
+}
+
+void EqualiserAudioSource::reset()
+{
+  for (int band = 0; band < numBands; ++band)
+  {
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+      state1[band][channel] = 0.0f;
+      state2[band][channel] = 0.0f;
+    }
+  }
+}
+
+void EqualiserAudioSource::updateCoefficients(int band)
+{
+  // Coefficients depend on the sample rate, so wait until prepareToPlay() has been called
+  if (sampleRate <= 0) return;
+
+  // Same Q as before, and kept below Nyquist so tan() stays finite
+  const double k = juce::MathConstants<double>::sqrt2;
+  double frequency = juce::jlimit(1.0, sampleRate * 0.49, static_cast<double>(cutoffs[band].getCurrentValue()));
+  double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+  BandCoefficients& c = bandCoefficients[band];
+  double a1 = 1.0 / (1.0 + g * (g + k));
+  c.a1 = static_cast<float>(a1);
+  c.a2 = static_cast<float>(g * a1);
+  c.a3 = static_cast<float>(g * g * a1);
+
+  // Low-pass, band-pass with 0dB peak, and high-pass (same responses as IIRCoefficients::makeLowPass(), makeBandPass() and makeHighPass())
+  switch (static_cast<Band>(band))
+  {
+    case Band::low:
+      c.m0 = 0.0f;
+      c.m1 = 0.0f;
+      c.m2 = 1.0f;
+      break;
+
+    case Band::mid:
+      c.m0 = 0.0f;
+      c.m1 = static_cast<float>(k);
+      c.m2 = 0.0f;
+      break;
+
+    case Band::high:
+      c.m0 = 1.0f;
+      c.m1 = static_cast<float>(-k);
+      c.m2 = -1.0f;
+      break;
+  }
+}
+
+void EqualiserAudioSource::processScalar(float* const* channels, int numChannels, int startSample, int numSamples)
+{
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    float* samples = channels[channel] + startSample;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+      const BandCoefficients& c = bandCoefficients[band];
+      float ic1 = state1[band][channel];
+      float ic2 = state2[band][channel];
+
+      for (int i = 0; i < numSamples; ++i)
+      {
+        float in = samples[i];
+        float v3 = in - ic2;
+        float v1 = c.a1 * ic1 + c.a2 * v3;
+        float v2 = ic2 + c.a2 * ic1 + c.a3 * v3;
+        ic1 = 2.0f * v1 - ic1;
+        ic2 = 2.0f * v2 - ic2;
+        samples[i] = c.m0 * in + c.m1 * v1 + c.m2 * v2;
+      }
+
+      state1[band][channel] = ic1;
+      state2[band][channel] = ic2;
+    }
+  }
+}
+
+#if JUCE_USE_SSE_INTRINSICS
+void EqualiserAudioSource::processVector(float* const* channels, int numChannels, int startSample, int numSamples)
+{
+  // Every band's coefficients, copied into all 4 lanes
+  __m128 a1[numBands], a2[numBands], a3[numBands];
+  __m128 m0[numBands], m1[numBands], m2[numBands];
+  __m128 ic1[numBands], ic2[numBands];
+  for (int band = 0; band < numBands; ++band)
+  {
+    const BandCoefficients& c = bandCoefficients[band];
+    a1[band] = _mm_set1_ps(c.a1);
+    a2[band] = _mm_set1_ps(c.a2);
+    a3[band] = _mm_set1_ps(c.a3);
+    m0[band] = _mm_set1_ps(c.m0);
+    m1[band] = _mm_set1_ps(c.m1);
+    m2[band] = _mm_set1_ps(c.m2);
+    ic1[band] = _mm_load_ps(state1[band]);
+    ic2[band] = _mm_load_ps(state2[band]);
+  }
+
+  const __m128 two = _mm_set1_ps(2.0f);
+
+  // One sample of every channel (one per lane) through each band in turn, which feeds the next
+  auto filterSample = [&](__m128 x)
+    {
+      for (int band = 0; band < numBands; ++band)
+      {
+        __m128 v3 = _mm_sub_ps(x, ic2[band]);
+        __m128 v1 = _mm_add_ps(_mm_mul_ps(a1[band], ic1[band]), _mm_mul_ps(a2[band], v3));
+        __m128 v2 = _mm_add_ps(_mm_add_ps(ic2[band], _mm_mul_ps(a2[band], ic1[band])), _mm_mul_ps(a3[band], v3));
+        ic1[band] = _mm_sub_ps(_mm_mul_ps(two, v1), ic1[band]);
+        ic2[band] = _mm_sub_ps(_mm_mul_ps(two, v2), ic2[band]);
+        x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0[band], x), _mm_mul_ps(m1[band], v1)), _mm_mul_ps(m2[band], v2));
+      }
+      return x;
+    };
+
+  // 4 samples of each channel are loaded at once and transposed into one register per sample (gathering them one float at a time through memory
+  // stalls on every sample, which made this slower than the scalar loops), unused lanes are fed silence so they stay at 0
+  const __m128 silence = _mm_setzero_ps();
+  int i = startSample;
+  for (; i + 4 <= startSample + numSamples; i += 4)
+  {
+    __m128 x0 = numChannels > 0 ? _mm_loadu_ps(channels[0] + i) : silence;
+    __m128 x1 = numChannels > 1 ? _mm_loadu_ps(channels[1] + i) : silence;
+    __m128 x2 = numChannels > 2 ? _mm_loadu_ps(channels[2] + i) : silence;
+    __m128 x3 = numChannels > 3 ? _mm_loadu_ps(channels[3] + i) : silence;
+    _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+    x0 = filterSample(x0);
+    x1 = filterSample(x1);
+    x2 = filterSample(x2);
+    x3 = filterSample(x3);
+
+    _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+    if (numChannels > 0) _mm_storeu_ps(channels[0] + i, x0);
+    if (numChannels > 1) _mm_storeu_ps(channels[1] + i, x1);
+    if (numChannels > 2) _mm_storeu_ps(channels[2] + i, x2);
+    if (numChannels > 3) _mm_storeu_ps(channels[3] + i, x3);
+  }
+
+  // Last few samples of an odd-sized sub-block, one at a time
+  alignas(16) float lanes[maxChannels] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  for (; i < startSample + numSamples; ++i)
+  {
+    for (int channel = 0; channel < numChannels; ++channel) lanes[channel] = channels[channel][i];
+    _mm_store_ps(lanes, filterSample(_mm_load_ps(lanes)));
+    for (int channel = 0; channel < numChannels; ++channel) channels[channel][i] = lanes[channel];
+  }
+
+  for (int band = 0; band < numBands; ++band)
+  {
+    _mm_store_ps(state1[band], ic1[band]);
+    _mm_store_ps(state2[band], ic2[band]);
+  }
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+
+/*
+Runs the deck's low-pass, band-pass and high-pass filters over its input in a single pass.
+1. each band is a topology-preserving (trapezoidal) state variable filter, which stays stable while its cutoff is moving
+2. a new cutoff is reached over 'cutoffRampSeconds', with coefficients worked out again every 'subBlockSize' samples (so sweeping a knob does not zipper)
+3. all channels (up to 4) are filtered together, one channel per lane of an SSE register (plain loops are used where SSE is not available)
+   4 samples of every channel are transposed into registers at a time (see the equaliser benchmark for how it compares to plain loops and the old IIR chain)
+4. cutoffs are only set on the audio thread (or before audio starts), so no lock is needed
+*/
+class EqualiserAudioSource : public juce::AudioSource
+{
+public:
+  enum class Band
+  {
+    low,
+    mid,
+    high
+  };
+
+  EqualiserAudioSource(juce::AudioSource* _input);
+  ~EqualiserAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  // Glides to 'frequency' (jumps straight to it if audio is not running yet)
+  void setCutoff(Band band, float frequency);
+
+  // Clears every band's history
+  void reset();
+
+  // Plain loops instead of SSE (only so the benchmark can compare them, output is the same either way)
+  void setUseVector(bool shouldUseVector);
+
+  static constexpr int numBands = 3;
+  static constexpr int maxChannels = 4;
+  static constexpr int subBlockSize = 32;
+  static constexpr double cutoffRampSeconds = 0.05;
+
+private:
+  // Output is (m0 * input) + (m1 * band-pass) + (m2 * low-pass), which gives a low-, band- or high-pass
+  struct BandCoefficients
+  {
+    float a1, a2, a3;
+    float m0, m1, m2;
+  };
+
+  // Works out 'bandCoefficients' from the band's current (smoothed) cutoff
+  void updateCoefficients(int band);
+
+  void processScalar(float* const* channels, int numChannels, int startSample, int numSamples);
+#if JUCE_USE_SSE_INTRINSICS
+  void processVector(float* const* channels, int numChannels, int startSample, int numSamples);
+#endif
+
+  juce::AudioSource* input;
+  double sampleRate = 0.0;
+  bool useVector = true;
+
+  // Cutoffs move in equal ratios, so a sweep sounds even across the whole range
+  juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoffs[numBands];
+  BandCoefficients bandCoefficients[numBands];
+
+  // Integrator states, per band per channel
+  alignas(16) float state1[numBands][maxChannels];
+  alignas(16) float state2[numBands][maxChannels];
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EqualiserAudioSource)
+};
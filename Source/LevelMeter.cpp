@@ -0,0 +1,131 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include "LevelMeter.h"
+
+LevelMeter::LevelMeter()
+{
+}
+
+LevelMeter::~LevelMeter()
+{
+}
+
+void LevelMeter::prepare(double sampleRate)
+{
+  // K-weighting at any sample rate (the same two filters BS.1770 gives for 48kHz)
+  {
+    const double f0 = 1'681.974450955533;
+    const double gainDb = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+    double vh = std::pow(10.0, gainDb / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + (k / q) + (k * k);
+    shelf.b0 = (vh + (vb * k / q) + (k * k)) / a0;
+    shelf.b1 = 2.0 * ((k * k) - vh) / a0;
+    shelf.b2 = (vh - (vb * k / q) + (k * k)) / a0;
+    shelf.a1 = 2.0 * ((k * k) - 1.0) / a0;
+    shelf.a2 = (1.0 - (k / q) + (k * k)) / a0;
+  }
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+    double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+    double a0 = 1.0 + (k / q) + (k * k);
+    highPass.b0 = 1.0;
+    highPass.b1 = -2.0;
+    highPass.b2 = 1.0;
+    highPass.a1 = 2.0 * ((k * k) - 1.0) / a0;
+    highPass.a2 = (1.0 - (k / q) + (k * k)) / a0;
+  }
+
+  rmsCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (rmsSeconds * sampleRate)));
+  samplesPerLoudnessBlock = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+  reset();
+}
+
+void LevelMeter::reset()
+{
+  for (Biquad* biquad : { &shelf, &highPass })
+  {
+    std::fill(std::begin(biquad->z1), std::end(biquad->z1), 0.0);
+    std::fill(std::begin(biquad->z2), std::end(biquad->z2), 0.0);
+  }
+
+  meanSquare = 0.0f;
+  samplesInLoudnessBlock = 0;
+  loudnessBlockSum = 0.0;
+  std::fill(std::begin(loudnessBlocks), std::end(loudnessBlocks), 0.0);
+  nextLoudnessBlock = 0;
+
+  peak.store(0.0f);
+  rms.store(0.0f);
+  momentaryLoudness.store(silenceLoudness);
+}
+
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  int numChannels = juce::jmin(maxChannels, buffer.getNumChannels());
+  if (numChannels == 0 || numSamples <= 0) return;
+
+  // Peak (only ever raised here, and brought back down by whoever reads it)
+  float blockPeak = 0.0f;
+  for (int channel = 0; channel < numChannels; ++channel)
+    blockPeak = juce::jmax(blockPeak, buffer.getMagnitude(channel, startSample, numSamples));
+
+  float previousPeak = peak.load();
+  while (blockPeak > previousPeak && !peak.compare_exchange_weak(previousPeak, blockPeak)) {}
+
+  const float* channels[maxChannels];
+  for (int channel = 0; channel < numChannels; ++channel) channels[channel] = buffer.getReadPointer(channel, startSample);
+
+  for (int i = 0; i < numSamples; ++i)
+  {
+    float sumOfSquares = 0.0f;
+    double weightedSumOfSquares = 0.0;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      float sample = channels[channel][i];
+      sumOfSquares += sample * sample;
+
+      double weighted = highPass.process(shelf.process(sample, channel), channel);
+      weightedSumOfSquares += weighted * weighted;
+    }
+
+    meanSquare += ((sumOfSquares / numChannels) - meanSquare) * rmsCoefficient;
+
+    // Loudness sums the channels' mean squares (left and right both have a weight of 1)
+    loudnessBlockSum += weightedSumOfSquares;
+    if (++samplesInLoudnessBlock == samplesPerLoudnessBlock)
+    {
+      loudnessBlocks[nextLoudnessBlock] = loudnessBlockSum / samplesPerLoudnessBlock;
+      nextLoudnessBlock = (nextLoudnessBlock + 1) % numLoudnessBlocks;
+      loudnessBlockSum = 0.0;
+      samplesInLoudnessBlock = 0;
+
+      double meanOfBlocks = 0.0;
+      for (double block : loudnessBlocks) meanOfBlocks += block / numLoudnessBlocks;
+      momentaryLoudness.store(meanOfBlocks > 0.0 ? juce::jmax(silenceLoudness, static_cast<float>(-0.691 + (10.0 * std::log10(meanOfBlocks)))) : silenceLoudness);
+    }
+  }
+
+  // Denormals are flushed by the caller, but a long silence can still leave a tiny value behind
+  if (meanSquare < 1.0e-12f) meanSquare = 0.0f;
+  rms.store(std::sqrt(meanSquare));
+}
+
+float LevelMeter::getPeakSinceLastRead()
+{
+  return peak.exchange(0.0f);
+}
+
+float LevelMeter::getRms() const
+{
+  return rms.load();
+}
+
+float LevelMeter::getMomentaryLoudness() const
+{
+  return momentaryLoudness.load();
+}
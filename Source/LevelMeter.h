@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+/*
+Peak, RMS and loudness of a stereo signal, measured on the audio thread and read from any other.
+1. peak is the highest sample since the last time it was read (so no peak is missed, however rarely the GUI polls)
+2. RMS is averaged over about 'rmsSeconds' (a one-pole average of the squared samples)
+3. momentary loudness is in LUFS over the last 400 ms, after ITU-R BS.1770 K-weighting (no gating, as that only applies to integrated loudness)
+4. every reading is published through an atomic, so reading never blocks the audio thread
+*/
+class LevelMeter
+{
+public:
+  LevelMeter();
+  ~LevelMeter();
+
+  // Called before audio starts (or under the same lock as process())
+  void prepare(double sampleRate);
+  void reset();
+
+  // Audio thread only, measures the first 'maxChannels' channels
+  void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  // Any thread, highest absolute sample since the last call
+  float getPeakSinceLastRead();
+  float getRms() const;
+  float getMomentaryLoudness() const;
+
+  static constexpr int maxChannels = 2;
+  static constexpr double rmsSeconds = 0.3;
+  static constexpr float silenceLoudness = -100.0f; // Published when there is nothing to measure
+
+private:
+  // One biquad of the K-weighting filter (transposed direct form II)
+  struct Biquad
+  {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double z1[maxChannels] = {};
+    double z2[maxChannels] = {};
+
+    double process(double x, int channel)
+    {
+      double y = (b0 * x) + z1[channel];
+      z1[channel] = (b1 * x) - (a1 * y) + z2[channel];
+      z2[channel] = (b2 * x) - (a2 * y);
+      return y;
+    }
+  };
+
+  // Shelf then high-pass, as in BS.1770
+  Biquad shelf;
+  Biquad highPass;
+
+  // RMS
+  float rmsCoefficient = 0.0f;
+  float meanSquare = 0.0f;
+
+  // Momentary loudness is the mean of the last 4 blocks of 100 ms
+  static constexpr int numLoudnessBlocks = 4;
+  int samplesPerLoudnessBlock = 4'410;
+  int samplesInLoudnessBlock = 0;
+  double loudnessBlockSum = 0.0;
+  double loudnessBlocks[numLoudnessBlocks] = {};
+  int nextLoudnessBlock = 0;
+
+  std::atomic<float> peak{ 0.0f };
+  std::atomic<float> rms{ 0.0f };
+  std::atomic<float> momentaryLoudness{ silenceLoudness };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
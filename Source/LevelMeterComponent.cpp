@@ -0,0 +1,99 @@
+#include <JuceHeader.h>
+#include "LevelMeterComponent.h"
+
+LevelMeterComponent::LevelMeterComponent(juce::Colour _incomingColour)
+  : incomingColour(_incomingColour)
+{
+}
+
+LevelMeterComponent::~LevelMeterComponent()
+{
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+  // Background
+  juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
+  g.fillAll(myBlack);
+
+  juce::Rectangle<float> area = getLocalBounds().toFloat().reduced(1.0f);
+  bool isVertical = getHeight() > getWidth();
+
+  // RMS bar
+  float rmsLength = dbToProportion(rmsDb);
+  g.setColour(incomingColour);
+  if (isVertical) g.fillRect(area.withTop(area.getBottom() - (area.getHeight() * rmsLength)));
+  else g.fillRect(area.withWidth(area.getWidth() * rmsLength));
+
+  // Peak line
+  float peakLength = dbToProportion(peakDb);
+  g.setColour(peakDb >= 0.0f ? juce::Colours::red : juce::Colours::white);
+  if (isVertical) g.fillRect(area.getX(), area.getBottom() - (area.getHeight() * peakLength), area.getWidth(), 2.0f);
+  else g.fillRect(area.getX() + (area.getWidth() * peakLength) - 2.0f, area.getY(), 2.0f, area.getHeight());
+
+  // Loudness (only fits on horizontal meters)
+  if (!isVertical)
+  {
+    g.setColour(juce::Colours::white);
+    g.setFont(area.getHeight() * 0.7f);
+    juce::String loudnessText = loudness <= LevelMeter::silenceLoudness ? "-inf LUFS" : juce::String(loudness, 1) + " LUFS";
+    g.drawText(loudnessText, area.reduced(4.0f, 0.0f), juce::Justification::centredRight, false);
+  }
+
+  // Border
+  g.setColour(juce::Colours::white);
+  g.drawRect(getLocalBounds(), 1);
+}
+
+void LevelMeterComponent::setMeter(LevelMeter* meterToShow)
+{
+  meter = meterToShow;
+  peakDb = minimumDb;
+  rmsDb = minimumDb;
+  loudness = LevelMeter::silenceLoudness;
+  repaint();
+}
+
+void LevelMeterComponent::setExtraInfo(const juce::String& info)
+{
+  extraInfo = info;
+}
+
+void LevelMeterComponent::update()
+{
+  if (meter == nullptr) return;
+
+  // Peak falls back slowly, unless a higher one has arrived since the last refresh
+  float newPeakDb = juce::Decibels::gainToDecibels(meter->getPeakSinceLastRead(), minimumDb);
+  float newRmsDb = juce::Decibels::gainToDecibels(meter->getRms(), minimumDb);
+  float newLoudness = meter->getMomentaryLoudness();
+  newPeakDb = juce::jmax(newPeakDb, peakDb - peakFallPerUpdate);
+
+  if (newPeakDb != peakDb || newRmsDb != rmsDb || newLoudness != loudness)
+  {
+    peakDb = newPeakDb;
+    rmsDb = newRmsDb;
+    loudness = newLoudness;
+    repaint();
+  }
+
+  // Tooltip text only needs to change a few times a second
+  if (++updatesSinceTooltip >= 15)
+  {
+    updatesSinceTooltip = 0;
+    updateTooltip();
+  }
+}
+
+float LevelMeterComponent::dbToProportion(float db) const
+{
+  return juce::jlimit(0.0f, 1.0f, (db - minimumDb) / -minimumDb);
+}
+
+void LevelMeterComponent::updateTooltip()
+{
+  juce::String tooltip = "Peak " + juce::String(peakDb, 1) + " dB, RMS " + juce::String(rmsDb, 1) + " dB, "
+                       + (loudness <= LevelMeter::silenceLoudness ? juce::String("-inf") : juce::String(loudness, 1)) + " LUFS (momentary)";
+  if (extraInfo.isNotEmpty()) tooltip += "\n" + extraInfo;
+  setTooltip(tooltip);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+/*
+Draws a LevelMeter as a bar (vertical when taller than it is wide, otherwise horizontal).
+1. the bar is the RMS level, with a line at the peak (which falls back slowly, so short peaks stay visible)
+2. the scale runs from 'minimumDb' to 0 dB, and the peak line turns red when it reaches 0 dB
+3. momentary loudness (LUFS) is written on horizontal meters and in the tooltip
+*/
+class LevelMeterComponent : public juce::Component,
+                            public juce::SettableTooltipClient
+{
+public:
+  LevelMeterComponent(juce::Colour _incomingColour);
+  ~LevelMeterComponent() override;
+
+  void paint(juce::Graphics& g) override;
+
+  // nullptr shows nothing
+  void setMeter(LevelMeter* meterToShow);
+
+  // Added to the tooltip (eg. the limiter's latency and CPU use)
+  void setExtraInfo(const juce::String& info);
+
+  // Called once per display refresh, only repaints if a reading has changed
+  void update();
+
+  static constexpr float minimumDb = -60.0f;
+
+private:
+  // 0 to 1 along the bar
+  float dbToProportion(float db) const;
+  void updateTooltip();
+
+  juce::Colour incomingColour;
+  LevelMeter* meter = nullptr;
+  juce::String extraInfo;
+
+  float peakDb = minimumDb;
+  float rmsDb = minimumDb;
+  float loudness = LevelMeter::silenceLoudness;
+  float peakFallPerUpdate = 0.5f; // dB per display refresh
+  int updatesSinceTooltip = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeterComponent)
+};
@@ -0,0 +1,114 @@
+#include <JuceHeader.h>
+#include "LibraryCellPainter.h"
+
+LibraryCellPainter::LibraryCellPainter(const TrackStore& _trackStore)
+  : trackStore(_trackStore)
+{
+}
+
+LibraryCellPainter::~LibraryCellPainter()
+{
+}
+
+void LibraryCellPainter::setDeckColours(const juce::Array<juce::Colour>& colours)
+{
+  deckColours = colours;
+}
+
+int LibraryCellPainter::getNumDecks() const
+{
+  return deckColours.size();
+}
+
+int LibraryCellPainter::getDeckIndex(int columnId) const
+{
+  int deckIndex = columnId - firstLoadColumnId;
+  return (deckIndex >= 0 && deckIndex < deckColours.size()) ? deckIndex : -1;
+}
+
+void LibraryCellPainter::paintRowBackground(juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected)
+{
+  // Alternating row colours
+  if (rowNumber % 2 == 0) g.fillAll(myBlackLighter);
+  else g.fillAll(myBlackLightest);
+
+  // Selected row has black background and white border
+  if (rowIsSelected)
+  {
+    double scrollbarWidth = 10; // This is rough estimate due to being unable to get Juce's default scrollbar width
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::white);
+    g.drawRect(0, 0, width - scrollbarWidth, height, 2);
+  }
+}
+
+void LibraryCellPainter::paintCell(juce::Graphics& g, TrackStore::TrackId trackId, int columnId, int width, int height)
+{
+  if (!trackStore.contains(trackId)) return;
+
+  // "Load into Deck" columns, in each deck's colour
+  int deckIndex = getDeckIndex(columnId);
+  if (deckIndex >= 0)
+  {
+    paintCellButton(g, columnId, loadCellText, deckColours[deckIndex].brighter(), width, height);
+    return;
+  }
+
+  // "Remove" column
+  if (columnId == removeColumnId)
+  {
+    paintCellButton(g, columnId, removeCellText, juce::Colours::red.brighter(), width, height);
+    return;
+  }
+
+  // "Track Title", "Path", "Duration" and "Added" columns, in the row's font colour
+  g.setColour(juce::Colours::white);
+  drawCachedText(g, columnId, getCellText(trackId, columnId), 2, width - 4, height, juce::Justification::centredLeft);
+}
+
+const juce::String& LibraryCellPainter::getCellText(TrackStore::TrackId trackId, int columnId) const
+{
+  if (!trackStore.contains(trackId)) return noText;
+
+  // "Duration" and "Added" were formatted when the track was added
+  if (columnId == titleColumnId) return trackStore.getTitle(trackId);
+  if (columnId == pathColumnId) return trackStore.getURL(trackId);
+  if (columnId == durationColumnId) return trackStore.getDurationText(trackId);
+  if (columnId == addedColumnId) return trackStore.getDateAddedText(trackId);
+  return noText;
+}
+
+void LibraryCellPainter::paintCellButton(juce::Graphics& g, int columnId, const juce::String& text, juce::Colour textColour, int width, int height)
+{
+  // Looks the same as the transparent, connected juce::TextButtons these cells used to have
+  g.setColour(myBlack.withAlpha(0.5f));
+  g.drawRect(0, 0, width, height, 1);
+  g.setColour(textColour);
+  drawCachedText(g, columnId, text, 0, width, height, juce::Justification::centred);
+}
+
+void LibraryCellPainter::drawCachedText(juce::Graphics& g, int columnId, const juce::String& text, int x, int width, int height, juce::Justification justification)
+{
+  if (text.isEmpty() || width <= 0) return;
+
+  TextCache& cache = textCaches[columnId];
+  juce::Font font = g.getCurrentFont();
+  if (cache.width != width || cache.height != height || !(cache.font == font) || cache.texts.size() >= maxCachedTextsPerColumn)
+  {
+    cache.texts.clear();
+    cache.width = width;
+    cache.height = height;
+    cache.font = font;
+  }
+
+  // Laid out where juce::Graphics::drawText() would put it (the cell's own origin is where it is drawn from)
+  auto [entry, isNew] = cache.texts.try_emplace(text);
+  juce::GlyphArrangement& glyphs = entry->second;
+  if (isNew)
+  {
+    glyphs.addCurtailedLineOfText(font, text, 0.0f, 0.0f, static_cast<float>(width), true);
+    glyphs.justifyGlyphs(0, glyphs.getNumGlyphs(), static_cast<float>(x), 0.0f, static_cast<float>(width), static_cast<float>(height), justification);
+  }
+
+  glyphs.draw(g);
+}
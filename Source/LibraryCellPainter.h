@@ -0,0 +1,75 @@
+#pragma once
+#include <JuceHeader.h>
+#include <map>
+#include <unordered_map>
+#include "TrackStore.h"
+
+/*
+Paints the library table's rows and cells from a TrackStore (for PlaylistComponent's tableComp, and for the table benchmark, which has no GUI).
+1. every column is painted, the 'Load' and 'X' buttons too, so scrolling never creates components
+2. cells only draw TrackStore's interned strings and the painter's own texts (made once), so painting a row builds no strings
+3. getCellText() is the string a cell draws, so what painting asks of the store can be checked without drawing
+4. each column keeps the laid out glyphs of the texts it painted recently (laying text out is what allocates, and most frames only scroll a row or two in),
+   so painting rows that were painted before allocates nothing
+*/
+class LibraryCellPainter
+{
+public:
+  // Column IDs ('Load' columns are numbered from 'firstLoadColumnId', one per deck)
+  static constexpr int titleColumnId = 1;
+  static constexpr int durationColumnId = 2;
+  static constexpr int pathColumnId = 3;
+  static constexpr int addedColumnId = 4;
+  static constexpr int removeColumnId = 5;
+  static constexpr int firstLoadColumnId = 100;
+
+  LibraryCellPainter(const TrackStore& _trackStore);
+  ~LibraryCellPainter();
+
+  // One 'Load' column per deck, in each deck's colour
+  void setDeckColours(const juce::Array<juce::Colour>& colours);
+  int getNumDecks() const;
+  int getDeckIndex(int columnId) const; // -1 if 'columnId' is not a 'Load' column
+
+  void paintRowBackground(juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected);
+  void paintCell(juce::Graphics& g, TrackStore::TrackId trackId, int columnId, int width, int height);
+
+  // Empty for the 'Load' and 'X' columns, and for tracks not in the store
+  const juce::String& getCellText(TrackStore::TrackId trackId, int columnId) const;
+
+private:
+  const TrackStore& trackStore;
+
+  juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);         // Used in the painted buttons' outlines
+  juce::Colour myBlackLighter = juce::Colour::fromRGB(60, 60, 60);  // Used in alternating rows
+  juce::Colour myBlackLightest = juce::Colour::fromRGB(80, 80, 80); // Used in alternating rows
+  juce::Array<juce::Colour> deckColours;                            // Used in the 'Load' buttons
+
+  // Text of the painted 'Load' and 'X' buttons (made once, instead of on every paint)
+  const juce::String loadCellText{ "Load" };
+  const juce::String removeCellText{ "X" };
+  const juce::String noText;
+
+  struct StringHash
+  {
+    size_t operator()(const juce::String& text) const { return text.hash(); }
+  };
+
+  // One per column, emptied when the column's size or font changes (or it fills up, which only costs laying out what is on screen again)
+  struct TextCache
+  {
+    int width = 0;
+    int height = 0;
+    juce::Font font;
+    std::unordered_map<juce::String, juce::GlyphArrangement, StringHash> texts;
+  };
+  static constexpr size_t maxCachedTextsPerColumn = 1'024;
+  std::map<int, TextCache> textCaches;
+
+  void paintCellButton(juce::Graphics& g, int columnId, const juce::String& text, juce::Colour textColour, int width, int height);
+
+  // Same as juce::Graphics::drawText() (on one line, with an ellipsis if it does not fit), laid out once per column and size
+  void drawCachedText(juce::Graphics& g, int columnId, const juce::String& text, int x, int width, int height, juce::Justification justification);
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryCellPainter)
+};
@@ -0,0 +1,143 @@
+#include <JuceHeader.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include "LibraryFile.h"
+
+bool LibraryFile::write(const juce::File& file, const std::vector<Track>& tracks)
+{
+  // Every distinct string gets a number, in the order they are first used
+  std::unordered_map<std::string, juce::uint32> stringNumbers;
+  std::vector<const std::string*> strings;
+  std::vector<juce::uint32> trackStrings;
+  trackStrings.reserve(tracks.size() * 2);
+
+  for (const Track& track : tracks)
+  {
+    for (const juce::String* text : { &track.fileURL, &track.fileTitle })
+    {
+      auto it = stringNumbers.try_emplace(text->toStdString(), static_cast<juce::uint32>(strings.size())).first;
+      if (it->second == strings.size()) strings.push_back(&(it->first));
+      trackStrings.push_back(it->second);
+    }
+  }
+
+  juce::uint64 stringTableSize = 0;
+  for (const std::string* text : strings) stringTableSize += text->size();
+  if (stringTableSize > 0xffff'ffff) return false; // Offsets are 32 bit
+
+  // Write to a temporary file first, so a crash never leaves a half-written library behind
+  juce::TemporaryFile temporaryFile(file);
+  {
+    juce::FileOutputStream output(temporaryFile.getFile());
+    if (!output.openedOk()) return false;
+
+    output.writeInt(static_cast<int>(juce::ByteOrder::littleEndianInt("OTLB")));
+    output.writeInt(fileVersion);
+    output.writeInt(static_cast<int>(tracks.size()));
+    output.writeInt(static_cast<int>(strings.size()));
+    output.writeInt64(static_cast<juce::int64>(stringTableSize));
+
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+      output.writeInt(static_cast<int>(trackStrings[i * 2]));
+      output.writeInt(static_cast<int>(trackStrings[(i * 2) + 1]));
+      output.writeFloat(static_cast<float>(tracks[i].fileDuration));
+      output.writeFloat(static_cast<float>(tracks[i].sampleRate));
+      output.writeInt(tracks[i].numChannels);
+      output.writeInt64(tracks[i].dateAdded);
+    }
+
+    juce::uint32 offset = 0;
+    for (const std::string* text : strings)
+    {
+      output.writeInt(static_cast<int>(offset));
+      offset += static_cast<juce::uint32>(text->size());
+    }
+    output.writeInt(static_cast<int>(offset));
+
+    for (const std::string* text : strings) output.write(text->data(), text->size());
+
+    output.flush();
+    if (output.getStatus().failed()) return false;
+  }
+
+  return temporaryFile.overwriteTargetFileWithTemporary();
+}
+
+bool LibraryFile::read(const juce::File& file, std::vector<Track>& tracks)
+{
+  tracks.clear();
+
+  juce::MemoryMappedFile mappedFile(file, juce::MemoryMappedFile::readOnly);
+  const char* data = static_cast<const char*>(mappedFile.getData());
+  juce::uint64 size = mappedFile.getSize();
+  if (data == nullptr || size < headerSize) return false;
+
+  if (readUint32(data) != juce::ByteOrder::littleEndianInt("OTLB")) return false;
+  juce::uint32 version = readUint32(data + 4);
+  if (version != static_cast<juce::uint32>(fileVersion) && version != static_cast<juce::uint32>(firstFileVersion)) return false;
+  bool hasDateAdded = version == static_cast<juce::uint32>(fileVersion);
+  juce::uint64 versionRecordSize = hasDateAdded ? recordSize : firstRecordSize;
+  juce::uint64 numTracks = readUint32(data + 8);
+  juce::uint64 numStrings = readUint32(data + 12);
+  juce::uint64 stringTableSize = juce::ByteOrder::littleEndianInt64(data + 16);
+
+  // Sections follow each other with no gaps, so their sizes must add up to the file's
+  juce::uint64 offsetsStart = headerSize + (numTracks * versionRecordSize);
+  juce::uint64 stringTableStart = offsetsStart + ((numStrings + 1) * 4);
+  if (stringTableSize > size || stringTableStart + stringTableSize != size) return false;
+
+  std::vector<juce::String> strings;
+  strings.reserve(static_cast<size_t>(numStrings));
+  for (juce::uint64 i = 0; i < numStrings; ++i)
+  {
+    juce::uint32 start = readUint32(data + offsetsStart + (i * 4));
+    juce::uint32 end = readUint32(data + offsetsStart + ((i + 1) * 4));
+    if (start > end || end > stringTableSize) return false;
+
+    strings.push_back(juce::String::fromUTF8(data + stringTableStart + start, static_cast<int>(end - start)));
+  }
+
+  tracks.resize(static_cast<size_t>(numTracks));
+  for (juce::uint64 i = 0; i < numTracks; ++i)
+  {
+    const char* record = data + headerSize + (i * versionRecordSize);
+    juce::uint32 urlNumber = readUint32(record);
+    juce::uint32 titleNumber = readUint32(record + 4);
+    if (urlNumber >= numStrings || titleNumber >= numStrings)
+    {
+      tracks.clear();
+      return false;
+    }
+
+    // Strings are shared (not copied) between tracks that use the same one
+    Track& track = tracks[static_cast<size_t>(i)];
+    track.fileURL = strings[urlNumber];
+    track.fileTitle = strings[titleNumber];
+    track.fileDuration = readFloat(record + 8);
+    track.sampleRate = readFloat(record + 12);
+    track.numChannels = static_cast<int>(readUint32(record + 16));
+    track.dateAdded = hasDateAdded ? static_cast<juce::int64>(juce::ByteOrder::littleEndianInt64(record + 20)) : 0;
+  }
+
+  return true;
+}
+
+bool LibraryFile::isLibraryFile(const juce::File& file)
+{
+  return file.hasFileExtension(".otolib");
+}
+
+juce::uint32 LibraryFile::readUint32(const char* data)
+{
+  return juce::ByteOrder::littleEndianInt(data);
+}
+
+float LibraryFile::readFloat(const char* data)
+{
+  juce::uint32 bits = readUint32(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
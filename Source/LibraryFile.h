@@ -0,0 +1,47 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+Binary library file (".otolib"), read by memory mapping it instead of reading a path per line and checking each file exists.
+1. header: magic number, version, number of tracks, number of strings, and the string table's size
+2. one fixed-size record per track: its URL and title (as string numbers), duration, sample rate, number of channels and when it was added to the library
+3. string offset index: where each string starts in the string table (plus where the last one ends)
+4. string table: every distinct string once, as UTF-8
+Everything is little-endian, and a file of another version (or one whose sizes do not add up) is never partly read.
+Version 1 files (written before records had the date added) are still read, with every track's date added unknown, and are written back as the current version.
+*/
+class LibraryFile
+{
+public:
+  struct Track
+  {
+    juce::String fileURL;
+    juce::String fileTitle;
+    double fileDuration = 0.0;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    juce::int64 dateAdded = 0; // Milliseconds since 1970, 0 if unknown
+  };
+
+  // Returns false if 'file' could not be written (it is only replaced once the whole library has been written)
+  static bool write(const juce::File& file, const std::vector<Track>& tracks);
+
+  // Replaces 'tracks' with every track in 'file' in order, returns false (leaving 'tracks' empty) if 'file' is not a library this version can read
+  static bool read(const juce::File& file, std::vector<Track>& tracks);
+
+  static bool isLibraryFile(const juce::File& file);
+
+private:
+  // Change this whenever the layout changes (and keep reading the last version's layout, if it can be)
+  static constexpr int fileVersion = 2;
+  static constexpr size_t headerSize = 24;
+  static constexpr size_t recordSize = 28;
+
+  // Version 1 records have no date added
+  static constexpr int firstFileVersion = 1;
+  static constexpr size_t firstRecordSize = 20;
+
+  static juce::uint32 readUint32(const char* data);
+  static float readFloat(const char* data);
+};
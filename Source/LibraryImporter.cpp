@@ -0,0 +1,227 @@
+#include <JuceHeader.h>
+#include "LibraryImporter.h"
+
+// Goes through a small chunk of files on one of the pool's worker threads
+class LibraryImporter::ProbeJob : public juce::ThreadPoolJob
+{
+public:
+  ProbeJob(LibraryImporter& _owner, juce::uint32 _session, int _firstIndex, juce::StringArray _filePaths)
+    : juce::ThreadPoolJob("Library import"),
+      owner(_owner),
+      session(_session),
+      firstIndex(_firstIndex),
+      filePaths(std::move(_filePaths))
+  {
+  }
+
+  JobStatus runJob() override
+  {
+    for (int i = 0; i < filePaths.size(); ++i)
+    {
+      // Stop early when the import is cancelled
+      if (shouldExit()) break;
+
+      owner.probeFile(session, firstIndex + i, filePaths[i]);
+    }
+
+    return jobHasFinished;
+  }
+
+private:
+  LibraryImporter& owner;
+  juce::uint32 session;
+  int firstIndex;
+  juce::StringArray filePaths;
+};
+
+LibraryImporter::LibraryImporter(juce::AudioFormatManager& _formatManager, TrackMetadataCache& _metadataCache, int numWorkerThreads)
+  : formatManager(_formatManager),
+    metadataCache(_metadataCache),
+    threadPool(numWorkerThreads)
+{
+}
+
+LibraryImporter::~LibraryImporter()
+{
+  stopTimer();
+  threadPool.removeAllJobs(true, 5'000);
+}
+
+void LibraryImporter::setListener(Listener* _listener)
+{
+  listener = _listener;
+}
+
+void LibraryImporter::importFiles(const juce::StringArray& filePaths)
+{
+  if (filePaths.isEmpty()) return;
+
+  // Start a new session if nothing is being imported
+  if (!isImporting())
+  {
+    resetSession();
+    startTimeInMs = juce::Time::getMillisecondCounterHiRes();
+    startTimerHz(30);
+  }
+
+  int firstIndex = queuedFiles.size();
+  queuedFiles.addArray(filePaths);
+
+  // Make room for the incoming results (workers only write into slots that already exist)
+  {
+    const juce::ScopedLock sl(resultsLock);
+    results.resize(queuedFiles.size());
+    resultIsReady.resize(queuedFiles.size(), 0);
+  }
+
+  // Split into jobs, and let the pool own them
+  for (int start = 0; start < filePaths.size(); start += filesPerJob)
+  {
+    int count = juce::jmin(filesPerJob, filePaths.size() - start);
+    juce::StringArray chunk;
+    chunk.addArray(filePaths, start, count);
+    threadPool.addJob(new ProbeJob(*this, sessionNumber, firstIndex + start, std::move(chunk)), true);
+  }
+}
+
+void LibraryImporter::cancel()
+{
+  if (!isImporting()) return;
+
+  stopTimer();
+  threadPool.removeAllJobs(true, 5'000);
+
+  Progress progress = getProgress();
+  juce::StringArray missing = missingFiles;
+  resetSession();
+
+  if (listener != nullptr) listener->importFinished(progress, missing, true);
+}
+
+bool LibraryImporter::isImporting() const
+{
+  return nextIndexToPublish < queuedFiles.size();
+}
+
+LibraryImporter::Progress LibraryImporter::getProgress() const
+{
+  Progress progress;
+  progress.filesDone = filesDone.load();
+  progress.filesTotal = queuedFiles.size();
+  progress.filesFromCache = filesFromCache.load();
+
+  double elapsedInSeconds = (juce::Time::getMillisecondCounterHiRes() - startTimeInMs) / 1'000.0;
+  if (elapsedInSeconds > 0.0) progress.filesPerSecond = progress.filesDone / elapsedInSeconds;
+
+  return progress;
+}
+
+juce::StringArray LibraryImporter::getUnfinishedFiles() const
+{
+  juce::StringArray unfinishedFiles;
+  if (isImporting()) unfinishedFiles.addArray(queuedFiles, nextIndexToPublish);
+  return unfinishedFiles;
+}
+
+void LibraryImporter::probeFile(juce::uint32 session, int index, const juce::String& filePath)
+{
+  ImportedTrack track;
+  bool isFromCache = false;
+  juce::File incomingFile(filePath);
+
+  track.fileURL = filePath.toStdString();
+  track.fileTitle = incomingFile.getFileNameWithoutExtension().toStdString();
+  track.fileExists = incomingFile.existsAsFile();
+
+  if (track.fileExists)
+  {
+    TrackMetadataCache::TrackMetadata metadata;
+
+    // Warm start: only the file's size and modification time are checked
+    if (metadataCache.lookup(incomingFile, metadata))
+    {
+      isFromCache = true;
+    }
+    // Cold start: open the file (only the header is needed to work out the duration)
+    else
+    {
+      std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(incomingFile));
+      if (reader != nullptr && reader->sampleRate > 0)
+      {
+        metadata.duration = reader->lengthInSamples / reader->sampleRate;
+        metadata.sampleRate = reader->sampleRate;
+        metadata.numChannels = static_cast<int>(reader->numChannels);
+        metadata.title = track.fileTitle;
+        metadataCache.store(incomingFile, metadata);
+      }
+    }
+
+    track.fileDuration = metadata.duration;
+    track.sampleRate = metadata.sampleRate;
+    track.numChannels = metadata.numChannels;
+  }
+
+  {
+    const juce::ScopedLock sl(resultsLock);
+
+    // Left over from a cancelled import, whose results have already been cleared
+    if (session != sessionNumber) return;
+
+    results[index] = std::move(track);
+    resultIsReady[index] = 1;
+    ++filesDone;
+    if (isFromCache) ++filesFromCache;
+  }
+}
+
+void LibraryImporter::timerCallback()
+{
+  // Collect results in order, stopping at the first one that is not ready yet
+  std::vector<ImportedTrack> batch;
+  {
+    const juce::ScopedLock sl(resultsLock);
+    while (nextIndexToPublish < queuedFiles.size() && resultIsReady[nextIndexToPublish])
+    {
+      batch.push_back(std::move(results[nextIndexToPublish]));
+      ++nextIndexToPublish;
+    }
+  }
+
+  for (const auto& track : batch)
+  {
+    if (!track.fileExists) missingFiles.add(juce::String(track.fileURL));
+  }
+
+  Progress progress = getProgress();
+
+  if (listener != nullptr)
+  {
+    if (!batch.empty()) listener->importBatchReady(batch);
+    listener->importProgressChanged(progress);
+  }
+
+  // Everything has been handed over
+  if (!isImporting())
+  {
+    stopTimer();
+    juce::StringArray missing = missingFiles;
+    resetSession();
+
+    if (listener != nullptr) listener->importFinished(progress, missing, false);
+  }
+}
+
+void LibraryImporter::resetSession()
+{
+  queuedFiles.clear();
+  missingFiles.clear();
+  nextIndexToPublish = 0;
+
+  // Any job still running from the last session drops its result instead of writing past the end of 'results'
+  const juce::ScopedLock sl(resultsLock);
+  ++sessionNumber;
+  filesDone = 0;
+  filesFromCache = 0;
+  results.clear();
+  resultIsReady.clear();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+#include <string>
+#include "TrackMetadataCache.h"
+
+/*
+Imports audio files in the background, so that large libraries do not freeze the UI.
+1. a pool of worker threads reads each file's duration (from 'metadataCache' if possible, else by opening the file)
+2. finished results are handed back on the message thread in batches (in the same order they were queued)
+3. progress and throughput (files/sec) can be polled at any time, and the import can be cancelled
+*/
+class LibraryImporter : private juce::Timer
+{
+public:
+  struct ImportedTrack
+  {
+    std::string fileURL;
+    std::string fileTitle;
+    double fileDuration = 0.0;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    bool fileExists = false;
+  };
+
+  struct Progress
+  {
+    int filesDone = 0;
+    int filesTotal = 0;
+    int filesFromCache = 0;
+    double filesPerSecond = 0.0;
+  };
+
+  // All callbacks happen on the message thread
+  class Listener
+  {
+  public:
+    virtual ~Listener() = default;
+    virtual void importBatchReady(const std::vector<ImportedTrack>& batch) = 0;
+    virtual void importProgressChanged(const Progress& progress) = 0;
+    virtual void importFinished(const Progress& progress, const juce::StringArray& missingFiles, bool wasCancelled) = 0;
+  };
+
+  LibraryImporter(juce::AudioFormatManager& _formatManager,
+                  TrackMetadataCache& _metadataCache,
+                  int numWorkerThreads = juce::jlimit(1, 8, juce::SystemStats::getNumCpus()));
+  ~LibraryImporter() override;
+
+  void setListener(Listener* _listener);
+
+  // Queue files to be imported (files queued while an import is running are added to that import)
+  void importFiles(const juce::StringArray& filePaths);
+  void cancel();
+
+  bool isImporting() const;
+  Progress getProgress() const;
+
+  // Files that have been queued but not handed to the listener yet (eg. to persist them if the app closes mid-import)
+  juce::StringArray getUnfinishedFiles() const;
+
+private:
+  class ProbeJob;
+
+  // Called by ProbeJob on a worker thread (results of a session that has since been cancelled are dropped)
+  void probeFile(juce::uint32 session, int index, const juce::String& filePath);
+
+  // Hands contiguous finished results to the listener
+  void timerCallback() override;
+  void resetSession();
+
+  juce::AudioFormatManager& formatManager;
+  TrackMetadataCache& metadataCache;
+  juce::ThreadPool threadPool;
+  Listener* listener = nullptr;
+
+  // Number of files each ProbeJob goes through (so a 20k library does not create 20k jobs)
+  int filesPerJob = 32;
+
+  // ----- Current import session ----- //
+  // Message thread only
+  juce::StringArray queuedFiles;
+  juce::StringArray missingFiles;
+  int nextIndexToPublish = 0;
+  double startTimeInMs = 0.0;
+
+  // Shared with worker threads
+  juce::CriticalSection resultsLock;
+  juce::uint32 sessionNumber = 0; // Changed under 'resultsLock', as removeAllJobs() can give up on a job that is still running
+  std::vector<ImportedTrack> results;
+  std::vector<char> resultIsReady;
+  std::atomic<int> filesDone{ 0 };
+  std::atomic<int> filesFromCache{ 0 };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryImporter)
+};
@@ -0,0 +1,146 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include "LibrarySearch.h"
+
+LibrarySearch::LibrarySearch()
+{
+}
+
+LibrarySearch::~LibrarySearch()
+{
+}
+
+void LibrarySearch::addTitle(const juce::String& title)
+{
+  juce::uint32 index = static_cast<juce::uint32>(foldedTitles.size());
+  foldedTitles.push_back(fold(title));
+
+  const std::string& foldedTitle = foldedTitles.back();
+  for (size_t i = 0; i + 3 <= foldedTitle.size(); ++i)
+  {
+    // Titles are added in order, so a trigram that appears twice in this title is already at the back of its list
+    std::vector<juce::uint32>& titles = trigramTitles[getTrigram(foldedTitle.data() + i)];
+    if (titles.empty() || titles.back() != index) titles.push_back(index);
+  }
+}
+
+void LibrarySearch::removeTitle(size_t index)
+{
+  jassert(index < foldedTitles.size());
+  if (index >= foldedTitles.size()) return;
+
+  // An empty title never matches, so it can stay in the trigram lists (and in 'matches' until they are next read)
+  std::string().swap(foldedTitles[index]);
+  matchesHaveRemovals = true;
+}
+
+void LibrarySearch::clear()
+{
+  foldedTitles.clear();
+  trigramTitles.clear();
+  lastQuery.clear();
+  lastNumTitles = 0;
+  matches.clear();
+  matchesHaveRemovals = false;
+}
+
+size_t LibrarySearch::getNumTitles() const
+{
+  return foldedTitles.size();
+}
+
+const std::vector<size_t>& LibrarySearch::findMatches(const juce::String& query)
+{
+  std::string foldedQuery = fold(query);
+  if (foldedQuery.empty())
+  {
+    matches.clear();
+    lastQuery.clear();
+    return matches;
+  }
+
+  // Rarest trigram of the query (an empty list if any of its trigrams appears in no title at all)
+  static const std::vector<juce::uint32> noTitles;
+  const std::vector<juce::uint32>* rarestTitles = nullptr;
+  for (size_t i = 0; i + 3 <= foldedQuery.size(); ++i)
+  {
+    auto it = trigramTitles.find(getTrigram(foldedQuery.data() + i));
+    const std::vector<juce::uint32>& titles = (it == trigramTitles.end()) ? noTitles : it->second;
+    if (rarestTitles == nullptr || titles.size() < rarestTitles->size()) rarestTitles = &titles;
+  }
+
+  // A title that contains this query also contained the last one, so only the last matches (and newer titles) can match
+  bool canNarrow = !lastQuery.empty() && foldedQuery.find(lastQuery) != std::string::npos;
+  size_t numToNarrow = matches.size() + (foldedTitles.size() - lastNumTitles);
+
+  candidates.clear();
+  if (canNarrow && (rarestTitles == nullptr || numToNarrow <= rarestTitles->size()))
+  {
+    candidates.swap(matches);
+    for (size_t i = lastNumTitles; i < foldedTitles.size(); ++i) candidates.push_back(i);
+  }
+  else if (rarestTitles != nullptr)
+  {
+    candidates.assign(rarestTitles->begin(), rarestTitles->end());
+  }
+  else
+  {
+    // 1 or 2 bytes, so every title is checked
+    candidates.resize(foldedTitles.size());
+    for (size_t i = 0; i < candidates.size(); ++i) candidates[i] = i;
+  }
+
+  checkCandidates(foldedQuery);
+  matchesHaveRemovals = false;
+  lastQuery = foldedQuery;
+  lastNumTitles = foldedTitles.size();
+  return matches;
+}
+
+const std::vector<size_t>& LibrarySearch::getMatches() const
+{
+  // Removed titles are all dropped in one pass, keeping the rest in order
+  if (matchesHaveRemovals)
+  {
+    matches.erase(std::remove_if(matches.begin(), matches.end(), [this](size_t i) { return foldedTitles[i].empty(); }), matches.end());
+    matchesHaveRemovals = false;
+  }
+
+  return matches;
+}
+
+size_t LibrarySearch::getMemoryUsage() const
+{
+  const size_t inlineCapacity = std::string().capacity();
+  size_t bytes = foldedTitles.capacity() * sizeof(std::string);
+  for (const std::string& title : foldedTitles)
+  {
+    if (title.capacity() > inlineCapacity) bytes += title.capacity() + 1;
+  }
+
+  bytes += trigramTitles.bucket_count() * sizeof(void*);
+  for (const auto& entry : trigramTitles) bytes += sizeof(entry) + (2 * sizeof(void*)) + (entry.second.capacity() * sizeof(juce::uint32));
+
+  return bytes + ((matches.capacity() + candidates.capacity()) * sizeof(size_t));
+}
+
+std::string LibrarySearch::fold(const juce::String& text)
+{
+  return text.toLowerCase().toStdString();
+}
+
+juce::uint32 LibrarySearch::getTrigram(const char* text)
+{
+  return (static_cast<juce::uint32>(static_cast<unsigned char>(text[0])) << 16)
+       | (static_cast<juce::uint32>(static_cast<unsigned char>(text[1])) << 8)
+       | static_cast<juce::uint32>(static_cast<unsigned char>(text[2]));
+}
+
+void LibrarySearch::checkCandidates(const std::string& foldedQuery)
+{
+  matches.clear();
+  for (size_t i : candidates)
+  {
+    if (foldedTitles[i].find(foldedQuery) != std::string::npos) matches.push_back(i);
+  }
+}
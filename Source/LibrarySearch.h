@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Matches the search box's text against track titles, fast enough to run on every keystroke with a very large library (kept apart from PlaylistComponent so it can be timed without a GUI).
+1. titles are case-folded once, as they are added, so searching never builds a juce::String per title
+2. every 3 byte sequence (trigram) of every title is indexed, so a query of 3 or more bytes only checks the titles listed under its rarest trigram
+3. shorter queries check every case-folded title directly
+4. a query that contains the last one (eg. another letter was typed) only checks the last query's matches again, plus any titles added since
+5. titles keep their index when one is removed (the same as TrackStore's IDs), so removing one never re-indexes the others,
+   and it is dropped from the matches the next time they are read (so removing many titles costs one pass over the matches, not one per title)
+*/
+class LibrarySearch
+{
+public:
+  LibrarySearch();
+  ~LibrarySearch();
+
+  // Titles are numbered in the order they are added (a removed title's index is not used again until clear())
+  void addTitle(const juce::String& title);
+  void removeTitle(size_t index);
+  void clear();
+  size_t getNumTitles() const;
+
+  // Index of every title containing 'query' (ignoring case), in order, and nothing if 'query' is empty
+  const std::vector<size_t>& findMatches(const juce::String& query);
+
+  // What findMatches() last returned (less any titles removed since)
+  const std::vector<size_t>& getMatches() const;
+
+  // Rough size of the titles and index in bytes
+  size_t getMemoryUsage() const;
+
+private:
+  static std::string fold(const juce::String& text);
+  static juce::uint32 getTrigram(const char* text);
+
+  // Keeps the titles in 'candidates' that contain 'foldedQuery', in 'matches'
+  void checkCandidates(const std::string& foldedQuery);
+
+  std::vector<std::string> foldedTitles;
+
+  // Index of every title each trigram appears in, in order (each title is listed once per trigram, and removed titles are left in)
+  std::unordered_map<juce::uint32, std::vector<juce::uint32>> trigramTitles;
+
+  // For narrowing the next query down from this one ('lastQuery' is empty when there is nothing to narrow down from)
+  std::string lastQuery;
+  size_t lastNumTitles = 0;
+  mutable std::vector<size_t> matches;
+  mutable bool matchesHaveRemovals = false;
+  std::vector<size_t> candidates;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibrarySearch)
+};
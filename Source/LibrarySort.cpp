@@ -0,0 +1,121 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include "LibrarySort.h"
+
+LibrarySort::LibrarySort(const TrackStore& _trackStore)
+  : trackStore(_trackStore)
+{
+}
+
+LibrarySort::~LibrarySort()
+{
+}
+
+void LibrarySort::trackAdded(TrackStore::TrackId id)
+{
+  // Orders not built yet pick it up from the store when they are
+  for (Order& order : orders)
+  {
+    if (order.isBuilt) order.addedIds.push_back(id);
+  }
+}
+
+void LibrarySort::trackRemoved(TrackStore::TrackId id)
+{
+  // Left in every order until it is next read (the store already says it is gone)
+  jassert(!trackStore.contains(id));
+  juce::ignoreUnused(id);
+  for (Order& order : orders) order.hasRemovals = order.isBuilt;
+}
+
+void LibrarySort::clear()
+{
+  for (Order& order : orders) order = Order();
+}
+
+const std::vector<TrackStore::TrackId>& LibrarySort::getOrder(Key key)
+{
+  return getUpToDate(key).ids;
+}
+
+void LibrarySort::sortIds(Key key, std::vector<TrackStore::TrackId>& ids)
+{
+  Order& order = getUpToDate(key);
+
+  // A big set is quicker to pick out of the whole order (one pass, no comparisons)
+  if (ids.size() * 8 >= order.ids.size())
+  {
+    if (order.ids.empty()) return;
+    isInSet.assign(static_cast<size_t>(trackStore.getTrackIds().back()) + 1, false);
+    for (TrackStore::TrackId id : ids) isInSet[id] = true;
+
+    ids.clear();
+    for (TrackStore::TrackId id : order.ids)
+    {
+      if (isInSet[id]) ids.push_back(id);
+    }
+    return;
+  }
+
+  // A small one is sorted by where each track is in the whole order
+  if (!order.arePositionsValid)
+  {
+    order.positions.resize(order.ids.empty() ? 0 : static_cast<size_t>(trackStore.getTrackIds().back()) + 1);
+    for (size_t i = 0; i < order.ids.size(); ++i) order.positions[order.ids[i]] = static_cast<juce::uint32>(i);
+    order.arePositionsValid = true;
+  }
+  std::sort(ids.begin(), ids.end(), [&order](TrackStore::TrackId a, TrackStore::TrackId b) { return order.positions[a] < order.positions[b]; });
+}
+
+void LibrarySort::prepareAll()
+{
+  for (int i = 0; i < numKeys; ++i) getOrder(static_cast<Key>(i));
+}
+
+bool LibrarySort::isBefore(Key key, TrackStore::TrackId a, TrackStore::TrackId b) const
+{
+  switch (key)
+  {
+    case Key::title: return trackStore.getTitle(a).compareNatural(trackStore.getTitle(b)) < 0;
+    case Key::duration: return trackStore.getDuration(a) < trackStore.getDuration(b);
+    case Key::path: return trackStore.getURL(a).compareIgnoreCase(trackStore.getURL(b)) < 0;
+    case Key::dateAdded: return trackStore.getDateAdded(a) < trackStore.getDateAdded(b);
+  }
+
+  return a < b;
+}
+
+LibrarySort::Order& LibrarySort::getUpToDate(Key key)
+{
+  Order& order = orders[static_cast<int>(key)];
+  auto isBeforeByKey = [this, key](TrackStore::TrackId a, TrackStore::TrackId b) { return isBefore(key, a, b); };
+
+  // Removed tracks are all dropped in one pass (the rest keep their order, so 'positions' still sorts them correctly)
+  if (order.hasRemovals)
+  {
+    auto isRemoved = [this](TrackStore::TrackId id) { return !trackStore.contains(id); };
+    order.ids.erase(std::remove_if(order.ids.begin(), order.ids.end(), isRemoved), order.ids.end());
+    order.addedIds.erase(std::remove_if(order.addedIds.begin(), order.addedIds.end(), isRemoved), order.addedIds.end());
+    order.hasRemovals = false;
+  }
+
+  // Stable sorts and merges, so tracks that tie stay in the order they were added
+  if (!order.isBuilt)
+  {
+    order.ids = trackStore.getTrackIds();
+    std::stable_sort(order.ids.begin(), order.ids.end(), isBeforeByKey);
+    order.isBuilt = true;
+    order.arePositionsValid = false;
+  }
+  else if (!order.addedIds.empty())
+  {
+    std::stable_sort(order.addedIds.begin(), order.addedIds.end(), isBeforeByKey);
+    size_t numSorted = order.ids.size();
+    order.ids.insert(order.ids.end(), order.addedIds.begin(), order.addedIds.end());
+    std::inplace_merge(order.ids.begin(), order.ids.begin() + numSorted, order.ids.end(), isBeforeByKey);
+    order.addedIds.clear();
+    order.arePositionsValid = false;
+  }
+
+  return order;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "TrackStore.h"
+
+/*
+Puts the library's tracks in order by one of its columns, for PlaylistComponent's sortable headers (kept apart from it so it can be timed without a GUI).
+1. each key's order (TrackStore's IDs, first to last) is sorted once and cached, so switching between columns or directions is instant
+2. tracks added since are sorted on their own and merged in, instead of sorting every track again
+3. removing a track only marks each order as having removals (as TrackStore does), and they are all dropped in one pass the next time an order is read
+4. a filtered set of tracks (eg. search matches) is put in order using each track's position in the cached order, instead of comparing their titles again
+5. "date added" is sorted by the time TrackStore keeps for each track (a saved library's tracks keep theirs, so it is not always the order they were added to the store)
+*/
+class LibrarySort
+{
+public:
+  // A new key (eg. an analysed field) only needs adding here and to LibrarySort::isBefore()
+  enum class Key
+  {
+    title,
+    duration,
+    path,
+    dateAdded
+  };
+  static constexpr int numKeys = 4;
+
+  LibrarySort(const TrackStore& _trackStore);
+  ~LibrarySort();
+
+  // Called along with TrackStore's add(), remove() and clear() (trackRemoved() after the track has been removed from the store)
+  void trackAdded(TrackStore::TrackId id);
+  void trackRemoved(TrackStore::TrackId id);
+  void clear();
+
+  // Every track in the store, first to last by 'key' (tracks that tie stay in the order they were added)
+  const std::vector<TrackStore::TrackId>& getOrder(Key key);
+
+  // Puts 'ids' (tracks in the store, each listed once) in the same order as getOrder()
+  void sortIds(Key key, std::vector<TrackStore::TrackId>& ids);
+
+  // Brings every key's order up to date (eg. once an import finishes, so the first click on a header is instant too)
+  void prepareAll();
+
+private:
+  struct Order
+  {
+    std::vector<TrackStore::TrackId> ids;
+    std::vector<TrackStore::TrackId> addedIds; // Added since 'ids' was sorted
+    std::vector<juce::uint32> positions;       // Where each ID is in 'ids' (indexed by ID), still in the same order once removed tracks are dropped
+    bool isBuilt = false;
+    bool arePositionsValid = false;
+    bool hasRemovals = false;                  // 'ids' and 'addedIds' may still hold tracks removed from the store
+  };
+
+  bool isBefore(Key key, TrackStore::TrackId a, TrackStore::TrackId b) const;
+  Order& getUpToDate(Key key);
+
+  const TrackStore& trackStore;
+  Order orders[numKeys];
+
+  // Marks which IDs are in 'sortIds()'s set, when it is big enough to pick them out of the whole order instead
+  std::vector<bool> isInSet;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibrarySort)
+};
@@ -0,0 +1,162 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include "LookAheadLimiter.h"
+
+LookAheadLimiter::LookAheadLimiter()
+{
+  // Windowed sinc for each fraction of a sample (phase 0 is the sample itself), centred between the 4th and 5th newest samples
+  const float centre = (interpolatorTaps / 2) - 1.0f;
+  for (int phase = 0; phase < oversampling; ++phase)
+  {
+    float sum = 0.0f;
+    for (int tap = 0; tap < interpolatorTaps; ++tap)
+    {
+      float distance = (centre + (phase / static_cast<float>(oversampling))) - tap;
+      float sinc = distance == 0.0f ? 1.0f : std::sin(juce::MathConstants<float>::pi * distance) / (juce::MathConstants<float>::pi * distance);
+      float window = 0.5f * (1.0f + std::cos(juce::MathConstants<float>::pi * distance / ((interpolatorTaps / 2) + 0.5f)));
+      interpolator[phase][tap] = sinc * window;
+      sum += interpolator[phase][tap];
+    }
+
+    // Unity gain at DC for every phase
+    for (int tap = 0; tap < interpolatorTaps; ++tap) interpolator[phase][tap] /= sum;
+  }
+}
+
+LookAheadLimiter::~LookAheadLimiter()
+{
+}
+
+void LookAheadLimiter::prepare(double sampleRate)
+{
+  ceiling = juce::Decibels::decibelsToGain(ceilingDb);
+  releaseCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate)));
+  lookAheadSamples = juce::jmax(1, juce::roundToInt(lookAheadSeconds * sampleRate));
+
+  for (std::vector<float>& delayLine : delayLines) delayLine.assign(static_cast<size_t>(getLatencyInSamples()), 0.0f);
+  minimumGains.assign(static_cast<size_t>(lookAheadSamples + 2), 1.0f);
+  minimumExpiries.assign(static_cast<size_t>(lookAheadSamples + 2), 0);
+  averageWindow.assign(static_cast<size_t>(lookAheadSamples), 1.0f);
+
+  reset();
+}
+
+void LookAheadLimiter::reset()
+{
+  for (auto& channelHistory : history) std::fill(std::begin(channelHistory), std::end(channelHistory), 0.0f);
+  historyPosition = 0;
+
+  for (std::vector<float>& delayLine : delayLines) std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+  delayPosition = 0;
+
+  minimumHead = 0;
+  minimumSize = 0;
+  sampleCounter = 0;
+
+  releasedGain = 1.0f;
+  std::fill(averageWindow.begin(), averageWindow.end(), 1.0f);
+  averagePosition = 0;
+  averageSum = static_cast<double>(averageWindow.size());
+
+  gainReductionDb.store(0.0f);
+}
+
+int LookAheadLimiter::getLatencyInSamples() const
+{
+  // The interpolator looks half its length into the "future" too
+  return lookAheadSamples + (interpolatorTaps / 2);
+}
+
+float LookAheadLimiter::getGainReductionSinceLastRead()
+{
+  return gainReductionDb.exchange(0.0f);
+}
+
+float LookAheadLimiter::getTruePeak()
+{
+  float truePeak = 0.0f;
+  for (int channel = 0; channel < maxChannels; ++channel)
+  {
+    // Oldest sample first
+    const float* samples = history[channel] + historyPosition;
+    for (int phase = 0; phase < oversampling; ++phase)
+    {
+      float value = 0.0f;
+      for (int tap = 0; tap < interpolatorTaps; ++tap) value += samples[tap] * interpolator[phase][tap];
+      truePeak = juce::jmax(truePeak, std::abs(value));
+    }
+  }
+
+  return truePeak;
+}
+
+void LookAheadLimiter::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  if (delayLines[0].empty() || numSamples <= 0) return;
+
+  int numChannels = juce::jmin(maxChannels, buffer.getNumChannels());
+  float* channels[maxChannels] = {};
+  for (int channel = 0; channel < numChannels; ++channel) channels[channel] = buffer.getWritePointer(channel, startSample);
+
+  int delayLength = static_cast<int>(delayLines[0].size());
+  int minimumCapacity = static_cast<int>(minimumGains.size());
+  float smallestGain = 1.0f;
+
+  for (int i = 0; i < numSamples; ++i)
+  {
+    // Newest sample into the interpolator's history (a missing channel counts as silence)
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+      float sample = channel < numChannels ? channels[channel][i] : 0.0f;
+      history[channel][historyPosition] = sample;
+      history[channel][historyPosition + interpolatorTaps] = sample;
+    }
+    historyPosition = (historyPosition + 1) % interpolatorTaps;
+
+    float truePeak = getTruePeak();
+    float neededGain = truePeak > ceiling ? ceiling / truePeak : 1.0f;
+
+    // Smallest gain needed over the last 'lookAheadSamples' + 1 samples
+    while (minimumSize > 0 && minimumGains[static_cast<size_t>((minimumHead + minimumSize - 1) % minimumCapacity)] >= neededGain) --minimumSize;
+    int tail = (minimumHead + minimumSize) % minimumCapacity;
+    minimumGains[static_cast<size_t>(tail)] = neededGain;
+    minimumExpiries[static_cast<size_t>(tail)] = sampleCounter + lookAheadSamples + 1;
+    ++minimumSize;
+    while (minimumExpiries[static_cast<size_t>(minimumHead)] <= sampleCounter)
+    {
+      minimumHead = (minimumHead + 1) % minimumCapacity;
+      --minimumSize;
+    }
+    ++sampleCounter;
+    float heldGain = minimumGains[static_cast<size_t>(minimumHead)];
+
+    // Drops straight away, recovers slowly
+    if (heldGain < releasedGain) releasedGain = heldGain;
+    else releasedGain += (heldGain - releasedGain) * releaseCoefficient;
+
+    // Averaging over the look-ahead ramps the gain down ahead of the peak (and never above what the peak needs)
+    averageSum += releasedGain - averageWindow[static_cast<size_t>(averagePosition)];
+    averageWindow[static_cast<size_t>(averagePosition)] = releasedGain;
+    averagePosition = (averagePosition + 1) % lookAheadSamples;
+    float gain = juce::jmin(1.0f, static_cast<float>(averageSum / lookAheadSamples));
+    smallestGain = juce::jmin(smallestGain, gain);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      float& delayed = delayLines[channel][static_cast<size_t>(delayPosition)];
+      float output = delayed * gain;
+      delayed = channels[channel][i];
+      channels[channel][i] = output;
+    }
+    delayPosition = (delayPosition + 1) % delayLength;
+  }
+
+  // Sums drift a little over time, so it is worked out again from scratch once per block
+  averageSum = 0.0;
+  for (float windowGain : averageWindow) averageSum += windowGain;
+
+  float reductionDb = juce::Decibels::gainToDecibels(smallestGain, -100.0f);
+  float previous = gainReductionDb.load();
+  while (reductionDb < previous && !gainReductionDb.compare_exchange_weak(previous, reductionDb)) {}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+/*
+Keeps the true peak of a stereo signal under 'ceilingDb' without clipping it.
+1. true peak is estimated by 4x oversampling each channel (a short windowed-sinc interpolator), so peaks between samples are caught too
+2. audio is delayed by 'lookAheadSeconds', so the gain can start coming down before a peak arrives instead of cutting it off
+3. the gain needed is held for the whole look-ahead window and then averaged over it, which ramps it down smoothly and still lands on the peak exactly
+4. once a peak has passed, the gain recovers over 'releaseSeconds'
+*/
+class LookAheadLimiter
+{
+public:
+  LookAheadLimiter();
+  ~LookAheadLimiter();
+
+  // Called before audio starts
+  void prepare(double sampleRate);
+  void reset();
+
+  // Audio thread only, limits the first 'maxChannels' channels in place (delayed by getLatencyInSamples())
+  void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  // How far the output lags behind the input
+  int getLatencyInSamples() const;
+
+  // Any thread, most gain reduction in dB (0 or below) since the last call
+  float getGainReductionSinceLastRead();
+
+  static constexpr int maxChannels = 2;
+  static constexpr float ceilingDb = -1.0f;
+  static constexpr double lookAheadSeconds = 0.002;
+  static constexpr double releaseSeconds = 0.1;
+
+  // 4x oversampling, 8 input samples per interpolated point
+  static constexpr int oversampling = 4;
+  static constexpr int interpolatorTaps = 8;
+
+private:
+  // Highest estimated true peak (across channels) around the newest sample
+  float getTruePeak();
+
+  float ceiling = 1.0f;
+  float releaseCoefficient = 0.0f;
+  int lookAheadSamples = 0;
+  float interpolator[oversampling][interpolatorTaps];
+
+  // Last 'interpolatorTaps' input samples per channel (written twice, so the newest ones are always in one straight run)
+  float history[maxChannels][interpolatorTaps * 2] = {};
+  int historyPosition = 0;
+
+  // Input delayed by the look-ahead (plus the interpolator's own delay)
+  std::vector<float> delayLines[maxChannels];
+  int delayPosition = 0;
+
+  // Smallest gain needed over the look-ahead window (a monotonic queue of gains, oldest first, with when each leaves the window)
+  std::vector<float> minimumGains;
+  std::vector<juce::int64> minimumExpiries;
+  int minimumHead = 0;
+  int minimumSize = 0;
+  juce::int64 sampleCounter = 0;
+
+  // Released gain, then its average over the look-ahead window
+  float releasedGain = 1.0f;
+  std::vector<float> averageWindow;
+  int averagePosition = 0;
+  double averageSum = 0.0;
+
+  std::atomic<float> gainReductionDb{ 0.0f };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LookAheadLimiter)
+};
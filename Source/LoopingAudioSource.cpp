@@ -0,0 +1,181 @@
+#include <JuceHeader.h>
+#include "LoopingAudioSource.h"
+
+LoopingAudioSource::LoopingAudioSource(std::unique_ptr<juce::PositionableAudioSource> _input,
+                                       const LoopSettings& _loopSettings,
+                                       double _sourceSampleRate)
+  : ownedInput(std::move(_input)),
+    loopSettings(_loopSettings),
+    sourceSampleRate(_sourceSampleRate)
+{
+  input = ownedInput.get();
+
+  // 5ms is short enough not to be heard as a fade, but long enough to hide the click
+  crossfadeLength = juce::jmax(1, juce::roundToInt(sourceSampleRate * 0.005));
+  crossfadePosition = crossfadeLength;
+
+  fadeInCurve.resize(static_cast<size_t>(crossfadeLength));
+  for (int i = 0; i < crossfadeLength; ++i)
+  {
+    fadeInCurve[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (i + 0.5f) / crossfadeLength);
+  }
+
+  tailBuffer.setSize(2, crossfadeLength);
+  tailBuffer.clear();
+}
+
+LoopingAudioSource::~LoopingAudioSource()
+{
+}
+
+void LoopingAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+  const juce::ScopedLock sl(replaceLock);
+  preparedBlockSize = samplesPerBlockExpected;
+  preparedSampleRate = sampleRate;
+
+  ownedInput->prepareToPlay(samplesPerBlockExpected, sampleRate);
+  if (pendingInput != nullptr) pendingInput->prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void LoopingAudioSource::releaseResources()
+{
+  const juce::ScopedLock sl(replaceLock);
+  preparedSampleRate = 0.0;
+
+  ownedInput->releaseResources();
+  if (pendingInput != nullptr) pendingInput->releaseResources();
+}
+
+void LoopingAudioSource::replaceInput(std::unique_ptr<juce::PositionableAudioSource> newInput)
+{
+  const juce::ScopedLock sl(replaceLock);
+
+  // Prepared here, so taking over on the audio thread is only swapping pointers (and started from about where playback is, so one that reads ahead
+  // from disk is already buffering the right part of the track when it takes over)
+  newInput->setNextReadPosition(input.load()->getNextReadPosition());
+  if (preparedSampleRate > 0) newInput->prepareToPlay(preparedBlockSize, preparedSampleRate);
+  replacedInput.reset();
+  pendingInput = std::move(newInput);
+}
+
+void LoopingAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  if (crossfadeCancelled.exchange(false)) crossfadePosition = crossfadeLength;
+
+  // A replacement takes over from exactly where the old input got to (or on the next block, if the message thread is handing one over right now)
+  {
+    const juce::ScopedTryLock sl(replaceLock);
+    if (sl.isLocked() && pendingInput != nullptr)
+    {
+      jassert(replacedInput == nullptr);
+      pendingInput->setNextReadPosition(ownedInput->getNextReadPosition());
+      replacedInput = std::move(ownedInput);
+      ownedInput = std::move(pendingInput);
+      input = ownedInput.get();
+    }
+  }
+  juce::PositionableAudioSource* source = ownedInput.get();
+
+  juce::int64 loopStart = 0;
+  juce::int64 loopEnd = 0;
+  const bool looping = getLoopRange(loopStart, loopEnd);
+
+  int samplesDone = 0;
+  while (samplesDone < bufferToFill.numSamples)
+  {
+    const juce::int64 position = source->getNextReadPosition();
+    int numToRead = bufferToFill.numSamples - samplesDone;
+
+    // Stop exactly at the loop's end (only when playing towards it, so a loop set behind the play position does not jump back)
+    const bool reachesLoopEnd = looping && position < loopEnd && position + numToRead >= loopEnd;
+    if (reachesLoopEnd) numToRead = static_cast<int>(loopEnd - position);
+
+    if (numToRead > 0)
+    {
+      juce::AudioSourceChannelInfo part(bufferToFill.buffer, bufferToFill.startSample + samplesDone, numToRead);
+      source->getNextAudioBlock(part);
+      applyCrossfade(part);
+      samplesDone += numToRead;
+    }
+
+    if (reachesLoopEnd)
+    {
+      // Keep what would have played next, to fade it out over the start of the loop
+      juce::AudioSourceChannelInfo tail(&tailBuffer, 0, crossfadeLength);
+      source->getNextAudioBlock(tail);
+
+      source->setNextReadPosition(loopStart);
+      crossfadePosition = 0;
+    }
+  }
+}
+
+void LoopingAudioSource::applyCrossfade(const juce::AudioSourceChannelInfo& info)
+{
+  if (crossfadePosition >= crossfadeLength) return;
+
+  const int numToFade = juce::jmin(info.numSamples, crossfadeLength - crossfadePosition);
+  const float* fadeIn = fadeInCurve.data() + crossfadePosition;
+
+  for (int channel = 0; channel < info.buffer->getNumChannels(); ++channel)
+  {
+    float* output = info.buffer->getWritePointer(channel, info.startSample);
+    const float* tail = tailBuffer.getReadPointer(juce::jmin(channel, tailBuffer.getNumChannels() - 1), crossfadePosition);
+
+    for (int i = 0; i < numToFade; ++i) output[i] = output[i] * fadeIn[i] + tail[i] * (1.0f - fadeIn[i]);
+  }
+
+  crossfadePosition += numToFade;
+}
+
+void LoopingAudioSource::setNextReadPosition(juce::int64 newPosition)
+{
+  crossfadeCancelled = true;
+  input.load()->setNextReadPosition(newPosition);
+}
+
+juce::int64 LoopingAudioSource::getNextReadPosition() const
+{
+  return input.load()->getNextReadPosition();
+}
+
+juce::int64 LoopingAudioSource::getTotalLength() const
+{
+  return input.load()->getTotalLength();
+}
+
+bool LoopingAudioSource::isLooping() const
+{
+  // Stops juce::AudioTransportSource from treating the end of the track as the end of playback (unless already past the loop)
+  juce::int64 loopStart = 0;
+  juce::int64 loopEnd = 0;
+  return getLoopRange(loopStart, loopEnd) && input.load()->getNextReadPosition() <= loopEnd;
+}
+
+bool LoopingAudioSource::getLoopRange(juce::int64& loopStart, juce::int64& loopEnd) const
+{
+  if (!loopSettings.enabled.load()) return false;
+
+  const juce::int64 totalLength = input.load()->getTotalLength();
+  const double endSeconds = loopSettings.endSeconds.load();
+
+  // Whole track
+  if (endSeconds < 0)
+  {
+    loopStart = 0;
+    loopEnd = totalLength;
+  }
+  // In and out points
+  else
+  {
+    loopStart = juce::jlimit(static_cast<juce::int64>(0), totalLength, static_cast<juce::int64>(loopSettings.startSeconds.load() * sourceSampleRate));
+    loopEnd = juce::jlimit(static_cast<juce::int64>(0), totalLength, static_cast<juce::int64>(endSeconds * sourceSampleRate));
+  }
+
+  // The seam fades out what comes after the loop's end, so a loop that reaches the end of the track (where that is silence) ends one crossfade early
+  loopEnd = juce::jmin(loopEnd, totalLength - crossfadeLength);
+
+  // Too short to fit the crossfade (also catches an out point before the in point)
+  return loopEnd - loopStart >= static_cast<juce::int64>(crossfadeLength) * 2;
+}
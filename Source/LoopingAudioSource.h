@@ -0,0 +1,69 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+/*
+Loops its input inside the audio thread, so the jump back is sample-accurate.
+1. loops the whole track, or the region between 'startSeconds' and 'endSeconds'
+2. at the seam, the audio just past the loop's end is faded out while the loop's start fades in (no click), so a loop up to the end of the track ends 5ms early
+3. its input can be replaced while playing (eg. a streamed track by its copy in RAM), which the audio thread does at the start of a block, from where the old input had got to
+*/
+class LoopingAudioSource : public juce::PositionableAudioSource
+{
+public:
+  // Owned by DJAudioPlayer, so the settings carry over when a new track is loaded
+  struct LoopSettings
+  {
+    std::atomic<bool> enabled{ false };
+    std::atomic<double> startSeconds{ 0.0 };
+    std::atomic<double> endSeconds{ -1.0 }; // Less than 0 means loop the whole track
+  };
+
+  LoopingAudioSource(std::unique_ptr<juce::PositionableAudioSource> _input,
+                     const LoopSettings& _loopSettings,
+                     double _sourceSampleRate);
+  ~LoopingAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  void setNextReadPosition(juce::int64 newPosition) override;
+  juce::int64 getNextReadPosition() const override;
+  juce::int64 getTotalLength() const override;
+  bool isLooping() const override;
+
+  // Loop region in samples (returns false if looping is off, or the region is too short to loop)
+  bool getLoopRange(juce::int64& loopStart, juce::int64& loopEnd) const;
+
+  // Called on the message thread, 'newInput' must be the same audio (eg. the same track decoded into RAM) at the same sample rate
+  // The old input is kept until the next replacement (or until this source is deleted), so it is never deleted on the audio thread
+  void replaceInput(std::unique_ptr<juce::PositionableAudioSource> newInput);
+
+private:
+  // Applies the seam's crossfade to the start of what was just read
+  void applyCrossfade(const juce::AudioSourceChannelInfo& info);
+
+  // Read through 'input' (the message thread reads positions and lengths while the audio thread may be swapping it)
+  std::unique_ptr<juce::PositionableAudioSource> ownedInput;
+  std::atomic<juce::PositionableAudioSource*> input{ nullptr };
+  const LoopSettings& loopSettings;
+
+  // Waiting to take over from 'ownedInput', and the one it took over from (both guarded by 'replaceLock', which the audio thread only ever tries to take)
+  juce::CriticalSection replaceLock;
+  std::unique_ptr<juce::PositionableAudioSource> pendingInput;
+  std::unique_ptr<juce::PositionableAudioSource> replacedInput;
+  int preparedBlockSize = 0;
+  double preparedSampleRate = 0.0;
+  double sourceSampleRate;
+
+  // Audio just past the loop's end, faded out over the first 'crossfadeLength' samples after each jump back
+  int crossfadeLength;
+  std::vector<float> fadeInCurve; // Raised cosine, the tail fades out by (1 - fadeInCurve)
+  juce::AudioBuffer<float> tailBuffer;
+  int crossfadePosition; // Only used on the audio thread
+  std::atomic<bool> crossfadeCancelled{ false }; // Set by a seek, so the old tail is not faded into the new position
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopingAudioSource)
+};
@@ -1,5 +1,6 @@
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
 
 class OtoDecksApplication : public juce::JUCEApplication
 {
@@ -25,6 +26,14 @@ public:
 
   void initialise(const juce::String& commandLine) override
   {
+    // Render a timeline script to a WAV file instead (no window or sound card needed), eg. "OtoDecks --render mix.txt mix.wav"
+    if (getCommandLineParameterArray().contains("--render"))
+    {
+      setApplicationReturnValue(OfflineRenderer::runFromCommandLine(getCommandLineParameterArray()));
+      quit();
+      return;
+    }
+
     mainWindow.reset(new MainWindow(getApplicationName()));
   }
 
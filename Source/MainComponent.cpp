@@ -11,11 +11,11 @@ MainComponent::MainComponent()
   else setAudioChannels(0, 2);
 
   formatManager.registerBasicFormats();
+  readAheadThread.startThread(juce::Thread::Priority::high);
 
   // Main components
-  addAndMakeVisible(deckGUI1);
-  addAndMakeVisible(deckGUI2);
   addAndMakeVisible(playlistComponent);
+  while (deckManager.getNumDecks() < minDecks) addDeck();
 
   // Add-ons
   addAndMakeVisible(crossfadeSliderLabel);
@@ -29,35 +29,60 @@ MainComponent::MainComponent()
   crossfadeSlider.setValue(crossfadeDefaultValue);
   crossfadeSlider.setDoubleClickReturnValue(true, crossfadeDefaultValue);
 
-  // calls timerCallback() at the bottom of this .cpp
-  startTimer(1);
+  addAndMakeVisible(addDeckButton);
+  addDeckButton.onClick = [this]() { addDeck(); };
+  addAndMakeVisible(removeDeckButton);
+  removeDeckButton.onClick = [this]() { removeDeck(); };
+
+  addAndMakeVisible(crossfadeCurveButton);
+  crossfadeCurveButton.onClick = [this]()
+    {
+      int nextCurve = (static_cast<int>(deckManager.getMixer().getCrossfadeCurve()) + 1) % DeckMixerAudioSource::numCrossfadeCurves;
+      deckManager.getMixer().setCrossfadeCurve(static_cast<DeckMixerAudioSource::CrossfadeCurve>(nextCurve));
+      updateCrossfadeCurveButton();
+    };
+  updateCrossfadeCurveButton();
+
+  addAndMakeVisible(masterMeter);
+  masterMeter.setMeter(&masterBus.getMeter());
+
+  addAndMakeVisible(parallelButton);
+  parallelButton.setClickingTogglesState(true);
+  int numWorkerThreads = juce::jlimit(1, DeckManager::maxDecks - 1, juce::SystemStats::getNumCpus() - 1);
+  parallelButton.setTooltip("Render decks on " + juce::String(numWorkerThreads) + " extra thread(s) as well as the audio thread");
+  parallelButton.onClick = [this, numWorkerThreads]()
+    {
+      deckManager.getMixer().setNumWorkerThreads(parallelButton.getToggleState() ? numWorkerThreads : 0);
+    };
+  updateDeckButtons();
+
+  // Load a file from playlistComponent into the chosen DeckGUI
+  playlistComponent.onLoadToDeck = [this](int deckNumber, std::string fileURL)
+    {
+      if (DeckGUI* deckGUI = deckGUIs[deckNumber - 1]) deckGUI->loadFromPlaylist(fileURL);
+    };
 }
 
 MainComponent::~MainComponent()
 {
-  stopTimer();
   shutdownAudio();
+  readAheadThread.stopThread(1'000);
 }
 
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-  player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-  mixerSource.addInputSource(&player1, false);
-  mixerSource.addInputSource(&player2, false);
+  // Also prepares the mixer and every deck (and any deck added later, as it is added)
+  masterBus.prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-  mixerSource.getNextAudioBlock(bufferToFill);
+  masterBus.getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
 {
-  player1.releaseResources();
-  player2.releaseResources();
-  mixerSource.releaseResources();
+  masterBus.releaseResources();
 }
 
 void MainComponent::paint(juce::Graphics& g)
@@ -71,24 +96,38 @@ void MainComponent::paint(juce::Graphics& g)
   crossfadeSlider.setColour(juce::Slider::thumbColourId, juce::Colours::white);
   
   // Filled (left side)
-  crossfadeSlider.setColour(juce::Slider::trackColourId, colour2);
+  crossfadeSlider.setColour(juce::Slider::trackColourId, deckColours[1]);
   
   // Empty (right side)
-  crossfadeSlider.setColour(juce::Slider::backgroundColourId, colour1);
+  crossfadeSlider.setColour(juce::Slider::backgroundColourId, deckColours[0]);
 }
 
 void MainComponent::resized()
 {
   double oneThirdHeight = getHeight() / static_cast<double>(3);
   double halfWidth = getWidth() / static_cast<double>(2);
-  deckGUI1.setBounds(0, 0, halfWidth , oneThirdHeight * 2);
-  deckGUI2.setBounds(deckGUI1.getX() + deckGUI1.getWidth(), deckGUI1.getY(), halfWidth, oneThirdHeight * 2);
+
+  // Decks fill the top two thirds, side by side in one row (up to 2 decks) or two rows (more than 2 decks)
+  int numDecks = juce::jmax(1, deckGUIs.size());
+  int numRows = numDecks > 2 ? 2 : 1;
+  int numCols = (numDecks + numRows - 1) / numRows;
+  double deckWidth = getWidth() / static_cast<double>(numCols);
+  double deckHeight = (oneThirdHeight * 2) / numRows;
+  for (int i = 0; i < deckGUIs.size(); ++i)
+    deckGUIs[i]->setBounds((i % numCols) * deckWidth, (i / numCols) * deckHeight, deckWidth, deckHeight);
   
-  double cellHeight = (oneThirdHeight * 2) / 25; // Ensure this calculates the same as DeckGUI::resized()'s 'cellHeight' variable
+  double cellHeight = deckHeight / 25; // Ensure this calculates the same as DeckGUI::resized()'s 'cellHeight' variable
   double textWidth = (crossfadeSliderLabel.getFont().getStringWidth(crossfadeSliderLabel.getText())) * 2;
   double crossfadeSliderWidth = getWidth() / static_cast<double>(4);
   crossfadeSliderLabel.setBounds(halfWidth - (textWidth / 2), (oneThirdHeight * 2) - (cellHeight * 1.75), textWidth, cellHeight);
   crossfadeSlider.setBounds(halfWidth - (crossfadeSliderWidth / 2), (oneThirdHeight * 2) - (cellHeight * 1.25), crossfadeSliderWidth, cellHeight);
+
+  // Either side of 'crossfadeSliderLabel'
+  removeDeckButton.setBounds(crossfadeSliderLabel.getX() - textWidth, crossfadeSliderLabel.getY(), textWidth, cellHeight * 0.75);
+  crossfadeCurveButton.setBounds(removeDeckButton.getX() - textWidth, crossfadeSliderLabel.getY(), textWidth, cellHeight * 0.75);
+  addDeckButton.setBounds(crossfadeSliderLabel.getRight(), crossfadeSliderLabel.getY(), textWidth, cellHeight * 0.75);
+  parallelButton.setBounds(addDeckButton.getRight(), crossfadeSliderLabel.getY(), textWidth, cellHeight * 0.75);
+  masterMeter.setBounds(parallelButton.getRight(), crossfadeSliderLabel.getY(), textWidth * 1.5, cellHeight * 0.75);
   
   double margin = 10;
   playlistComponent.setBounds((margin * 1.5), oneThirdHeight * 2, getWidth() - (margin * 3), oneThirdHeight - (margin * 2));
@@ -96,34 +135,81 @@ void MainComponent::resized()
 
 void MainComponent::sliderValueChanged(juce::Slider* slider)
 {
-  if (slider == &crossfadeSlider)
+  // Make max values = 1 (the mixer works out each deck's gain from this and its fader on the audio thread)
+  if (slider == &crossfadeSlider) deckManager.getMixer().setCrossfadePosition(static_cast<float>(slider->getValue() / 100));
+}
+
+void MainComponent::updateCrossfadeCurveButton()
+{
+  switch (deckManager.getMixer().getCrossfadeCurve())
   {
-    // Make max values = 1 for accurate setGain() adjustment
-    double deck1Value = deckGUI1.volSlider.getValue() / 100;
-    double deck2Value = deckGUI2.volSlider.getValue() / 100;
-    double crossfadeSliderValue = slider->getValue() / 100;
-
-    // Map gain amount
-    double player1Gain = juce::jmap(crossfadeSliderValue, -1.0, 1.0, deck1Value, 0.0);
-    double player2Gain = juce::jmap(crossfadeSliderValue, -1.0, 1.0, 0.0, deck2Value);
-
-    // Set gain
-    player1.setGain(player1Gain);
-    player2.setGain(player2Gain);
+    case DeckMixerAudioSource::CrossfadeCurve::linear:
+      crossfadeCurveButton.setButtonText("Linear");
+      crossfadeCurveButton.setTooltip("Crossfade curve: linear (quieter in the middle)");
+      break;
+
+    case DeckMixerAudioSource::CrossfadeCurve::constantPower:
+      crossfadeCurveButton.setButtonText("Power");
+      crossfadeCurveButton.setTooltip("Crossfade curve: constant power (same loudness across the fade)");
+      break;
+
+    case DeckMixerAudioSource::CrossfadeCurve::sharpCut:
+      crossfadeCurveButton.setButtonText("Cut");
+      crossfadeCurveButton.setTooltip("Crossfade curve: sharp cut (both decks at full volume until the very end, for scratching)");
+      break;
   }
 }
 
-// Check if user is loading a file from playlistComponent to DeckGUI
-void MainComponent::timerCallback()
+void MainComponent::addDeck()
 {
-  // If playlistComp's 'loadToDeck' bool variable is true, then do the following
-  if (playlistComponent.loadToDeck)
-  {
-    // Depending on playlistComp's 'deckNumber' int variable, call corresponding deckGUI and its function
-    if (playlistComponent.deckNumber == 1) deckGUI1.loadFromPlaylist(playlistComponent.fileURL);
-    if (playlistComponent.deckNumber == 2) deckGUI2.loadFromPlaylist(playlistComponent.fileURL);
+  DJAudioPlayer* player = deckManager.addDeck();
+  if (player == nullptr) return;
 
-    // Reset bool variable
-    playlistComponent.loadToDeck = false;
-  }
+  int deckIndex = deckGUIs.size();
+  DeckGUI* deckGUI = deckGUIs.add(new DeckGUI(player, peakFileStore, deckColours[deckIndex]));
+  addAndMakeVisible(deckGUI);
+
+  // Its 'volSlider' moves its fader in the mixer
+  deckGUI->onVolumeChanged = [this, deckIndex](double level) { deckManager.getMixer().setFaderLevel(deckIndex, static_cast<float>(level)); };
+  deckManager.getMixer().setFaderLevel(deckIndex, static_cast<float>(deckGUI->volSlider.getValue() / 100));
+  deckGUI->setLevelMeter(&deckManager.getMixer().getInputMeter(deckIndex));
+
+  // Playlist gets a 'Load' column for the new deck
+  playlistComponent.setDeckColours(juce::Array<juce::Colour>(deckColours.begin(), deckGUIs.size()));
+
+  updateDeckButtons();
+  resized();
+}
+
+void MainComponent::removeDeck()
+{
+  if (deckGUIs.size() <= minDecks) return;
+
+  // DeckGUI uses its player, so it goes first
+  deckGUIs.removeLast();
+  deckManager.removeLastDeck();
+  playlistComponent.setDeckColours(juce::Array<juce::Colour>(deckColours.begin(), deckGUIs.size()));
+
+  updateDeckButtons();
+  resized();
+}
+
+void MainComponent::updateDeckButtons()
+{
+  addDeckButton.setEnabled(deckManager.getNumDecks() < DeckManager::maxDecks);
+  removeDeckButton.setEnabled(deckManager.getNumDecks() > minDecks);
+}
+
+void MainComponent::vBlankCallback()
+{
+  masterMeter.update();
+
+  // Limiter's details only need updating once a second
+  juce::uint32 now = juce::Time::getMillisecondCounter();
+  if (now - lastMasterInfoTime < 1'000) return;
+  lastMasterInfoTime = now;
+
+  masterMeter.setExtraInfo("Limiter: " + juce::String(masterBus.getGainReductionSinceLastRead(), 1) + " dB gain reduction, "
+                           + juce::String(masterBus.getLatencyInSeconds() * 1'000, 1) + " ms latency (" + juce::String(masterBus.getLatencyInSamples()) + " samples), "
+                           + juce::String(masterBus.getLimiterLoad() * 100, 2) + "% CPU");
 }
@@ -1,12 +1,14 @@
 #pragma once
 #include <JuceHeader.h>
 #include "DJAudioPlayer.h"
+#include "DeckManager.h"
 #include "DeckGUI.h"
+#include "MasterBusAudioSource.h"
+#include "LevelMeterComponent.h"
 #include "PlaylistComponent.h"
 
 class MainComponent : public juce::AudioAppComponent,
-                      public juce::Slider::Listener,
-                      public juce::Timer
+                      public juce::Slider::Listener
 {
 public:
   MainComponent();
@@ -21,31 +23,62 @@ public:
 
   void sliderValueChanged(juce::Slider* slider) override;
 
-  // Check if user is loading a file from playlistComponent to DeckGUI
-  void timerCallback() override;
-
 private:
   // Variables for MainComponent and DeckGUI to work
   juce::AudioFormatManager formatManager;
-  juce::AudioThumbnailCache thumbnailCache{ 100 }; // Refers to saving '100' files in cache
-  juce::MixerAudioSource mixerSource;
 
-  // Deck 1 (left side)
-  DJAudioPlayer player1{ formatManager };
-  juce::Colour colour1 = juce::Colour::fromRGB(0, 120, 255);
-  DeckGUI deckGUI1{ &player1, formatManager, thumbnailCache, colour1 };
+  // Shared by every deck's waveforms (peak files are kept on disk, so reloading a track shows its waveform straight away)
+  PeakFileStore peakFileStore{ formatManager, juce::File::getCurrentWorkingDirectory().getChildFile("peak-cache") };
+
+  // Shared by every deck to decode audio ahead of the play position (so the audio thread never reads from disk)
+  juce::TimeSliceThread readAheadThread{ "Deck read-ahead" };
+
+  // Shared by every deck for tracks loaded into RAM (least recently used tracks are evicted past the memory budget)
+  DecodedTrackCache decodedTrackCache;
+
+  // Creates and mixes the decks, each of which gets a DeckGUI in 'deckGUIs' (same order)
+  DeckManager deckManager{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+  juce::OwnedArray<DeckGUI> deckGUIs;
+
+  // The mix goes through a limiter (so decks at full gain do not clip) and is metered, before it reaches the audio device
+  MasterBusAudioSource masterBus{ &deckManager.getMixer() };
+  LevelMeterComponent masterMeter{ juce::Colours::white.darker() };
+  juce::uint32 lastMasterInfoTime = 0;
 
-  // Deck 2 (right side)
-  DJAudioPlayer player2{ formatManager };
-  juce::Colour colour2 = juce::Colour::fromRGB(255, 120, 0);
-  DeckGUI deckGUI2{ &player2, formatManager, thumbnailCache, colour2 };
+  // One colour per deck, in the order they are added (odd-numbered decks are on the crossfade's left, even-numbered on its right)
+  juce::Array<juce::Colour> deckColours{ juce::Colour::fromRGB(0, 120, 255), juce::Colour::fromRGB(255, 120, 0),
+                                         juce::Colour::fromRGB(0, 200, 120), juce::Colour::fromRGB(220, 60, 200),
+                                         juce::Colour::fromRGB(230, 200, 0), juce::Colour::fromRGB(0, 200, 220),
+                                         juce::Colour::fromRGB(255, 60, 90), juce::Colour::fromRGB(150, 110, 255) };
+
+  // Add or remove a deck (and its DeckGUI) while the app is running
+  juce::TextButton addDeckButton{ "Add Deck" };
+  juce::TextButton removeDeckButton{ "Remove Deck" };
+  void addDeck();
+  void removeDeck();
+  void updateDeckButtons();
+  int minDecks = 2;
+
+  // When on, decks are rendered in parallel on worker threads (one fewer than the number of CPUs, as the audio thread renders decks too)
+  juce::TextButton parallelButton{ "Multi-core" };
 
   // Crossfade slider below the deck
   juce::Label crossfadeSliderLabel{ "Crossfade", "Crossfade" };
   juce::Slider crossfadeSlider{ juce::Slider::SliderStyle::LinearHorizontal, juce::Slider::TextEntryBoxPosition::NoTextBox };
 
+  // Cycles through the crossfade curves (see DeckMixerAudioSource::CrossfadeCurve)
+  juce::TextButton crossfadeCurveButton;
+  void updateCrossfadeCurveButton();
+
   // PlaylistComponent below crossfade slider
-  PlaylistComponent playlistComponent{ colour1, colour2 };
+  PlaylistComponent playlistComponent;
+
+  // Shows the tooltips of every deck's buttons (eg. each deck's CPU use per tempo mode)
+  juce::TooltipWindow tooltipWindow{ this };
+
+  // Updates 'masterMeter' once per display refresh (declared last, so everything it uses already exists)
+  void vBlankCallback();
+  juce::VBlankAttachment vBlankAttachment{ this, [this]() { vBlankCallback(); } };
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
@@ -0,0 +1,70 @@
+#include <JuceHeader.h>
+#include "MasterBusAudioSource.h"
+
+MasterBusAudioSource::MasterBusAudioSource(juce::AudioSource* _input)
+  : input(_input)
+{
+  jassert(input != nullptr);
+}
+
+MasterBusAudioSource::~MasterBusAudioSource()
+{
+}
+
+void MasterBusAudioSource::prepareToPlay(int samplesPerBlockExpected, double _sampleRate)
+{
+  input->prepareToPlay(samplesPerBlockExpected, _sampleRate);
+
+  sampleRate = _sampleRate;
+  limiter.prepare(sampleRate);
+  meter.prepare(sampleRate);
+}
+
+void MasterBusAudioSource::releaseResources()
+{
+  input->releaseResources();
+}
+
+void MasterBusAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  input->getNextAudioBlock(bufferToFill);
+  if (bufferToFill.numSamples <= 0) return;
+
+  juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+  limiter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+  double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+  // Same smoothing as DJAudioPlayer's processing loads
+  if (sampleRate > 0)
+  {
+    float load = static_cast<float>(seconds / (bufferToFill.numSamples / sampleRate));
+    limiterLoad = (limiterLoad.load() == 0.0f) ? load : (limiterLoad.load() * 0.9f) + (load * 0.1f);
+  }
+
+  meter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+LevelMeter& MasterBusAudioSource::getMeter()
+{
+  return meter;
+}
+
+float MasterBusAudioSource::getGainReductionSinceLastRead()
+{
+  return limiter.getGainReductionSinceLastRead();
+}
+
+int MasterBusAudioSource::getLatencyInSamples() const
+{
+  return limiter.getLatencyInSamples();
+}
+
+double MasterBusAudioSource::getLatencyInSeconds() const
+{
+  return sampleRate > 0 ? limiter.getLatencyInSamples() / sampleRate : 0.0;
+}
+
+double MasterBusAudioSource::getLimiterLoad() const
+{
+  return limiterLoad.load();
+}
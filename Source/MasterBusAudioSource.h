@@ -0,0 +1,41 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include "LookAheadLimiter.h"
+#include "LevelMeter.h"
+
+/*
+Last stage before the audio device: the mix goes through a look-ahead limiter, then a level meter.
+1. the limiter keeps the mix's true peak under LookAheadLimiter::ceilingDb, so decks at full gain no longer clip
+2. the meter measures what is actually sent to the device (after the limiter)
+3. the limiter's share of each block's time is measured as it runs, so its cost can be shown alongside its latency
+*/
+class MasterBusAudioSource : public juce::AudioSource
+{
+public:
+  MasterBusAudioSource(juce::AudioSource* _input);
+  ~MasterBusAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  // Any thread
+  LevelMeter& getMeter();
+  float getGainReductionSinceLastRead();
+
+  // Limiter's delay, and its share of each block's time (smoothed over several blocks, 0 until audio has run)
+  int getLatencyInSamples() const;
+  double getLatencyInSeconds() const;
+  double getLimiterLoad() const;
+
+private:
+  juce::AudioSource* input;
+  LookAheadLimiter limiter;
+  LevelMeter meter;
+
+  double sampleRate = 0.0;
+  std::atomic<float> limiterLoad{ 0.0f };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterBusAudioSource)
+};
@@ -0,0 +1,295 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include <iostream>
+#include "OfflineRenderer.h"
+
+double OfflineRenderer::Stats::getRealTimeFactor() const
+{
+  return secondsTaken > 0 ? secondsRendered / secondsTaken : 0.0;
+}
+
+juce::Result OfflineRenderer::parseTimeline(const juce::String& script, const juce::File& baseDirectory, Timeline& timeline)
+{
+  timeline = Timeline();
+
+  juce::StringArray lines = juce::StringArray::fromLines(script);
+  for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex)
+  {
+    juce::String line = lines[lineIndex].upToFirstOccurrenceOf("#", false, false).trim();
+    if (line.isEmpty()) continue;
+
+    juce::String lineError = "Line " + juce::String(lineIndex + 1) + ": ";
+    juce::StringArray tokens = juce::StringArray::fromTokens(line, " \t", "\"");
+    tokens.removeEmptyStrings();
+
+    if (tokens[0] == "length")
+    {
+      timeline.lengthInSeconds = tokens[1].getDoubleValue();
+      if (tokens.size() != 2 || timeline.lengthInSeconds <= 0) return juce::Result::fail(lineError + "length needs a number of seconds above 0");
+      continue;
+    }
+
+    if (tokens.size() < 2 || !tokens[0].containsOnly("0123456789.")) return juce::Result::fail(lineError + "expected a time in seconds, then an action");
+
+    Event event;
+    event.timeInSeconds = tokens[0].getDoubleValue();
+    juce::String action = tokens[1];
+
+    // Everything but crossfade is done to one deck
+    if (action == "crossfade")
+    {
+      if (tokens.size() != 3) return juce::Result::fail(lineError + "crossfade needs a value from -1 to 1");
+      event.type = Event::Type::crossfade;
+      event.value = juce::jlimit(-1.0, 1.0, tokens[2].getDoubleValue());
+      timeline.events.push_back(event);
+      continue;
+    }
+
+    if (action == "curve")
+    {
+      const juce::StringArray curveNames{ "linear", "power", "cut" }; // In DeckMixerAudioSource::CrossfadeCurve's order
+      if (tokens.size() != 3 || !curveNames.contains(tokens[2])) return juce::Result::fail(lineError + "curve needs linear, power or cut");
+      event.type = Event::Type::crossfadeCurve;
+      event.value = curveNames.indexOf(tokens[2]);
+      timeline.events.push_back(event);
+      continue;
+    }
+
+    event.deck = tokens[2].getIntValue() - 1;
+    if (tokens.size() < 3 || event.deck < 0 || event.deck >= DeckManager::maxDecks) return juce::Result::fail(lineError + action + " needs a deck from 1 to " + juce::String(DeckManager::maxDecks));
+
+    // Actions with a single number after the deck
+    struct NumberAction
+    {
+      const char* name;
+      Event::Type type;
+    };
+    const NumberAction numberActions[] = { { "seek", Event::Type::seek }, { "gain", Event::Type::gain }, { "speed", Event::Type::speed },
+                                           { "low", Event::Type::lowFilter }, { "mid", Event::Type::midFilter }, { "high", Event::Type::highFilter } };
+
+    bool known = false;
+    for (const NumberAction& numberAction : numberActions)
+    {
+      if (action != numberAction.name) continue;
+      if (tokens.size() != 4) return juce::Result::fail(lineError + action + " needs a deck and a number");
+
+      event.type = numberAction.type;
+      event.value = tokens[3].getDoubleValue();
+      known = true;
+    }
+
+    if (action == "load")
+    {
+      if (tokens.size() != 4) return juce::Result::fail(lineError + "load needs a deck and a file (in quotes if it has spaces)");
+      event.type = Event::Type::load;
+      event.file = baseDirectory.getChildFile(tokens[3].unquoted());
+      known = true;
+    }
+    else if (action == "play" || action == "stop")
+    {
+      if (tokens.size() != 3) return juce::Result::fail(lineError + action + " only needs a deck");
+      event.type = (action == "play") ? Event::Type::play : Event::Type::stop;
+      known = true;
+    }
+    else if (action == "loop")
+    {
+      // A start below 0 turns looping off
+      event.type = Event::Type::loop;
+      if (tokens.size() == 4 && tokens[3] == "off") event.value = -1.0;
+      else if (tokens.size() == 5 && tokens[4].getDoubleValue() > tokens[3].getDoubleValue())
+      {
+        event.value = tokens[3].getDoubleValue();
+        event.secondValue = tokens[4].getDoubleValue();
+      }
+      else return juce::Result::fail(lineError + "loop needs a deck, then 'off' or a start and a later end in seconds");
+      known = true;
+    }
+
+    if (!known) return juce::Result::fail(lineError + "unknown action '" + action + "'");
+    timeline.events.push_back(event);
+  }
+
+  if (timeline.lengthInSeconds <= 0) return juce::Result::fail("The script needs a 'length <seconds>' line");
+
+  // Stable, so events at the same time keep the order they were written in
+  std::stable_sort(timeline.events.begin(), timeline.events.end(), [](const Event& a, const Event& b) { return a.timeInSeconds < b.timeInSeconds; });
+  return juce::Result::ok();
+}
+
+OfflineRenderer::OfflineRenderer(double _sampleRate, int _blockSize)
+  : sampleRate(_sampleRate),
+    blockSize(_blockSize)
+{
+  formatManager.registerBasicFormats();
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+juce::Result OfflineRenderer::render(const Timeline& timeline, const juce::File& outputFile, Stats& stats)
+{
+  stats = Stats();
+
+  outputFile.deleteFile();
+  std::unique_ptr<juce::FileOutputStream> outputStream = outputFile.createOutputStream();
+  if (outputStream == nullptr) return juce::Result::fail("Unable to write to " + outputFile.getFullPathName());
+
+  juce::WavAudioFormat wavFormat;
+  std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(outputStream.get(), sampleRate, 2, 24, {}, 0));
+  if (writer == nullptr) return juce::Result::fail("Unable to create a WAV writer for " + outputFile.getFullPathName());
+  outputStream.release(); // Now owned by 'writer'
+
+  // As many decks as the timeline uses (at least 2, same as MainComponent)
+  int numDecksNeeded = 2;
+  for (const Event& event : timeline.events) numDecksNeeded = juce::jmax(numDecksNeeded, event.deck + 1);
+  while (deckManager.getNumDecks() < numDecksNeeded)
+  {
+    // The render must not depend on how fast the disk is
+    DJAudioPlayer* player = deckManager.addDeck();
+    player->setLoadIntoRam(true);
+    deckManager.getMixer().setFaderLevel(deckManager.getNumDecks() - 1, static_cast<float>(defaultVolume));
+  }
+
+  masterBus.prepareToPlay(blockSize, sampleRate);
+
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  juce::int64 totalSamples = static_cast<juce::int64>(std::llround(timeline.lengthInSeconds * sampleRate));
+
+  // The limiter delays the mix, so that much more is rendered and the start of it is left out of the file
+  juce::int64 latency = masterBus.getLatencyInSamples();
+  juce::int64 samplesToRender = totalSamples + latency;
+  juce::int64 position = 0;
+  size_t nextEvent = 0;
+  juce::Result result = juce::Result::ok();
+
+  juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+  while (position < samplesToRender && result.wasOk())
+  {
+    // Everything due by now (queued by DJAudioPlayer and applied at the start of the next block)
+    while (nextEvent < timeline.events.size() && std::llround(timeline.events[nextEvent].timeInSeconds * sampleRate) <= position)
+    {
+      result = applyEvent(timeline.events[nextEvent++]);
+      if (result.failed()) break;
+    }
+
+    // Stop the block short of the next event, so it lands on its exact sample
+    juce::int64 blockEnd = juce::jmin(samplesToRender, position + blockSize);
+    if (nextEvent < timeline.events.size()) blockEnd = juce::jmin(blockEnd, static_cast<juce::int64>(std::llround(timeline.events[nextEvent].timeInSeconds * sampleRate)));
+    int numSamples = static_cast<int>(blockEnd - position);
+
+    juce::AudioSourceChannelInfo info(&buffer, 0, numSamples);
+    masterBus.getNextAudioBlock(info);
+    int numToSkip = static_cast<int>(juce::jlimit<juce::int64>(0, numSamples, latency - position));
+    if (!writer->writeFromAudioSampleBuffer(buffer, numToSkip, numSamples - numToSkip)) result = juce::Result::fail("Unable to write to " + outputFile.getFullPathName());
+
+    position += numSamples;
+  }
+
+  stats.secondsTaken = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+  stats.secondsRendered = juce::jmax<juce::int64>(0, position - latency) / sampleRate;
+
+  masterBus.releaseResources();
+  return result;
+}
+
+juce::Result OfflineRenderer::applyEvent(const Event& event)
+{
+  DJAudioPlayer* player = deckManager.getDeck(event.deck);
+
+  switch (event.type)
+  {
+    case Event::Type::load:
+      if (!event.file.existsAsFile()) return juce::Result::fail("Unable to find " + event.file.getFullPathName());
+      player->loadURL(juce::URL{ event.file });
+      if (!player->isLoadedIntoRam()) return juce::Result::fail("Unable to load " + event.file.getFullPathName());
+      break;
+
+    case Event::Type::play:
+      player->start();
+      break;
+
+    case Event::Type::stop:
+      player->stop();
+      break;
+
+    case Event::Type::seek:
+      player->setPosition(event.value);
+      break;
+
+    case Event::Type::gain:
+      // Same as moving DeckGUI's 'volSlider'
+      deckManager.getMixer().setFaderLevel(event.deck, static_cast<float>(event.value));
+      break;
+
+    case Event::Type::speed:
+      player->setSpeed(event.value);
+      break;
+
+    case Event::Type::lowFilter:
+      player->setLowFilter(event.value);
+      break;
+
+    case Event::Type::midFilter:
+      player->setMidFilter(event.value);
+      break;
+
+    case Event::Type::highFilter:
+      player->setHighFilter(event.value);
+      break;
+
+    case Event::Type::loop:
+      if (event.value < 0)
+      {
+        player->setLooping(false);
+        player->clearLoopRegion();
+      }
+      else
+      {
+        player->setLoopRegion(event.value, event.secondValue);
+        player->setLooping(true);
+      }
+      break;
+
+    case Event::Type::crossfade:
+      deckManager.getMixer().setCrossfadePosition(static_cast<float>(event.value));
+      break;
+
+    case Event::Type::crossfadeCurve:
+      deckManager.getMixer().setCrossfadeCurve(static_cast<DeckMixerAudioSource::CrossfadeCurve>(static_cast<int>(event.value)));
+      break;
+  }
+
+  return juce::Result::ok();
+}
+
+int OfflineRenderer::runFromCommandLine(const juce::StringArray& arguments)
+{
+  int flagIndex = arguments.indexOf("--render");
+  if (flagIndex < 0 || flagIndex + 2 >= arguments.size())
+  {
+    std::cerr << "Usage: --render <script> <output.wav>" << std::endl;
+    return 1;
+  }
+
+  juce::File scriptFile = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[flagIndex + 1].unquoted());
+  juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[flagIndex + 2].unquoted());
+
+  Timeline timeline;
+  juce::Result result = parseTimeline(scriptFile.loadFileAsString(), scriptFile.getParentDirectory(), timeline);
+  if (result.wasOk())
+  {
+    OfflineRenderer renderer;
+    Stats stats;
+    result = renderer.render(timeline, outputFile, stats);
+
+    if (result.wasOk())
+    {
+      std::cout << "Rendered " << stats.secondsRendered << "s in " << stats.secondsTaken << "s (" << stats.getRealTimeFactor() << "x real time) to " << outputFile.getFullPathName() << std::endl;
+      return 0;
+    }
+  }
+
+  std::cerr << scriptFile.getFileName() << ": " << result.getErrorMessage() << std::endl;
+  return 1;
+}
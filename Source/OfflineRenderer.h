@@ -0,0 +1,107 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "DJAudioPlayer.h"
+#include "DeckManager.h"
+#include "MasterBusAudioSource.h"
+
+/*
+Runs the same deck -> mixer -> master bus graph as MainComponent without a sound card, as fast as it can, and writes the mix to a WAV file.
+1. what happens is read from a timeline script (see parseTimeline() for the format)
+2. decks load into RAM, so the result never depends on how fast the disk is
+3. events land exactly on their sample (blocks are split at each event, and the master limiter's latency is taken back out)
+*/
+class OfflineRenderer
+{
+public:
+  struct Event
+  {
+    enum class Type
+    {
+      load,
+      play,
+      stop,
+      seek,
+      gain,
+      speed,
+      lowFilter,
+      midFilter,
+      highFilter,
+      loop,
+      crossfade,
+      crossfadeCurve
+    };
+
+    double timeInSeconds = 0.0;
+    Type type = Type::play;
+    int deck = 0; // 0 for deck 1 (not used by crossfade), decks are created as the timeline needs them
+    double value = 0.0; // For crossfadeCurve, a DeckMixerAudioSource::CrossfadeCurve as a number
+    double secondValue = 0.0; // Loop's end
+    juce::File file; // Track to load
+  };
+
+  struct Timeline
+  {
+    std::vector<Event> events; // In time order
+    double lengthInSeconds = 0.0;
+  };
+
+  struct Stats
+  {
+    double secondsRendered = 0.0;
+    double secondsTaken = 0.0;
+
+    // How many times faster than real time the render ran
+    double getRealTimeFactor() const;
+  };
+
+  /*
+  One event per line, '#' starts a comment, and relative paths are relative to 'baseDirectory'.
+  Decks are numbered from 1 (up to DeckManager::maxDecks), and the crossfade fades odd-numbered decks out to the right and even-numbered ones to the left.
+  Every deck's volume starts at 0.5 (same as DeckGUI's 'volSlider'), and the crossfade starts in the middle with the linear curve.
+      length <seconds>
+      <seconds> load <deck> <file>
+      <seconds> play|stop <deck>
+      <seconds> seek <deck> <seconds>
+      <seconds> gain <deck> <0 to 1>
+      <seconds> speed <deck> <ratio>
+      <seconds> low|mid|high <deck> <Hz>
+      <seconds> loop <deck> <start seconds> <end seconds>
+      <seconds> loop <deck> off
+      <seconds> crossfade <-1 to 1>
+      <seconds> curve linear|power|cut
+  */
+  static juce::Result parseTimeline(const juce::String& script, const juce::File& baseDirectory, Timeline& timeline);
+
+  OfflineRenderer(double _sampleRate = 44'100, int _blockSize = 512);
+  ~OfflineRenderer();
+
+  // Renders the whole timeline to 'outputFile' (24-bit stereo WAV, replaced if it exists)
+  juce::Result render(const Timeline& timeline, const juce::File& outputFile, Stats& stats);
+
+  // Handles "--render <script> <output.wav>", returns the process' exit code
+  static int runFromCommandLine(const juce::StringArray& arguments);
+
+private:
+  // Returns an error if the event could not be applied (eg. a track that would not load)
+  juce::Result applyEvent(const Event& event);
+
+
+  double sampleRate;
+  int blockSize;
+
+  // Same graph as MainComponent's
+  juce::AudioFormatManager formatManager;
+  // Loading into RAM also writes peak files, which go with the app's data rather than wherever the renderer was started from
+  PeakFileStore peakFileStore{ formatManager, juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("OtoDecks").getChildFile("peak-cache") };
+  juce::TimeSliceThread readAheadThread{ "Render read-ahead" }; // Never started, as decks only load into RAM
+  DecodedTrackCache decodedTrackCache;
+  DeckManager deckManager{ formatManager, readAheadThread, decodedTrackCache, peakFileStore };
+
+  MasterBusAudioSource masterBus{ &deckManager.getMixer() };
+
+  // Starting level of each deck's fader (same as DeckGUI's 'volSlider')
+  double defaultVolume = 0.5;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
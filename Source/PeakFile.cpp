@@ -0,0 +1,309 @@
+#include <JuceHeader.h>
+#include "PeakFile.h"
+
+// ----- PeakFile ----- //
+/*
+Layout (all little-endian):
+1. magic number "OTPK", version, sample rate (double), length in samples (int64), number of channels, number of levels
+2. per level: samples per bin, 0 (padding), number of bins (int64), offset of its data from the start of the file (int64)
+3. each level's data, as (min, max, RMS) per channel per bin
+*/
+static constexpr int peakFileHeaderSize = 32;
+static constexpr int peakFileLevelEntrySize = 24;
+
+PeakFile::PeakFile()
+{
+}
+
+PeakFile::~PeakFile()
+{
+}
+
+bool PeakFile::open(const juce::File& peakFile)
+{
+  auto file = std::make_unique<juce::MemoryMappedFile>(peakFile, juce::MemoryMappedFile::readOnly);
+  const size_t fileSize = file->getSize();
+  if (file->getData() == nullptr || fileSize < static_cast<size_t>(peakFileHeaderSize + (peakFileLevelEntrySize * numLevels))) return false;
+
+  const char* data = static_cast<const char*>(file->getData());
+  auto readInt = [data](int offset) { return static_cast<int>(juce::ByteOrder::littleEndianInt(data + offset)); };
+  auto readInt64 = [data](int offset) { return static_cast<juce::int64>(juce::ByteOrder::littleEndianInt64(data + offset)); };
+
+  // Header
+  if (readInt(0) != static_cast<int>(juce::ByteOrder::littleEndianInt("OTPK"))) return false;
+  if (readInt(4) != peakFileVersion) return false;
+
+  juce::int64 sampleRateBits = readInt64(8);
+  double newSampleRate;
+  std::memcpy(&newSampleRate, &sampleRateBits, sizeof(double));
+
+  juce::int64 newLengthInSamples = readInt64(16);
+  int newNumChannels = readInt(24);
+  if (newSampleRate <= 0 || newLengthInSamples < 0 || newNumChannels < 1 || newNumChannels > 2 || readInt(28) != numLevels) return false;
+
+  // Levels (each must fit inside the file)
+  Level newLevels[numLevels];
+  for (int i = 0; i < numLevels; ++i)
+  {
+    int entryOffset = peakFileHeaderSize + (peakFileLevelEntrySize * i);
+    newLevels[i].samplesPerBin = readInt(entryOffset);
+    newLevels[i].numBins = readInt64(entryOffset + 8);
+    juce::int64 dataOffset = readInt64(entryOffset + 16);
+    juce::int64 dataSize = newLevels[i].numBins * newNumChannels * 3 * static_cast<juce::int64>(sizeof(juce::int16));
+
+    if (newLevels[i].samplesPerBin != levelSamplesPerBin[i] || newLevels[i].numBins < 0) return false;
+    if (dataOffset < 0 || dataOffset % 2 != 0 || dataOffset + dataSize > static_cast<juce::int64>(fileSize)) return false;
+    newLevels[i].data = reinterpret_cast<const juce::int16*>(data + dataOffset);
+  }
+
+  sampleRate = newSampleRate;
+  lengthInSamples = newLengthInSamples;
+  numChannels = newNumChannels;
+  for (int i = 0; i < numLevels; ++i) levels[i] = newLevels[i];
+  mappedFile = std::move(file);
+  return true;
+}
+
+double PeakFile::getSampleRate() const
+{
+  return sampleRate;
+}
+
+juce::int64 PeakFile::getLengthInSamples() const
+{
+  return lengthInSamples;
+}
+
+double PeakFile::getLengthInSeconds() const
+{
+  return sampleRate > 0 ? lengthInSamples / sampleRate : 0.0;
+}
+
+int PeakFile::getNumChannels() const
+{
+  return numChannels;
+}
+
+const PeakFile::Level& PeakFile::chooseLevel(double samplesPerPixel) const
+{
+  for (int i = numLevels - 1; i > 0; --i)
+  {
+    if (levels[i].samplesPerBin <= samplesPerPixel) return levels[i];
+  }
+
+  return levels[0];
+}
+
+void PeakFile::drawChannel(juce::Graphics& g, juce::Rectangle<int> area, double startSeconds, double endSeconds, int channel,
+                           juce::Colour peakColour, juce::Colour rmsColour) const
+{
+  if (mappedFile == nullptr || area.isEmpty() || endSeconds <= startSeconds) return;
+
+  channel = juce::jlimit(0, numChannels - 1, channel);
+  const double samplesPerPixel = ((endSeconds - startSeconds) * sampleRate) / area.getWidth();
+  const Level& level = chooseLevel(samplesPerPixel);
+  const double binsPerPixel = samplesPerPixel / level.samplesPerBin;
+  const double firstBin = (startSeconds * sampleRate) / level.samplesPerBin;
+
+  const float centreY = area.getY() + (area.getHeight() * 0.5f);
+  const float halfHeight = area.getHeight() * 0.5f;
+
+  // One column per pixel, filled in two calls at the end
+  juce::RectangleList<float> peakColumns;
+  juce::RectangleList<float> rmsColumns;
+
+  for (int x = 0; x < area.getWidth(); ++x)
+  {
+    // Bins under this pixel (skipping pixels before the start or after the end of the track)
+    double binFrom = firstBin + (x * binsPerPixel);
+    double binTo = binFrom + binsPerPixel;
+    if (binTo <= 0 || binFrom >= level.numBins) continue;
+
+    juce::int64 binStart = juce::jmax(static_cast<juce::int64>(0), static_cast<juce::int64>(std::floor(binFrom)));
+    juce::int64 binEnd = juce::jmin(level.numBins, juce::jmax(binStart + 1, static_cast<juce::int64>(std::floor(binTo))));
+
+    int minValue = 32'767;
+    int maxValue = -32'767;
+    double sumOfSquares = 0.0;
+
+    for (juce::int64 bin = binStart; bin < binEnd; ++bin)
+    {
+      const juce::int16* values = level.data + ((bin * numChannels) + channel) * 3;
+      minValue = juce::jmin(minValue, static_cast<int>(juce::ByteOrder::swapIfBigEndian(values[0])));
+      maxValue = juce::jmax(maxValue, static_cast<int>(juce::ByteOrder::swapIfBigEndian(values[1])));
+      double rms = juce::ByteOrder::swapIfBigEndian(values[2]);
+      sumOfSquares += rms * rms;
+    }
+
+    float top = centreY - ((maxValue / 32'767.0f) * halfHeight);
+    float bottom = centreY - ((minValue / 32'767.0f) * halfHeight);
+    peakColumns.addWithoutMerging(juce::Rectangle<float>(static_cast<float>(area.getX() + x), top, 1.0f, juce::jmax(1.0f, bottom - top)));
+
+    float rmsHeight = static_cast<float>(std::sqrt(sumOfSquares / static_cast<double>(binEnd - binStart)) / 32'767.0) * halfHeight;
+    if (rmsHeight > 0.0f) rmsColumns.addWithoutMerging(juce::Rectangle<float>(static_cast<float>(area.getX() + x), centreY - rmsHeight, 1.0f, rmsHeight * 2.0f));
+  }
+
+  g.setColour(peakColour);
+  g.fillRectList(peakColumns);
+  g.setColour(rmsColour);
+  g.fillRectList(rmsColumns);
+}
+
+// ----- PeakFileBuilder ----- //
+static juce::int16 toPeakValue(double value)
+{
+  return static_cast<juce::int16>(juce::roundToInt(juce::jlimit(-1.0, 1.0, value) * 32'767.0));
+}
+
+PeakFileBuilder::PeakFileBuilder(juce::File _peakFile)
+  : peakFile(_peakFile)
+{
+  for (int channel = 0; channel < 2; ++channel)
+  {
+    binMin[channel] = 1.0f;
+    binMax[channel] = -1.0f;
+    binSumOfSquares[channel] = 0.0;
+  }
+}
+
+PeakFileBuilder::~PeakFileBuilder()
+{
+}
+
+void PeakFileBuilder::analysisStarted(int _numChannels, double _sampleRate, juce::int64 expectedLengthInSamples)
+{
+  numChannels = juce::jlimit(1, 2, _numChannels);
+  sampleRate = _sampleRate;
+  finestLevel.reserve(static_cast<size_t>((expectedLengthInSamples / PeakFile::levelSamplesPerBin[0]) + 1) * static_cast<size_t>(numChannels) * 3);
+}
+
+void PeakFileBuilder::analysisBlock(const juce::AudioBuffer<float>& block, juce::int64 position, int numSamples)
+{
+  // Blocks always arrive in order, so 'position' is only needed by consumers that store the audio
+  int blockPosition = 0;
+  while (blockPosition < numSamples)
+  {
+    // Up to the end of the bin being filled
+    int numInBin = juce::jmin(numSamples - blockPosition, PeakFile::levelSamplesPerBin[0] - samplesInBin);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      const float* samples = block.getReadPointer(juce::jmin(channel, block.getNumChannels() - 1), blockPosition);
+      juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax(samples, numInBin);
+      binMin[channel] = juce::jmin(binMin[channel], range.getStart());
+      binMax[channel] = juce::jmax(binMax[channel], range.getEnd());
+
+      double sumOfSquares = 0.0;
+      for (int i = 0; i < numInBin; ++i) sumOfSquares += samples[i] * samples[i];
+      binSumOfSquares[channel] += sumOfSquares;
+    }
+
+    samplesInBin += numInBin;
+    blockPosition += numInBin;
+    lengthInSamples += numInBin;
+
+    if (samplesInBin == PeakFile::levelSamplesPerBin[0]) finishBin();
+  }
+}
+
+void PeakFileBuilder::finishBin()
+{
+  if (samplesInBin == 0) return;
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    finestLevel.push_back(toPeakValue(binMin[channel]));
+    finestLevel.push_back(toPeakValue(binMax[channel]));
+    finestLevel.push_back(toPeakValue(std::sqrt(binSumOfSquares[channel] / samplesInBin)));
+
+    binMin[channel] = 1.0f;
+    binMax[channel] = -1.0f;
+    binSumOfSquares[channel] = 0.0;
+  }
+
+  samplesInBin = 0;
+}
+
+bool PeakFileBuilder::analysisFinished()
+{
+  // The last bin is usually only partly filled
+  finishBin();
+
+  // Work out each coarser level from the one before it
+  const size_t valuesPerBin = static_cast<size_t>(numChannels) * 3;
+  std::vector<juce::int16> coarserLevels[PeakFile::numLevels - 1];
+
+  for (int level = 1; level < PeakFile::numLevels; ++level)
+  {
+    const std::vector<juce::int16>& finer = level == 1 ? finestLevel : coarserLevels[level - 2];
+    std::vector<juce::int16>& coarser = coarserLevels[level - 1];
+
+    const size_t binsPerBin = static_cast<size_t>(PeakFile::levelSamplesPerBin[level] / PeakFile::levelSamplesPerBin[level - 1]);
+    const size_t numFinerBins = finer.size() / valuesPerBin;
+    const size_t numBins = (numFinerBins + binsPerBin - 1) / binsPerBin;
+    coarser.resize(numBins * valuesPerBin);
+
+    for (size_t bin = 0; bin < numBins; ++bin)
+    {
+      const size_t finerStart = bin * binsPerBin;
+      const size_t finerEnd = juce::jmin(finerStart + binsPerBin, numFinerBins);
+
+      for (size_t channel = 0; channel < static_cast<size_t>(numChannels); ++channel)
+      {
+        int minValue = 32'767;
+        int maxValue = -32'767;
+        double sumOfSquares = 0.0;
+
+        for (size_t finerBin = finerStart; finerBin < finerEnd; ++finerBin)
+        {
+          const juce::int16* values = finer.data() + (finerBin * valuesPerBin) + (channel * 3);
+          minValue = juce::jmin(minValue, static_cast<int>(values[0]));
+          maxValue = juce::jmax(maxValue, static_cast<int>(values[1]));
+          sumOfSquares += static_cast<double>(values[2]) * values[2];
+        }
+
+        juce::int16* values = coarser.data() + (bin * valuesPerBin) + (channel * 3);
+        values[0] = static_cast<juce::int16>(minValue);
+        values[1] = static_cast<juce::int16>(maxValue);
+        values[2] = static_cast<juce::int16>(juce::roundToInt(std::sqrt(sumOfSquares / static_cast<double>(finerEnd - finerStart))));
+      }
+    }
+  }
+
+  // Write to a temporary file first, so a crash never leaves a half-written peak file behind
+  peakFile.getParentDirectory().createDirectory();
+  juce::TemporaryFile temporaryFile(peakFile);
+  {
+    juce::FileOutputStream output(temporaryFile.getFile());
+    if (!output.openedOk()) return false;
+
+    output.writeInt(static_cast<int>(juce::ByteOrder::littleEndianInt("OTPK")));
+    output.writeInt(PeakFile::peakFileVersion);
+    output.writeDouble(sampleRate);
+    output.writeInt64(lengthInSamples);
+    output.writeInt(numChannels);
+    output.writeInt(PeakFile::numLevels);
+
+    juce::int64 dataOffset = peakFileHeaderSize + (peakFileLevelEntrySize * PeakFile::numLevels);
+    for (int level = 0; level < PeakFile::numLevels; ++level)
+    {
+      const std::vector<juce::int16>& values = level == 0 ? finestLevel : coarserLevels[level - 1];
+      output.writeInt(PeakFile::levelSamplesPerBin[level]);
+      output.writeInt(0);
+      output.writeInt64(static_cast<juce::int64>(values.size() / valuesPerBin));
+      output.writeInt64(dataOffset);
+      dataOffset += static_cast<juce::int64>(values.size() * sizeof(juce::int16));
+    }
+
+    for (int level = 0; level < PeakFile::numLevels; ++level)
+    {
+      const std::vector<juce::int16>& values = level == 0 ? finestLevel : coarserLevels[level - 1];
+      for (juce::int16 value : values) output.writeShort(value);
+    }
+
+    output.flush();
+    if (output.getStatus().failed()) return false;
+  }
+
+  return temporaryFile.overwriteTargetFileWithTemporary();
+}
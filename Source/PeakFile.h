@@ -0,0 +1,91 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "TrackAnalyser.h"
+
+/*
+Waveform overview of one track, stored on disk and memory-mapped when read.
+1. holds min/max/RMS for every bin of 64, 256, 1024 and 4096 samples (the same track at 4 levels of detail)
+2. drawing picks the coarsest level that still has at least one bin per pixel, so any zoom costs about the same
+3. values are stored as 16-bit little-endian integers (one channel after another within each bin)
+*/
+class PeakFile
+{
+public:
+  PeakFile();
+  ~PeakFile();
+
+  // Maps 'peakFile' into memory (returns false if it is missing, unknown or damaged)
+  bool open(const juce::File& peakFile);
+
+  double getSampleRate() const;
+  juce::int64 getLengthInSamples() const;
+  double getLengthInSeconds() const;
+  int getNumChannels() const;
+
+  // Draws min/max in 'peakColour', with the RMS on top in 'rmsColour'
+  void drawChannel(juce::Graphics& g, juce::Rectangle<int> area, double startSeconds, double endSeconds, int channel,
+                   juce::Colour peakColour, juce::Colour rmsColour) const;
+
+  // Samples per bin of each level, finest first
+  static constexpr int numLevels = 4;
+  static constexpr int levelSamplesPerBin[numLevels] = { 64, 256, 1'024, 4'096 };
+
+  // Change this whenever the layout written by PeakFileBuilder changes
+  static constexpr int peakFileVersion = 1;
+
+private:
+  struct Level
+  {
+    int samplesPerBin = 0;
+    juce::int64 numBins = 0;
+    const juce::int16* data = nullptr; // numBins * numChannels * 3 (min, max, RMS)
+  };
+
+  // Coarsest level that still has at least one bin per 'samplesPerPixel'
+  const Level& chooseLevel(double samplesPerPixel) const;
+
+  std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+  double sampleRate = 0.0;
+  juce::int64 lengthInSamples = 0;
+  int numChannels = 0;
+  Level levels[numLevels];
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakFile)
+};
+
+// Works out a PeakFile's levels from a TrackAnalyser pass, then writes them to 'peakFile'
+class PeakFileBuilder : public TrackAnalyser::Consumer
+{
+public:
+  PeakFileBuilder(juce::File _peakFile);
+  ~PeakFileBuilder() override;
+
+  void analysisStarted(int _numChannels, double _sampleRate, juce::int64 expectedLengthInSamples) override;
+  void analysisBlock(const juce::AudioBuffer<float>& block, juce::int64 position, int numSamples) override;
+
+  // Writes every level (through a temporary file, so a half-written file is never left behind)
+  bool analysisFinished() override;
+
+private:
+  // Adds the bin being filled to the finest level
+  void finishBin();
+
+  juce::File peakFile;
+  int numChannels = 1;
+  double sampleRate = 0.0;
+  juce::int64 lengthInSamples = 0;
+
+  // Finest level, as (min, max, RMS) per channel per bin (coarser levels are worked out from it in analysisFinished())
+  std::vector<juce::int16> finestLevel;
+
+  // Bin being filled
+  int samplesInBin = 0;
+  float binMin[2];
+  float binMax[2];
+  double binSumOfSquares[2];
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakFileBuilder)
+};
@@ -0,0 +1,132 @@
+#include <JuceHeader.h>
+#include "PeakFileStore.h"
+
+PeakFileStore::PeakFileStore(juce::AudioFormatManager& _formatManager, juce::File _directory)
+  : formatManager(_formatManager),
+    directory(_directory)
+{
+}
+
+PeakFileStore::~PeakFileStore()
+{
+  buildPool.removeAllJobs(true, 5'000);
+}
+
+juce::File PeakFileStore::getPeakFileFor(const juce::File& audioFile) const
+{
+  juce::String identity = audioFile.getFullPathName() + "|" + juce::String(audioFile.getSize()) + "|" + juce::String(audioFile.getLastModificationTime().toMilliseconds());
+  return directory.getChildFile(juce::String::toHexString(identity.hashCode64()) + ".otpk");
+}
+
+void PeakFileStore::requestPeaks(const juce::File& audioFile, PeaksReadyCallback onReady)
+{
+  if (!audioFile.existsAsFile())
+  {
+    onReady(nullptr);
+    return;
+  }
+
+  juce::File peakFile = getPeakFileFor(audioFile);
+  juce::String key = peakFile.getFullPathName();
+
+  // Already built (eg. by an earlier run)
+  if (std::shared_ptr<const PeakFile> peaks = openPeakFile(key))
+  {
+    onReady(peaks);
+    return;
+  }
+
+  // Already being built for another view
+  auto pending = pendingBuilds.find(key);
+  if (pending != pendingBuilds.end())
+  {
+    pending->second.push_back(std::move(onReady));
+    return;
+  }
+
+  pendingBuilds[key].push_back(std::move(onReady));
+  startBuild(audioFile, peakFile, key);
+}
+
+bool PeakFileStore::beginBuild(const juce::File& audioFile)
+{
+  juce::File peakFile = getPeakFileFor(audioFile);
+  juce::String key = peakFile.getFullPathName();
+  if (!audioFile.existsAsFile() || peakFile.existsAsFile() || pendingBuilds.find(key) != pendingBuilds.end()) return false;
+
+  pendingBuilds[key]; // Nothing waiting for it yet
+  return true;
+}
+
+void PeakFileStore::endBuild(const juce::File& audioFile, bool built)
+{
+  juce::String key = getPeakFileFor(audioFile).getFullPathName();
+
+  // Build it here instead, for the views still waiting
+  auto pending = pendingBuilds.find(key);
+  if (!built && pending != pendingBuilds.end() && !pending->second.empty())
+  {
+    startBuild(audioFile, juce::File(key), key);
+    return;
+  }
+
+  buildFinished(key, built);
+}
+
+void PeakFileStore::startBuild(const juce::File& audioFile, const juce::File& peakFile, const juce::String& key)
+{
+  juce::WeakReference<PeakFileStore> weakThis(this);
+
+  buildPool.addJob([this, audioFile, peakFile, key, weakThis]()
+    {
+      bool built = false;
+      TrackAnalyser::Stats stats;
+      std::unique_ptr<juce::AudioFormatReader> reader = TrackAnalyser::createReader(formatManager, audioFile, stats);
+
+      if (reader != nullptr)
+      {
+        // Stop reading as soon as this store is being destroyed
+        PeakFileBuilder peakFileBuilder(peakFile);
+        built = TrackAnalyser::run(*reader, { &peakFileBuilder }, []()
+          {
+            juce::ThreadPoolJob* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+            return job != nullptr && job->shouldExit();
+          }, stats);
+      }
+
+      juce::MessageManager::callAsync([weakThis, key, built]()
+        {
+          if (PeakFileStore* store = weakThis.get()) store->buildFinished(key, built);
+        });
+    });
+}
+
+void PeakFileStore::buildFinished(const juce::String& key, bool built)
+{
+  auto pending = pendingBuilds.find(key);
+  if (pending == pendingBuilds.end()) return;
+
+  std::vector<PeaksReadyCallback> callbacks = std::move(pending->second);
+  pendingBuilds.erase(pending);
+
+  std::shared_ptr<const PeakFile> peaks = built ? openPeakFile(key) : nullptr;
+  if (!built) DBG("> PeakFileStore::buildFinished says: Unable to build " << key << "!\n");
+
+  for (auto& callback : callbacks) callback(peaks);
+}
+
+std::shared_ptr<const PeakFile> PeakFileStore::openPeakFile(const juce::String& key)
+{
+  auto open = openPeakFiles.find(key);
+  if (open != openPeakFiles.end())
+  {
+    if (std::shared_ptr<const PeakFile> peaks = open->second.lock()) return peaks;
+    openPeakFiles.erase(open);
+  }
+
+  auto peaks = std::make_shared<PeakFile>();
+  if (!peaks->open(juce::File(key))) return nullptr;
+
+  openPeakFiles[key] = peaks;
+  return peaks;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "PeakFile.h"
+
+/*
+Finds (or builds, in the background) the PeakFile of each track.
+1. peak files are kept in 'directory', named after the track's path, size and modification time (so edited tracks get new ones)
+2. a track that already has a peak file is ready straight away, otherwise it is read once on 'buildPool'
+3. views showing the same track share one memory-mapped PeakFile
+Only used on the message thread.
+*/
+class PeakFileStore
+{
+public:
+  using PeaksReadyCallback = std::function<void(std::shared_ptr<const PeakFile> peaks)>;
+
+  PeakFileStore(juce::AudioFormatManager& _formatManager, juce::File _directory);
+  ~PeakFileStore();
+
+  // Calls 'onReady' with the track's peaks (nullptr if it cannot be read)
+  // This happens before returning if a peak file already exists, otherwise once it has been built
+  void requestPeaks(const juce::File& audioFile, PeaksReadyCallback onReady);
+
+  juce::File getPeakFileFor(const juce::File& audioFile) const;
+
+  // Lets a pass that reads 'audioFile' anyway (eg. a deck streaming it) build its peak file, so requests made meanwhile wait for that pass instead of decoding it again
+  // Returns false if the peak file already exists or is already being built
+  bool beginBuild(const juce::File& audioFile);
+
+  // Called once that pass is over (if it did not build the peak file, it is built here for any requests still waiting)
+  void endBuild(const juce::File& audioFile, bool built);
+
+private:
+  // Reads 'audioFile' on 'buildPool'
+  void startBuild(const juce::File& audioFile, const juce::File& peakFile, const juce::String& key);
+
+  // Called on the message thread once a build has finished
+  void buildFinished(const juce::String& key, bool built);
+
+  // Returns the already-open PeakFile for 'key', or opens it (nullptr if that fails)
+  std::shared_ptr<const PeakFile> openPeakFile(const juce::String& key);
+
+  juce::AudioFormatManager& formatManager;
+  juce::File directory;
+  juce::ThreadPool buildPool{ 1 };
+
+  std::map<juce::String, std::weak_ptr<const PeakFile>> openPeakFiles;
+  std::map<juce::String, std::vector<PeaksReadyCallback>> pendingBuilds; // Callbacks waiting for each build
+
+  JUCE_DECLARE_WEAK_REFERENCEABLE(PeakFileStore)
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakFileStore)
+};
@@ -1,9 +1,8 @@
 #include <JuceHeader.h>
+#include <algorithm>
 #include "PlaylistComponent.h"
 
-PlaylistComponent::PlaylistComponent(juce::Colour _leftColour, juce::Colour _rightColour)
-  : leftColour(_leftColour),
-    rightColour(_rightColour)
+PlaylistComponent::PlaylistComponent()
 {
   buttons.add(&importTrackButton);
   buttons.add(&importLibraryButton);
@@ -26,14 +25,26 @@ PlaylistComponent::PlaylistComponent(juce::Colour _leftColour, juce::Colour _rig
   // Column width values are merely here for show, actual width values are set at PlaylistComponent::resized() below
   addAndMakeVisible(tableComponent);
   tableComponent.setModel(this);
-  tableComponent.getHeader().addColumn("Track Title", 1, 20);
-  tableComponent.getHeader().addColumn("Duration", 2, 10);
-  tableComponent.getHeader().addColumn("Load into Left Deck", 3, 10);
-  tableComponent.getHeader().addColumn("Load into Right Deck", 4, 10);
-  tableComponent.getHeader().addColumn("Remove", 5, 10);
-
-  // For persisting playlist (whether or not user wants to save/export library)
-  readIncomingLibraryAndUpdateTable(juce::File::getCurrentWorkingDirectory().getChildFile("persisted-playlist.txt"));
+  // 'Load' columns are added between "Added" and "Remove" by setDeckColours(), and "Path" and "Added" can be shown from the header's menu
+  int hiddenFlags = juce::TableHeaderComponent::defaultFlags & ~juce::TableHeaderComponent::visible;
+  tableComponent.getHeader().addColumn("Track Title", titleColumnId, 20);
+  tableComponent.getHeader().addColumn("Path", pathColumnId, 10, 30, -1, hiddenFlags);
+  tableComponent.getHeader().addColumn("Duration", durationColumnId, 10);
+  tableComponent.getHeader().addColumn("Added", addedColumnId, 10, 30, -1, hiddenFlags);
+  tableComponent.getHeader().addColumn("Remove", removeColumnId, 10, 30, -1, juce::TableHeaderComponent::defaultFlags & ~juce::TableHeaderComponent::sortable);
+  tableComponent.getHeader().addListener(this);
+
+  // Import status (only shown while importing)
+  addChildComponent(importStatusLabel);
+  addChildComponent(cancelImportButton);
+  importStatusLabel.setJustificationType(juce::Justification::centredLeft);
+  cancelImportButton.addListener(this);
+  libraryImporter.setListener(this);
+
+  // For persisting playlist (whether or not user wants to save/export library), durations come from the cache where possible
+  metadataCache.loadFromFile(metadataCacheFile);
+  if (persistedLibraryFile.existsAsFile()) readIncomingLibraryAndUpdateTable(persistedLibraryFile);
+  readIncomingLibraryAndUpdateTable(persistedPlaylistFile);
 }
 
 PlaylistComponent::~PlaylistComponent()
@@ -41,9 +52,29 @@ PlaylistComponent::~PlaylistComponent()
   // For persisting playlist (whether or not user wants to save/export library)
   exportAndPersistCurrentPlaylist();
 
+  // Stop any import that is still running (tracks not imported yet were persisted above)
+  libraryImporter.setListener(nullptr);
+  libraryImporter.cancel();
+  metadataCache.removeMissingFiles();
+  metadataCache.saveToFile(metadataCacheFile);
+
+  tableComponent.getHeader().removeListener(this);
   tableComponent.setModel(nullptr);
 }
 
+void PlaylistComponent::setDeckColours(const juce::Array<juce::Colour>& colours)
+{
+  for (int i = 0; i < cellPainter.getNumDecks(); ++i) tableComponent.getHeader().removeColumn(firstLoadColumnId + i);
+  cellPainter.setDeckColours(colours);
+
+  // Inserted after "Track Title", "Path", "Duration" and "Added"
+  for (int i = 0; i < cellPainter.getNumDecks(); ++i)
+    tableComponent.getHeader().addColumn("Load into Deck " + juce::String(i + 1), firstLoadColumnId + i, 10, 30, -1, juce::TableHeaderComponent::defaultFlags & ~juce::TableHeaderComponent::sortable, 4 + i);
+
+  tableComponent.updateContent();
+  resized();
+}
+
 void PlaylistComponent::paint(juce::Graphics& g)
 {
   // Background
@@ -57,6 +88,10 @@ void PlaylistComponent::paint(juce::Graphics& g)
     button->setConnectedEdges(juce::TextButton::ConnectedOnLeft | juce::TextButton::ConnectedOnRight);
   }
 
+  // Import status below tableComp
+  importStatusLabel.setColour(juce::Label::backgroundColourId, myBlack);
+  cancelImportButton.setColour(juce::TextButton::buttonColourId, juce::Colours::red.withAlpha(0.75f));
+
   // tableComp's background
   tableComponent.setColour(juce::TableListBox::backgroundColourId, myBlackLight);
   
@@ -78,163 +113,72 @@ void PlaylistComponent::resized()
   replaceLibraryButton.setBounds(importLibraryButton.getX() + importLibraryButton.getWidth(), 0, buttonWidth, buttonHeight);
   exportLibraryButton.setBounds(replaceLibraryButton.getX() + replaceLibraryButton.getWidth(), 0, buttonWidth, buttonHeight);
 
+  // Import status (takes space from the bottom of tableComp while importing)
+  double statusHeight = importStatusLabel.isVisible() ? buttonHeight : 0;
+  importStatusLabel.setBounds(0, getHeight() - statusHeight, getWidth() - buttonWidth, statusHeight);
+  cancelImportButton.setBounds(importStatusLabel.getWidth(), getHeight() - statusHeight, buttonWidth, statusHeight);
+
   // tableComp itself
-  tableComponent.setBounds(0, searchEditor.getY() + searchEditor.getHeight(), getWidth(), (getHeight() - buttonHeight));
+  tableComponent.setBounds(0, searchEditor.getY() + searchEditor.getHeight(), getWidth(), (getHeight() - buttonHeight - statusHeight));
   double widthPart = getWidth() / static_cast<double>(6);
   double removeColWidth = widthPart / 2;
   double scrollbarWidth = 10; // This is a rough estimate due to being unable to get Juce's default scrollbar width
-  tableComponent.getHeader().setColumnWidth(1, widthPart * 2);
-  tableComponent.getHeader().setColumnWidth(2, widthPart * 1);
-  tableComponent.getHeader().setColumnWidth(3, ((widthPart * 3) - removeColWidth) / 2);
-  tableComponent.getHeader().setColumnWidth(4, ((widthPart * 3) - removeColWidth) / 2);
-  tableComponent.getHeader().setColumnWidth(5, removeColWidth - scrollbarWidth);
+  // "Path" and "Added" take some of the title's and duration's space when shown
+  bool isPathVisible = tableComponent.getHeader().isColumnVisible(pathColumnId);
+  bool isAddedVisible = tableComponent.getHeader().isColumnVisible(addedColumnId);
+  tableComponent.getHeader().setColumnWidth(titleColumnId, widthPart * (isPathVisible ? 1.25 : 2));
+  tableComponent.getHeader().setColumnWidth(pathColumnId, widthPart * 0.75);
+  tableComponent.getHeader().setColumnWidth(durationColumnId, widthPart * (isAddedVisible ? 0.5 : 1));
+  tableComponent.getHeader().setColumnWidth(addedColumnId, widthPart * 0.5);
+  for (int i = 0; i < cellPainter.getNumDecks(); ++i) tableComponent.getHeader().setColumnWidth(firstLoadColumnId + i, ((widthPart * 3) - removeColWidth) / cellPainter.getNumDecks());
+  tableComponent.getHeader().setColumnWidth(removeColumnId, removeColWidth - scrollbarWidth);
 }
 
 int PlaylistComponent::getNumRows()
 {
-  return fileTitles.size();
+  return static_cast<int>(isSearching ? librarySearch.getMatches().size() : trackStore.getTrackIds().size());
 }
 
 void PlaylistComponent::paintRowBackground(juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected)
 {
-  // Alternating row colours
-  if (rowNumber % 2 == 0) g.fillAll(myBlackLighter);
-  else g.fillAll(myBlackLightest);
-
-  // Selected row has black background and white border
-  if (rowIsSelected)
-  {
-    double scrollbarWidth = 10; // This is rough estimate due to being unable to get Juce's default scrollbar width
-    g.fillAll(juce::Colours::black);
-    g.setColour(juce::Colours::white);
-    g.drawRect(0, 0, width - scrollbarWidth, height, 2);
-  }
+  cellPainter.paintRowBackground(g, rowNumber, width, height, rowIsSelected);
 }
 
-// For 'columnId' of 1 and 2
+// Every column is painted (the 'Load' and 'X' buttons too), so scrolling never creates components or builds strings
 void PlaylistComponent::paintCell(juce::Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected)
 {
-  // Row's font colour
-  g.setColour(juce::Colours::white);
-
-  // "Track Title" column
-  if (columnId == 1) g.drawText(fileTitles[rowNumber], 2, 0, width - 4, height, juce::Justification::centredLeft, true);
-
-  // "Duration" column
-  if (columnId == 2) g.drawText(formatDoubleToMMSS(fileDurations[rowNumber]), 2, 0, width - 4, height, juce::Justification::centredLeft, true);
+  cellPainter.paintCell(g, getTrackId(rowNumber), columnId, width, height);
 }
 
-// For 'columnId' of 3, 4 and 5 (for buttons within tableComp, aka. 'Load' and 'X' button)
-juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber, int columnId, bool isRowSelected, juce::Component* existingComponentToUpdate)
+// For "Load into Deck" and "Remove" columns (clicking anywhere in the cell is the same as clicking its button)
+void PlaylistComponent::cellClicked(int rowNumber, int columnId, const juce::MouseEvent& event)
 {
-  // "Load into Left Deck" column
-  if (columnId == 3)
-  {
-    if (existingComponentToUpdate == nullptr)
-    {
-      // Setup
-      juce::TextButton* btn = new juce::TextButton{ "Load" };
-      btn->addListener(this);
-      juce::String id{ std::to_string(rowNumber) };
-      btn->setComponentID(id);
-      
-      // Set its look
-      btn->setConnectedEdges(juce::TextButton::ConnectedOnRight);
-      btn->setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
-      btn->setColour(juce::TextButton::textColourOffId, leftColour.brighter());
+  TrackStore::TrackId trackId = getTrackId(rowNumber);
+  if (!trackStore.contains(trackId)) return;
 
-      // Load functionality (connected to MainComponent::timerCallback())
-      btn->onClick = [this, rowNumber]()
-        {
-          if (rowNumber >= 0 && rowNumber < fileTitles.size())
-          {
-            deckNumber = 1;
-            fileURL = fileURLs[rowNumber];
-            loadToDeck = true;
-          }
-        };
-
-      // End
-      existingComponentToUpdate = btn;
-    }
-  }
-
-  // "Load into Right Deck" column
-  if (columnId == 4)
-  {
-    if (existingComponentToUpdate == nullptr)
-    {
-      // Setup
-      juce::TextButton* btn = new juce::TextButton{ "Load" };
-      btn->addListener(this);
-      juce::String id{ std::to_string(rowNumber) };
-      btn->setComponentID(id);
-
-      // Set its look
-      btn->setConnectedEdges(juce::TextButton::ConnectedOnLeft | juce::TextButton::ConnectedOnRight);
-      btn->setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
-      btn->setColour(juce::TextButton::textColourOffId, rightColour.brighter());
-
-      // Load functionality (connected to MainComponent::timerCallback())
-      btn->onClick = [this, rowNumber]()
-        {
-          if (rowNumber >= 0 && rowNumber < fileTitles.size())
-          {
-            deckNumber = 2;
-            fileURL = fileURLs[rowNumber];
-            loadToDeck = true;
-          }
-        };
+  // Load functionality (connected to MainComponent via 'onLoadToDeck')
+  int deckIndex = cellPainter.getDeckIndex(columnId);
+  if (deckIndex >= 0 && onLoadToDeck) onLoadToDeck(deckIndex + 1, trackStore.getURL(trackId).toStdString());
 
-      // End
-      existingComponentToUpdate = btn;
-    }
-  }
-  
-  // "Remove" column
-  if (columnId == 5)
+  // Remove functionality
+  if (columnId == removeColumnId)
   {
-    if (existingComponentToUpdate == nullptr)
-    {
-      // Setup
-      juce::TextButton* btn = new juce::TextButton{ "X" };
-      btn->addListener(this);
-      juce::String id{ std::to_string(rowNumber) };
-      btn->setComponentID(id);
-
-      // Set its look
-      btn->setConnectedEdges(juce::TextButton::ConnectedOnLeft);
-      btn->setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
-      btn->setColour(juce::TextButton::textColourOffId, juce::Colours::red.brighter());
-
-      // Remove functionality
-      btn->onClick = [this, rowNumber]()
-        {
-          if (rowNumber >= 0 && rowNumber < fileTitles.size())
-          {
-            fileURLs.erase(fileURLs.begin() + rowNumber);
-            fileTitles.erase(fileTitles.begin() + rowNumber);
-            fileDurations.erase(fileDurations.begin() + rowNumber);
-
-            // Store updated array after removing
-            fileURLsCopy = fileURLs;
-            fileTitlesCopy = fileTitles;
-            fileDurationsCopy = fileDurations;
-
-            tableComponent.updateContent();
-          }
-        };
-      // End
-      existingComponentToUpdate = btn;
-    }
+    // Other tracks keep their IDs, so neither the table's rows nor the search's matches need building again
+    // (each list only marks the track as removed, and drops it the next time its rows are read)
+    trackStore.remove(trackId);
+    librarySearch.removeTitle(trackId);
+    librarySort.trackRemoved(trackId);
+    sortedMatchesHaveRemovals = true;
+    tableComponent.updateContent();
+    tableComponent.repaint();
   }
-
-  return existingComponentToUpdate;
 }
 
 // For buttons above tableComp
 void PlaylistComponent::buttonClicked(juce::Button* button)
 {
+  if (button == &cancelImportButton) libraryImporter.cancel();
+
   if (button == &importTrackButton)
   {
     // Create juce::FileChooser, specify file types allowed
@@ -261,23 +205,22 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
     else browserMessage = "Add libraries to current library";
 
     // Create juce::FileChooser, specify file types allowed
-    juce::FileChooser importer{ browserMessage, juce::File(), "*.txt" };
+    juce::FileChooser importer{ browserMessage, juce::File(), "*.txt,*.otolib" };
 
     // If user decides to import/replace library, then do the following
     if (importer.browseForMultipleFilesToOpen())
     {
-      // If replacing, then backup and reset vectors
+      // If replacing, then stop any running import and reset vectors
       if (button == &replaceLibraryButton)
       {
-        // Save a backup copy (in case user clicks 'cancel')
-        fileURLsCopy = fileURLs;
-        fileTitlesCopy = fileTitles;
-        fileDurationsCopy = fileDurations;
-       
+        libraryImporter.cancel();
+
         // Clear file-related vectors to clear tableComp
-        fileURLs.clear();
-        fileTitles.clear();
-        fileDurations.clear();
+        trackStore.clear();
+        librarySearch.clear();
+        librarySort.clear();
+        sortedMatches.clear();
+        sortedMatchesHaveRemovals = false;
 
         // Refresh searchInput
         searchEditor.setText("");
@@ -286,10 +229,10 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
         tableComponent.updateContent();
       }
       
-      // To import library, get array of .txt files
+      // To import library, get array of .txt and .otolib files
       juce::Array<juce::File> chosenLibraries = importer.getResults();
       
-      // Go through every .txt file in array
+      // Go through every .txt and .otolib file in array
       for (const auto& chosenLibrary : chosenLibraries)
       {
         readIncomingLibraryAndUpdateTable(chosenLibrary);
@@ -302,7 +245,7 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
   if (button == &exportLibraryButton)
   {
     // Create juce::FileChooser, specify file types allowed
-    juce::FileChooser exportLibrary{ "Save current library", juce::File(), "*.txt" };
+    juce::FileChooser exportLibrary{ "Save current library (as .otolib to save durations too, and load faster)", juce::File(), "*.txt,*.otolib" };
 
     // If user clicks 'save' in file explorer window, then do the following
     if (exportLibrary.browseForFileToSave(false))
@@ -336,17 +279,30 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
       }
 
       // ----- Exporting process ----- //
-      // Create file output stream
-      juce::FileOutputStream fileOutputStream(exportPath);
-      
-      if (fileOutputStream.openedOk())
+      // CURRENT rows of tableComp (only what is filtered by 'searchEditor', if anything, in the order shown)
+      std::vector<TrackStore::TrackId> trackIds;
+      for (int row = 0; row < getNumRows(); ++row) trackIds.push_back(getTrackId(row));
+
+      bool exported = false;
+      if (LibraryFile::isLibraryFile(exportPath)) exported = writeBinaryLibrary(exportPath, trackIds);
+      else
       {
-        // Loop through CURRENT fileURLs vector
-        for (const auto& URL : fileURLs)
+        // Create file output stream
+        juce::FileOutputStream fileOutputStream(exportPath);
+
+        if (fileOutputStream.openedOk())
         {
-          // Write to file with a line break
-          fileOutputStream << juce::String(URL) << "\n";
+          for (TrackStore::TrackId trackId : trackIds)
+          {
+            // Write to file with a line break
+            fileOutputStream << trackStore.getURL(trackId) << "\n";
+          }
+          exported = true;
         }
+      }
+
+      if (exported)
+      {
         // Indicate to user
         juce::AlertWindow::showMessageBoxAsync(
           juce::AlertWindow::InfoIcon,
@@ -362,44 +318,94 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
 
 void PlaylistComponent::textEditorTextChanged(juce::TextEditor& editor)
 {
-  // Create another copy but for filtered items only
-  std::vector<std::string> fileURLsFiltered;
-  std::vector<std::string> fileTitlesFiltered;
-  std::vector<double> fileDurationsFiltered;
+  applySearchFilter();
+}
 
-  // Go through every track in array
+void PlaylistComponent::applySearchFilter()
+{
+  // If there is input, then show matching tracks only, else show every track
   juce::String searchInput = searchEditor.getText().trim();
-  for (int i = 0; i < fileTitlesCopy.size(); ++i)
-  {
-    // If there is input and substring matches, then populate filtered arrays
-    if (searchInput.isNotEmpty() && juce::String(fileTitlesCopy[i]).containsIgnoreCase(searchInput))
-    {
-      fileURLsFiltered.push_back(fileURLsCopy[i]);
-      fileTitlesFiltered.push_back(fileTitlesCopy[i]);
-      fileDurationsFiltered.push_back(fileDurationsCopy[i]);
-    }
+  isSearching = searchInput.isNotEmpty();
+  if (isSearching) librarySearch.findMatches(searchInput);
+  updateSortedMatches();
 
-    // Else do nothing
-  }
+  // Update table whenever text editor changes
+  tableComponent.updateContent();
+  tableComponent.repaint();
+}
 
-  // If there is input, then show filter array's items only
-  if (searchInput.isNotEmpty())
+TrackStore::TrackId PlaylistComponent::getTrackId(int rowNumber)
+{
+  if (rowNumber < 0 || rowNumber >= getNumRows()) return TrackStore::noTrack;
+
+  LibrarySort::Key key;
+  if (!getSortKey(sortColumnId, key))
   {
-    fileURLs = fileURLsFiltered;
-    fileTitles = fileTitlesFiltered;
-    fileDurations = fileDurationsFiltered;
+    if (isSearching) return static_cast<TrackStore::TrackId>(librarySearch.getMatches()[static_cast<size_t>(rowNumber)]);
+    return trackStore.getTrackIds()[static_cast<size_t>(rowNumber)];
   }
 
-  // Else if there is NO input, then show original items (upon importing library)
-  else
+  // Sorted backwards is the same order, read from the end
+  size_t index = static_cast<size_t>(isSortedForwards ? rowNumber : getNumRows() - 1 - rowNumber);
+  if (!isSearching) return librarySort.getOrder(key)[index];
+
+  // Removed tracks are all dropped in one pass, keeping the rest in order
+  if (sortedMatchesHaveRemovals)
   {
-    fileURLs = fileURLsCopy;
-    fileTitles = fileTitlesCopy;
-    fileDurations = fileDurationsCopy;
+    sortedMatches.erase(std::remove_if(sortedMatches.begin(), sortedMatches.end(), [this](TrackStore::TrackId id) { return !trackStore.contains(id); }), sortedMatches.end());
+    sortedMatchesHaveRemovals = false;
   }
 
-  // Update table whenever text editor changes
+  return sortedMatches[index];
+}
+
+bool PlaylistComponent::getSortKey(int columnId, LibrarySort::Key& key)
+{
+  if (columnId == titleColumnId) key = LibrarySort::Key::title;
+  else if (columnId == durationColumnId) key = LibrarySort::Key::duration;
+  else if (columnId == pathColumnId) key = LibrarySort::Key::path;
+  else if (columnId == addedColumnId) key = LibrarySort::Key::dateAdded;
+  else return false;
+
+  return true;
+}
+
+void PlaylistComponent::updateSortedMatches()
+{
+  sortedMatches.clear();
+  sortedMatchesHaveRemovals = false;
+
+  LibrarySort::Key key;
+  if (!isSearching || !getSortKey(sortColumnId, key)) return;
+
+  // Put in order using the cached order of every track, instead of sorting the matches from scratch
+  for (size_t match : librarySearch.getMatches()) sortedMatches.push_back(static_cast<TrackStore::TrackId>(match));
+  librarySort.sortIds(key, sortedMatches);
+}
+
+void PlaylistComponent::sortOrderChanged(int newSortColumnId, bool isForwards)
+{
+  sortColumnId = newSortColumnId;
+  isSortedForwards = isForwards;
+  updateSortedMatches();
+
   tableComponent.updateContent();
+  tableComponent.repaint();
+}
+
+void PlaylistComponent::tableColumnsChanged(juce::TableHeaderComponent* header)
+{
+  // Share the width out again when a column is shown or hidden
+  resized();
+}
+
+void PlaylistComponent::tableColumnsResized(juce::TableHeaderComponent* header)
+{
+}
+
+void PlaylistComponent::tableSortOrderChanged(juce::TableHeaderComponent* header)
+{
+  // Handled by PlaylistComponent::sortOrderChanged(), which tableComp calls
 }
 
 bool PlaylistComponent::isInterestedInFileDrag(const juce::StringArray& files)
@@ -407,6 +413,62 @@ bool PlaylistComponent::isInterestedInFileDrag(const juce::StringArray& files)
   return true;
 }
 
+void PlaylistComponent::importBatchReady(const std::vector<LibraryImporter::ImportedTrack>& batch)
+{
+  for (const auto& track : batch)
+  {
+    // Missing files are reported all at once in PlaylistComponent::importFinished()
+    if (!track.fileExists) continue;
+
+    addTrack(track.fileURL, track.fileTitle, track.fileDuration, track.sampleRate, track.numChannels);
+  }
+
+  // Update table as every batch arrives (while searching, only the new tracks are checked against the search)
+  applySearchFilter();
+}
+
+void PlaylistComponent::importProgressChanged(const LibraryImporter::Progress& progress)
+{
+  // Show status at the bottom of tableComp when an import starts
+  if (!importStatusLabel.isVisible())
+  {
+    importStatusLabel.setVisible(true);
+    cancelImportButton.setVisible(true);
+    resized();
+  }
+
+  importStatusLabel.setText("Importing " + juce::String(progress.filesDone) + " / " + juce::String(progress.filesTotal) + " tracks (" + juce::String(progress.filesPerSecond, 0) + " files/sec)", juce::NotificationType::dontSendNotification);
+}
+
+void PlaylistComponent::importFinished(const LibraryImporter::Progress& progress, const juce::StringArray& missingFiles, bool wasCancelled)
+{
+  // Hide status and give the space back to tableComp
+  importStatusLabel.setVisible(false);
+  cancelImportButton.setVisible(false);
+  resized();
+
+  // Sort the new tracks into every column's order now, so the next click on a header is instant
+  librarySort.prepareAll();
+
+  // Save newly read durations straight away (instead of only when the app closes)
+  metadataCache.saveToFile(metadataCacheFile);
+
+  // Alert user once (instead of once per missing file)
+  if (missingFiles.size() > 0)
+  {
+    int maxFilesToList = 10;
+    juce::StringArray listedFiles;
+    listedFiles.addArray(missingFiles, 0, maxFilesToList);
+    if (missingFiles.size() > maxFilesToList) listedFiles.add("...and " + juce::String(missingFiles.size() - maxFilesToList) + " more");
+
+    juce::AlertWindow::showMessageBoxAsync(
+      juce::AlertWindow::WarningIcon,
+      "Error with incoming library!",
+      juce::String(missingFiles.size()) + " audio file(s) do not exist. Skipping these files:\n\n" + listedFiles.joinIntoString("\n")
+    );
+  }
+}
+
 void PlaylistComponent::filesDropped(const juce::StringArray& files, int x, int y)
 {
   for (const auto& file : files)
@@ -419,7 +481,7 @@ void PlaylistComponent::filesDropped(const juce::StringArray& files, int x, int
     if (cond1) readIncomingFileAndUpdateTable(droppedFile);
 
     // If dropped files are library (.txt) files, then do the following
-    bool cond2 = isIncomingFileOfValidType(droppedFile, { ".txt" });
+    bool cond2 = isIncomingFileOfValidType(droppedFile, { ".txt", ".otolib" });
     if (cond2) readIncomingLibraryAndUpdateTable(droppedFile);
 
     // Alert user if they drop a non-valid file
@@ -428,117 +490,96 @@ void PlaylistComponent::filesDropped(const juce::StringArray& files, int x, int
       juce::AlertWindow::showMessageBoxAsync(
         juce::AlertWindow::WarningIcon,
         "Unable to drop the file type: " + droppedFile.getFileExtension().toLowerCase(),
-        "Only...\n\n - audio file types (eg. mp3, wav, aac, flac, ogg)\n - library file types (eg. txt)\n\nare allowed!"
+        "Only...\n\n - audio file types (eg. mp3, wav, aac, flac, ogg)\n - library file types (eg. txt, otolib)\n\nare allowed!"
       );
     }
   }
 }
 
-juce::String PlaylistComponent::formatDoubleToMMSS(double durationInSeconds)
-{
-  int min = static_cast<int>(durationInSeconds) / 60;
-  int sec = static_cast<int>(durationInSeconds) % 60;
-  return juce::String::formatted("%02d:%02d", min, sec);
-}
-
 void PlaylistComponent::readIncomingFileAndUpdateTable(juce::File incomingFile)
 {
-  // 1. Extract and push file path url to its vector (used in 'if (button == &exportLibraryButton)' to save current library)
-  juce::String url = incomingFile.getFullPathName();
-  fileURLs.push_back(url.toStdString());
-  
-  // 2. Extract and push file name to its vector (displayed in PlaylistComponent::paintCell())
-  fileTitles.push_back(incomingFile.getFileNameWithoutExtension().toStdString());
-  
-  // 3. Create file reader to extract, calculate, and push file duration to its vector (displayed in PlaylistComponent::paintCell())
-  juce::AudioFormatReader* reader = formatManager.createReaderFor(incomingFile);
-  if (reader)
-  {
-    double duration = reader->lengthInSamples / reader->sampleRate;
-    fileDurations.push_back(duration);
-  }
-  
-  // Update backup copy (for PlaylistComponent::textEditorTextChanged() purposes below)
-  fileURLsCopy = fileURLs;
-  fileTitlesCopy = fileTitles;
-  fileDurationsCopy = fileDurations;
-  
-  // Refresh searchInput (for PlaylistComponent::textEditorTextChanged() purposes below)
-  searchEditor.setText("");
+  // Refresh searchInput when a new import starts (for PlaylistComponent::textEditorTextChanged() purposes above)
+  if (!libraryImporter.isImporting()) searchEditor.setText("");
 
-  // Update table after reading audio files
-  tableComponent.updateContent();
+  // Duration is read in the background, and tableComp is updated in PlaylistComponent::importBatchReady()
+  libraryImporter.importFiles(juce::StringArray(incomingFile.getFullPathName()));
 }
 
 void PlaylistComponent::readIncomingLibraryAndUpdateTable(juce::File incomingLibrary)
 {
-  // Set boolean for alert window
-  bool skipAllErrors = false;
+  // Binary libraries already have every track's details, so they skip 'libraryImporter'
+  if (LibraryFile::isLibraryFile(incomingLibrary))
+  {
+    readIncomingBinaryLibraryAndUpdateTable(incomingLibrary);
+    return;
+  }
 
   // Create file input stream
   juce::FileInputStream fileInputStream(incomingLibrary);
 
-  // Go through every line in .txt file
+  // Go through every line in .txt file (every line is a path URL)
+  juce::StringArray incomingFiles;
   while (!fileInputStream.isExhausted())
   {
-    // Extract individual line from .txt file
-    juce::String line = fileInputStream.readNextLine();
+    juce::String line = fileInputStream.readNextLine().trim();
+    if (line.isNotEmpty()) incomingFiles.add(line);
+  }
 
-    // Store .txt file's line as juce::File
-    juce::File incomingFile(line);
+  // Refresh searchInput when a new import starts (for PlaylistComponent::textEditorTextChanged() purposes above)
+  if (!libraryImporter.isImporting()) searchEditor.setText("");
 
-    // If file exists, then do the following (to populate vectors)
-    if (incomingFile.exists())
-    {
-      // 1. Push individual line (since every line is a path URL anyway)
-      fileURLs.push_back(line.toStdString());
+  // Files are checked and read in the background, and tableComp is updated in PlaylistComponent::importBatchReady()
+  libraryImporter.importFiles(incomingFiles);
+}
 
-      // 2. Store as juce::File to extract, and push file name
-      fileTitles.push_back(incomingFile.getFileNameWithoutExtension().toStdString());
+void PlaylistComponent::readIncomingBinaryLibraryAndUpdateTable(const juce::File& incomingLibrary)
+{
+  // Memory mapped and read in one go (files are not checked, so a missing one only shows up when it is loaded into a deck)
+  std::vector<LibraryFile::Track> tracks;
+  if (!LibraryFile::read(incomingLibrary, tracks))
+  {
+    juce::AlertWindow::showMessageBoxAsync(
+      juce::AlertWindow::WarningIcon,
+      "Error with incoming library!",
+      incomingLibrary.getFileName() + " is not a library this version of OtoDecks can read."
+    );
+    return;
+  }
 
-      // 3. Create file reader to extract, calculate, and push file duration
-      juce::AudioFormatReader* reader = formatManager.createReaderFor(incomingFile);
-      if (reader)
-      {
-        double duration = reader->lengthInSamples / reader->sampleRate;
-        fileDurations.push_back(duration);
-      }
-    }
-    // Else if file does not exist (eg. error in .txt file), then show alert window
-    else
-    {
-      if (!skipAllErrors)
-      {
-        // Create alert window
-        juce::AlertWindow alertWindow(
-          "Error with incoming library!",
-          "Audio file does not exist. Skipping this file:\n\n" + line,
-          juce::AlertWindow::WarningIcon
-        );
+  // Refresh searchInput (for PlaylistComponent::textEditorTextChanged() purposes above)
+  if (!libraryImporter.isImporting()) searchEditor.setText("");
 
-        // addButton(<string>, <return value>)
-        alertWindow.addButton("Okay", 1);
-        alertWindow.addButton("Okay to All", 2);
+  // Tracks keep the date they were first added
+  for (const LibraryFile::Track& track : tracks) addTrack(track.fileURL, track.fileTitle, track.fileDuration, track.sampleRate, track.numChannels, track.dateAdded);
 
-        // Store button's return value from alert window into 'result'
-        int result = alertWindow.runModalLoop();
+  // Same as once an import finishes
+  librarySort.prepareAll();
+  applySearchFilter();
+}
 
-        // If "Okay to All", do not show alert windows anymore
-        if (result == 2) skipAllErrors = true;
-      }
-    }
+bool PlaylistComponent::writeBinaryLibrary(const juce::File& library, const std::vector<TrackStore::TrackId>& trackIds)
+{
+  std::vector<LibraryFile::Track> tracks(trackIds.size());
+  for (size_t i = 0; i < trackIds.size(); ++i)
+  {
+    tracks[i].fileURL = trackStore.getURL(trackIds[i]);
+    tracks[i].fileTitle = trackStore.getTitle(trackIds[i]);
+    tracks[i].fileDuration = trackStore.getDuration(trackIds[i]);
+    tracks[i].sampleRate = trackStore.getSampleRate(trackIds[i]);
+    tracks[i].numChannels = trackStore.getNumChannels(trackIds[i]);
+    tracks[i].dateAdded = trackStore.getDateAdded(trackIds[i]);
   }
 
-  // After everything, update backup copy (for PlaylistComponent::textEditorTextChanged() purposes below)
-  fileURLsCopy = fileURLs;
-  fileTitlesCopy = fileTitles;
-  fileDurationsCopy = fileDurations;
-  
-  // Refresh searchInput (for PlaylistComponent::textEditorTextChanged() purposes below)
-  searchEditor.setText("");
-  
-  // Update table after reading .txt file
-  tableComponent.updateContent();
+  return LibraryFile::write(library, tracks);
+}
+
+TrackStore::TrackId PlaylistComponent::addTrack(const juce::String& fileURL, const juce::String& fileTitle, double fileDuration, double sampleRate, int numChannels, juce::int64 dateAdded)
+{
+  TrackStore::TrackId trackId = trackStore.add(fileURL, fileTitle, fileDuration, sampleRate, numChannels, dateAdded);
+  librarySearch.addTitle(fileTitle);
+  librarySort.trackAdded(trackId);
+  jassert(librarySearch.getNumTitles() == static_cast<size_t>(trackId) + 1);
+  return trackId;
 }
 
 bool PlaylistComponent::isIncomingFileOfValidType(const juce::File& incomingFile, juce::StringArray validFileTypes)
@@ -552,24 +593,28 @@ void PlaylistComponent::exportAndPersistCurrentPlaylist()
   // ----- Copy-pasted and reworked from PlaylistComponent::buttonClicked()'s 'exportLibraryButton' above ----- //
 
   // Save persisted playlist in current directory (1. easy reference and 2. so it works in different computers)
-  juce::File persistedPlaylistPath = juce::File::getCurrentWorkingDirectory().getChildFile("persisted-playlist.txt");
-
   // Note that it is being saved in "Builds/VisualStudio2022" (relative to OtoDecks.jucer)!
-  // DBG("\nHEY!\nPlaylistComponent::exportAndPersistCurrentPlaylist() says:\n'persisted-playlist.txt' is found at: " << persistedPlaylistPath.getFullPathName() << "\n");
+  // DBG("\nHEY!\nPlaylistComponent::exportAndPersistCurrentPlaylist() says:\n'persisted-playlist.otolib' is found at: " << persistedLibraryFile.getFullPathName() << "\n");
+
+  // ENTIRE library (not only what is currently filtered by 'searchEditor'), so the next start does not have to import it again
+  writeBinaryLibrary(persistedLibraryFile, trackStore.getTrackIds());
 
   // (Always) delete file as a way of "overwriting" content
-  persistedPlaylistPath.deleteFile();
+  persistedPlaylistFile.deleteFile();
+
+  // Tracks that are still waiting to be imported (imported again on the next start)
+  juce::StringArray unfinishedFiles = libraryImporter.getUnfinishedFiles();
+  if (unfinishedFiles.isEmpty()) return;
 
   // Create file output stream
-  juce::FileOutputStream fileOutputStream(persistedPlaylistPath);
+  juce::FileOutputStream fileOutputStream(persistedPlaylistFile);
 
   if (fileOutputStream.openedOk())
   {
-    // Loop through CURRENT fileURLs vector
-    for (const auto& URL : fileURLs)
+    for (const auto& URL : unfinishedFiles)
     {
       // Write to file with a line break
-      fileOutputStream << juce::String(URL) << "\n";
+      fileOutputStream << URL << "\n";
     }
   }
 }
@@ -2,46 +2,71 @@
 #include <JuceHeader.h>
 #include <vector>
 #include <string>
+#include <functional>
+#include "LibraryImporter.h"
+#include "TrackMetadataCache.h"
+#include "LibrarySearch.h"
+#include "TrackStore.h"
+#include "LibrarySort.h"
+#include "LibraryFile.h"
+#include "LibraryCellPainter.h"
 
 class PlaylistComponent : public juce::Component,
                           public juce::TableListBoxModel,
+                          public juce::TableHeaderComponent::Listener,
                           public juce::Button::Listener,
                           public juce::TextEditor::Listener,
-                          public juce::FileDragAndDropTarget
+                          public juce::FileDragAndDropTarget,
+                          public LibraryImporter::Listener
 {
 public:
-  PlaylistComponent(juce::Colour _leftColour,
-                    juce::Colour _rightColour);
+  PlaylistComponent();
   ~PlaylistComponent() override;
 
+  // One 'Load' column per deck, in each deck's colour (called by MainComponent whenever a deck is added or removed)
+  void setDeckColours(const juce::Array<juce::Colour>& colours);
+
   void paint(juce::Graphics&) override;
   void resized() override;
 
   int getNumRows() override;
   void paintRowBackground(juce::Graphics &, int rowNumber, int width, int height, bool rowIsSelected) override;
   void paintCell(juce::Graphics&, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override;
-  juce::Component* refreshComponentForCell(int rowNumber, int columnId, bool isRowSelected, juce::Component* existingComponentToUpdate) override;
+  void cellClicked(int rowNumber, int columnId, const juce::MouseEvent& event) override;
+  void sortOrderChanged(int newSortColumnId, bool isForwards) override;
+
+  // Called by tableComp's header (eg. "Path" or "Added" shown from its menu)
+  void tableColumnsChanged(juce::TableHeaderComponent* header) override;
+  void tableColumnsResized(juce::TableHeaderComponent* header) override;
+  void tableSortOrderChanged(juce::TableHeaderComponent* header) override;
 
   void buttonClicked(juce::Button* button) override;
   void textEditorTextChanged(juce::TextEditor& editor) override;
 
-  // Made public to be accessed in MainComponent (for tableComp's 'Load' button to work)
-  bool loadToDeck = false;
-  int deckNumber = 1;
-  std::string fileURL = "";
+  // Set by MainComponent, called when one of tableComp's 'Load' buttons is clicked ('deckNumber' starts at 1)
+  std::function<void(int deckNumber, std::string fileURL)> onLoadToDeck;
 
   bool isInterestedInFileDrag(const juce::StringArray& files) override;
   void filesDropped(const juce::StringArray& files, int x, int y) override;
 
+  // Called by 'libraryImporter' as tracks are imported in the background
+  void importBatchReady(const std::vector<LibraryImporter::ImportedTrack>& batch) override;
+  void importProgressChanged(const LibraryImporter::Progress& progress) override;
+  void importFinished(const LibraryImporter::Progress& progress, const juce::StringArray& missingFiles, bool wasCancelled) override;
+
 private:
   // ----- General variables ----- //
   juce::Array<juce::Button*> buttons;
   juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);         // Used in buttons above tableComp
   juce::Colour myBlackLight = juce::Colour::fromRGB(40, 40, 40);    // Used in tableComp's background
-  juce::Colour myBlackLighter = juce::Colour::fromRGB(60, 60, 60);  // Used in tableComp's alternating rows
-  juce::Colour myBlackLightest = juce::Colour::fromRGB(80, 80, 80); // Used in tableComp's alternating rows
-  juce::Colour leftColour;                                          // Used in tableComp's 'Load' button
-  juce::Colour rightColour;                                         // Used in tableComp's 'Load' button
+
+  // Column IDs of tableComp ('Load' columns are numbered from 'firstLoadColumnId', one per deck, and "Path" and "Added" start hidden)
+  static constexpr int titleColumnId = LibraryCellPainter::titleColumnId;
+  static constexpr int durationColumnId = LibraryCellPainter::durationColumnId;
+  static constexpr int pathColumnId = LibraryCellPainter::pathColumnId;
+  static constexpr int addedColumnId = LibraryCellPainter::addedColumnId;
+  static constexpr int removeColumnId = LibraryCellPainter::removeColumnId;
+  static constexpr int firstLoadColumnId = LibraryCellPainter::firstLoadColumnId;
 
   // ----- Components ----- //
   juce::TextEditor searchEditor{ "Search for tracks" };
@@ -51,25 +76,50 @@ private:
   juce::TextButton exportLibraryButton { "Save Library" };
   juce::TableListBox tableComponent;
 
+  // Only visible while 'libraryImporter' is busy
+  juce::Label importStatusLabel;
+  juce::TextButton cancelImportButton{ "Cancel Import" };
+
   // ----- For 'importTrackButton' to work ----- //
   juce::AudioFormatManager formatManager;
-  std::vector<std::string> fileURLs;
-  std::vector<std::string> fileTitles;
-  std::vector<double> fileDurations;
+  TrackMetadataCache metadataCache;
+  LibraryImporter libraryImporter{ formatManager, metadataCache };
+  TrackStore trackStore;
+  LibraryCellPainter cellPainter{ trackStore }; // Paints tableComp's rows and cells (including its 'Load' and 'X' buttons)
+
+  // ----- For 'searchEditor' to work ----- //
+  // Titles are added and removed along with 'trackStore', so its IDs are also 'librarySearch's indices
+  // tableComp's rows are 'trackStore's IDs, or 'librarySearch's matches while searching (so nothing is copied)
+  LibrarySearch librarySearch;
+  bool isSearching = false;
 
-  // A copy for original items (called when importing library for 'searchEditor' purposes)
-  std::vector<std::string> fileURLsCopy;
-  std::vector<std::string> fileTitlesCopy;
-  std::vector<double> fileDurationsCopy;
+  // ----- For sorting tableComp by its headers ----- //
+  // Rows are read from the end of 'librarySort's order when sorted backwards
+  LibrarySort librarySort{ trackStore };
+  int sortColumnId = 0; // 0 until a header is clicked (tracks are then in the order they were added)
+  bool isSortedForwards = true;
+  std::vector<TrackStore::TrackId> sortedMatches; // 'librarySearch's matches in sorted order, while searching and sorted
+  bool sortedMatchesHaveRemovals = false;         // 'sortedMatches' may still hold removed tracks (dropped when rows are next read)
 
   // ----- General helper and refactored functions ----- //
-  juce::String formatDoubleToMMSS(double durationInSeconds);
   void readIncomingFileAndUpdateTable(juce::File incomingFile);
   void readIncomingLibraryAndUpdateTable(juce::File incomingLibrary);
+  void readIncomingBinaryLibraryAndUpdateTable(const juce::File& incomingLibrary);
+  bool writeBinaryLibrary(const juce::File& library, const std::vector<TrackStore::TrackId>& trackIds);
+  TrackStore::TrackId addTrack(const juce::String& fileURL, const juce::String& fileTitle, double fileDuration, double sampleRate, int numChannels, juce::int64 dateAdded = 0); // 0 means now
   bool isIncomingFileOfValidType(const juce::File& incomingFile, juce::StringArray validFileTypes);
+  void applySearchFilter();
+  TrackStore::TrackId getTrackId(int rowNumber); // TrackStore::noTrack if 'rowNumber' is not a row
+  bool getSortKey(int columnId, LibrarySort::Key& key); // false if tableComp is not sorted by 'columnId'
+  void updateSortedMatches();
 
   // ----- For persisting playlist (whether or not user wants to save/export library) ----- //
   void exportAndPersistCurrentPlaylist();
+  juce::File metadataCacheFile = juce::File::getCurrentWorkingDirectory().getChildFile("track-metadata-cache.bin");
+
+  // Imported tracks are persisted as a binary library, and only tracks still waiting to be imported as a .txt
+  juce::File persistedLibraryFile = juce::File::getCurrentWorkingDirectory().getChildFile("persisted-playlist.otolib");
+  juce::File persistedPlaylistFile = juce::File::getCurrentWorkingDirectory().getChildFile("persisted-playlist.txt");
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaylistComponent)
 };
@@ -0,0 +1,241 @@
+#include <JuceHeader.h>
+#include "ReadAheadAudioSource.h"
+
+ReadAheadAudioSource::ReadAheadAudioSource(std::unique_ptr<juce::PositionableAudioSource> _source,
+                                           juce::TimeSliceThread& _backgroundThread,
+                                           int _numberOfSamplesToBuffer,
+                                           int _numberOfChannels)
+  : source(std::move(_source)),
+    backgroundThread(_backgroundThread),
+    numberOfSamplesToBuffer(juce::jmax(_numberOfSamplesToBuffer, maxSamplesPerRead * 2)),
+    numberOfChannels(_numberOfChannels),
+    totalLength(source->getTotalLength())
+{
+}
+
+ReadAheadAudioSource::~ReadAheadAudioSource()
+{
+  releaseResources();
+}
+
+void ReadAheadAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+  // Make sure 'backgroundThread' is not using the buffer while it is being (re)allocated
+  backgroundThread.removeTimeSliceClient(this);
+
+  source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+  // Always hold a few blocks, however small the requested read-ahead is
+  numberOfSamplesToBuffer = juce::jmax(numberOfSamplesToBuffer, samplesPerBlockExpected * 4);
+  buffer.setSize(numberOfChannels, numberOfSamplesToBuffer);
+  buffer.clear();
+  loopHeadBuffer.setSize(numberOfChannels, loopHeadLength);
+
+  {
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+    bufferValidStart = juce::jmax(nextPlayPos.load(), static_cast<juce::int64>(0));
+    bufferValidEnd = bufferValidStart;
+    loopHeadStart = -1;
+    loopHeadEnd = -1;
+  }
+  loopHeadRequested = -1;
+
+  isPrepared = true;
+  backgroundThread.addTimeSliceClient(this);
+}
+
+void ReadAheadAudioSource::releaseResources()
+{
+  backgroundThread.removeTimeSliceClient(this);
+
+  if (isPrepared) source->releaseResources();
+  isPrepared = false;
+
+  buffer.setSize(numberOfChannels, 0);
+  loopHeadBuffer.setSize(numberOfChannels, 0);
+}
+
+void ReadAheadAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  const juce::int64 playPos = nextPlayPos.load();
+  const juce::int64 playEnd = playPos + bufferToFill.numSamples;
+
+  {
+    // Held while copying, so 'backgroundThread' cannot reuse this part of the ring buffer at the same time
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+
+    const juce::int64 copyStart = juce::jlimit(bufferValidStart, bufferValidEnd, playPos);
+    const juce::int64 copyEnd = juce::jlimit(bufferValidStart, bufferValidEnd, playEnd);
+    const bool ringCoversBlock = copyStart == playPos && copyEnd == playEnd;
+    const bool loopHeadCoversBlock = loopHeadStart >= 0 && loopHeadStart <= playPos && playEnd <= loopHeadEnd;
+
+    // Just jumped back to the start of a loop, and the ring buffer has not caught up yet
+    if (isPrepared && !ringCoversBlock && loopHeadCoversBlock)
+    {
+      for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+      {
+        const int sourceChannel = juce::jmin(channel, numberOfChannels - 1);
+        bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, loopHeadBuffer, sourceChannel, static_cast<int>(playPos - loopHeadStart), bufferToFill.numSamples);
+      }
+    }
+    else if (!isPrepared || copyEnd <= copyStart)
+    {
+      bufferToFill.clearActiveBufferRegion();
+    }
+    else
+    {
+      // Silence before and after the part that is ready
+      const int silenceBefore = static_cast<int>(copyStart - playPos);
+      const int silenceAfter = static_cast<int>(playEnd - copyEnd);
+      if (silenceBefore > 0) bufferToFill.buffer->clear(bufferToFill.startSample, silenceBefore);
+      if (silenceAfter > 0) bufferToFill.buffer->clear(bufferToFill.startSample + bufferToFill.numSamples - silenceAfter, silenceAfter);
+
+      // Copy the part that is ready (in two goes if it wraps around the end of the ring buffer)
+      for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+      {
+        const int sourceChannel = juce::jmin(channel, numberOfChannels - 1);
+        juce::int64 position = copyStart;
+        int destinationIndex = bufferToFill.startSample + silenceBefore;
+
+        while (position < copyEnd)
+        {
+          const int ringIndex = static_cast<int>(position % numberOfSamplesToBuffer);
+          const int numToCopy = static_cast<int>(juce::jmin(copyEnd - position, static_cast<juce::int64>(numberOfSamplesToBuffer - ringIndex)));
+          bufferToFill.buffer->copyFrom(channel, destinationIndex, buffer, sourceChannel, ringIndex, numToCopy);
+          position += numToCopy;
+          destinationIndex += numToCopy;
+        }
+      }
+    }
+
+    // Only count samples that actually exist in the source as missing
+    const juce::int64 samplesWanted = juce::jmin(playEnd, totalLength) - juce::jmax(playPos, static_cast<juce::int64>(0));
+    if (isPrepared && !loopHeadCoversBlock && samplesWanted > 0 && copyEnd - copyStart < samplesWanted) ++numUnderruns;
+  }
+
+  // Do not overwrite a seek that happened while this block was being copied
+  juce::int64 expectedPos = playPos;
+  nextPlayPos.compare_exchange_strong(expectedPos, playEnd);
+}
+
+void ReadAheadAudioSource::setNextReadPosition(juce::int64 newPosition)
+{
+  nextPlayPos = newPosition;
+}
+
+juce::int64 ReadAheadAudioSource::getNextReadPosition() const
+{
+  return nextPlayPos.load();
+}
+
+juce::int64 ReadAheadAudioSource::getTotalLength() const
+{
+  return totalLength;
+}
+
+bool ReadAheadAudioSource::isLooping() const
+{
+  return false;
+}
+
+int ReadAheadAudioSource::getNumUnderruns() const
+{
+  return numUnderruns.load();
+}
+
+void ReadAheadAudioSource::setLoopStartHint(juce::int64 loopStart)
+{
+  loopStartHint = loopStart;
+}
+
+int ReadAheadAudioSource::useTimeSlice()
+{
+  if (!isPrepared) return 100;
+
+  // Buffer the start of a new loop first, as playback can jump back to it at any time
+  const juce::int64 loopStart = loopStartHint.load();
+  if (loopStart != loopHeadRequested)
+  {
+    readLoopHead(loopStart);
+    return 0;
+  }
+
+  // Nothing before the start of the source needs buffering
+  const juce::int64 playPos = juce::jmax(nextPlayPos.load(), static_cast<juce::int64>(0));
+  juce::int64 sectionStart;
+  juce::int64 sectionEnd;
+
+  {
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+
+    // After a seek outside of what is buffered, start again from the new position
+    if (playPos < bufferValidStart || playPos > bufferValidEnd)
+    {
+      bufferValidStart = playPos;
+      bufferValidEnd = playPos;
+    }
+    // Otherwise free up what has been played, but keep a little behind the play position so small backward seeks stay instant
+    else
+    {
+      bufferValidStart = juce::jmax(bufferValidStart, playPos - numberOfSamplesToBuffer / 8);
+    }
+
+    sectionStart = bufferValidEnd;
+    sectionEnd = juce::jmin(bufferValidStart + numberOfSamplesToBuffer, totalLength);
+  }
+
+  // Buffer is full (or the end of the source has been reached)
+  if (sectionEnd <= sectionStart) return 5;
+
+  const juce::int64 readEnd = juce::jmin(sectionEnd, sectionStart + maxSamplesPerRead);
+  readIntoBuffer(sectionStart, readEnd);
+
+  {
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+    bufferValidEnd = readEnd;
+  }
+
+  // Come straight back if there is more to read
+  return readEnd < sectionEnd ? 0 : 5;
+}
+
+void ReadAheadAudioSource::readIntoBuffer(juce::int64 startPosition, juce::int64 endPosition)
+{
+  source->setNextReadPosition(startPosition);
+
+  juce::int64 position = startPosition;
+  while (position < endPosition)
+  {
+    const int ringIndex = static_cast<int>(position % numberOfSamplesToBuffer);
+    const int numToRead = static_cast<int>(juce::jmin(endPosition - position, static_cast<juce::int64>(numberOfSamplesToBuffer - ringIndex)));
+
+    juce::AudioSourceChannelInfo info(&buffer, ringIndex, numToRead);
+    source->getNextAudioBlock(info);
+    position += numToRead;
+  }
+}
+
+void ReadAheadAudioSource::readLoopHead(juce::int64 loopStart)
+{
+  // Stop the audio thread from using the old loop's audio while it is overwritten
+  {
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+    loopHeadStart = -1;
+    loopHeadEnd = -1;
+  }
+
+  loopHeadRequested = loopStart;
+  if (loopStart < 0 || loopStart >= totalLength) return;
+
+  const juce::int64 headEnd = juce::jmin(loopStart + loopHeadLength, totalLength);
+  source->setNextReadPosition(loopStart);
+
+  juce::AudioSourceChannelInfo info(&loopHeadBuffer, 0, static_cast<int>(headEnd - loopStart));
+  source->getNextAudioBlock(info);
+
+  {
+    const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+    loopHeadStart = loopStart;
+    loopHeadEnd = headEnd;
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+/*
+Works like juce::BufferingAudioSource, but also counts underruns.
+1. a shared juce::TimeSliceThread keeps a ring buffer filled ahead of the play position
+2. the audio thread only ever copies from that ring buffer (it never touches the disk or the decoder)
+3. if the audio thread catches up with the background thread, silence is played and an underrun is counted
+4. the start of a loop can be kept buffered separately, so jumping back to it never waits on the disk
+*/
+class ReadAheadAudioSource : public juce::PositionableAudioSource,
+                             private juce::TimeSliceClient
+{
+public:
+  ReadAheadAudioSource(std::unique_ptr<juce::PositionableAudioSource> _source,
+                       juce::TimeSliceThread& _backgroundThread,
+                       int _numberOfSamplesToBuffer,
+                       int _numberOfChannels = 2);
+  ~ReadAheadAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  void setNextReadPosition(juce::int64 newPosition) override;
+  juce::int64 getNextReadPosition() const override;
+  juce::int64 getTotalLength() const override;
+  bool isLooping() const override;
+
+  // Number of blocks (since this source was created) that could not be fully served from the buffer
+  int getNumUnderruns() const;
+
+  // Position that playback may jump back to at any time (less than 0 for none)
+  void setLoopStartHint(juce::int64 loopStart);
+
+private:
+  // Called on 'backgroundThread'
+  int useTimeSlice() override;
+  void readIntoBuffer(juce::int64 startPosition, juce::int64 endPosition);
+  void readLoopHead(juce::int64 loopStart);
+
+  std::unique_ptr<juce::PositionableAudioSource> source;
+  juce::TimeSliceThread& backgroundThread;
+  int numberOfSamplesToBuffer;
+  int numberOfChannels;
+  juce::int64 totalLength;
+
+  // Ring buffer, indexed by (position % buffer size)
+  juce::AudioBuffer<float> buffer;
+
+  // Range of positions in 'buffer' that are ready to be played (only changed by 'backgroundThread')
+  juce::SpinLock bufferRangeLock;
+  juce::int64 bufferValidStart = 0;
+  juce::int64 bufferValidEnd = 0;
+
+  // Copy of the audio from the loop's start, used until the ring buffer catches up after a jump back (range also guarded by 'bufferRangeLock')
+  juce::AudioBuffer<float> loopHeadBuffer;
+  juce::int64 loopHeadStart = -1;
+  juce::int64 loopHeadEnd = -1;
+  std::atomic<juce::int64> loopStartHint{ -1 };
+  juce::int64 loopHeadRequested = -1; // Only used by 'backgroundThread'
+
+  std::atomic<juce::int64> nextPlayPos{ 0 };
+  std::atomic<int> numUnderruns{ 0 };
+  std::atomic<bool> isPrepared{ false };
+
+  // Largest amount read from 'source' in one go (so that seeks are answered quickly)
+  static constexpr int maxSamplesPerRead = 8'192;
+  static constexpr int loopHeadLength = maxSamplesPerRead * 2;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReadAheadAudioSource)
+};
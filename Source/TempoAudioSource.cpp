@@ -0,0 +1,313 @@
+#include <JuceHeader.h>
+#include "TempoAudioSource.h"
+
+TempoAudioSource::TempoAudioSource(juce::AudioSource* _input)
+  : input(_input),
+    resampleSource(_input, false, numChannels)
+{
+  jassert(input != nullptr);
+}
+
+TempoAudioSource::~TempoAudioSource()
+{
+}
+
+void TempoAudioSource::prepareToPlay(int samplesPerBlockExpected, double _sampleRate)
+{
+  // Also prepares 'input'
+  resampleSource.prepareToPlay(samplesPerBlockExpected, _sampleRate);
+
+  sampleRate = _sampleRate;
+  maxBlockSize = juce::jmax(1, samplesPerBlockExpected);
+
+  // 25ms frames are long enough to hold a bass note's cycle, and short enough not to smear drums
+  frameLength = juce::jmax(64, juce::roundToInt(sampleRate * 0.025) & ~1);
+  hopLength = frameLength / 2;
+  searchRange = juce::jmax(1, juce::roundToInt(sampleRate * 0.005));
+
+  window.resize(static_cast<size_t>(frameLength));
+  for (int i = 0; i < frameLength; ++i)
+  {
+    window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / frameLength);
+  }
+  overlapBuffer.setSize(numChannels, frameLength);
+
+  // Enough for the largest read of either mode, at the fastest speed
+  int highQualitySize = static_cast<int>(std::ceil(maxBlockSize * maxSpeed)) + 16;
+  int keyLockSize = frameLength + (2 * searchRange) + static_cast<int>(std::ceil(hopLength * maxSpeed)) + 16;
+  inputBuffer.setSize(numChannels, juce::jmax(highQualitySize, keyLockSize));
+
+  flush();
+}
+
+void TempoAudioSource::releaseResources()
+{
+  resampleSource.releaseResources();
+}
+
+void TempoAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  switch (mode)
+  {
+    case Mode::standard:
+      // Nothing moves at a speed of 0 (juce::ResamplingAudioSource needs a ratio above 0)
+      if (speed <= 0.0) bufferToFill.clearActiveBufferRegion();
+      else resampleSource.getNextAudioBlock(bufferToFill);
+      break;
+
+    case Mode::highQuality:
+      processHighQuality(bufferToFill);
+      break;
+
+    case Mode::keyLock:
+      processKeyLock(bufferToFill);
+      break;
+  }
+}
+
+void TempoAudioSource::setSpeed(double ratio)
+{
+  speed = juce::jlimit(0.0, maxSpeed, ratio);
+  if (speed > 0.0) resampleSource.setResamplingRatio(speed);
+}
+
+void TempoAudioSource::setMode(Mode newMode)
+{
+  if (newMode == mode) return;
+
+  // Each mode reads ahead differently, so start again from where the input is
+  mode = newMode;
+  flush();
+}
+
+TempoAudioSource::Mode TempoAudioSource::getMode() const
+{
+  return mode;
+}
+
+void TempoAudioSource::flush()
+{
+  resampleSource.flushBuffers();
+
+  inputBufferStart = 0;
+  numBufferedSamples = 0;
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    interpolators[channel].reset();
+    antiAliasingFilters[channel][0].reset();
+    antiAliasingFilters[channel][1].reset();
+  }
+
+  overlapBuffer.clear();
+  readyPosition = hopLength;
+  analysisPosition = 0.0;
+  previousFramePosition = -1;
+}
+
+void TempoAudioSource::processHighQuality(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  // Nothing moves at a speed of 0
+  if (speed <= 0.0)
+  {
+    bufferToFill.clearActiveBufferRegion();
+    return;
+  }
+
+  updateAntiAliasing();
+
+  int numOutputChannels = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+  for (int channel = numOutputChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+  {
+    bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+  }
+
+  // In chunks no bigger than prepareToPlay() allowed for, so 'inputBuffer' is always big enough
+  for (int done = 0; done < bufferToFill.numSamples;)
+  {
+    int numSamples = juce::jmin(maxBlockSize, bufferToFill.numSamples - done);
+
+    // The interpolators may look one sample past where they finish
+    juce::int64 needed = static_cast<juce::int64>(std::ceil(numSamples * speed)) + 2;
+    bufferInput(inputBufferStart, inputBufferStart + needed);
+
+    int numUsed = 0;
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+      numUsed = interpolators[channel].process(speed, inputBuffer.getReadPointer(channel), bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + done), numSamples);
+    }
+
+    // Every channel uses the same amount, as they share one speed
+    bufferInput(inputBufferStart + numUsed, inputBufferStart + numUsed);
+    done += numSamples;
+  }
+}
+
+void TempoAudioSource::processKeyLock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  // Nothing moves at a speed of 0
+  if (speed <= 0.0)
+  {
+    bufferToFill.clearActiveBufferRegion();
+    return;
+  }
+
+  int numOutputChannels = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+  for (int channel = numOutputChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+  {
+    bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+  }
+
+  for (int done = 0; done < bufferToFill.numSamples;)
+  {
+    if (readyPosition >= hopLength) addNextFrame();
+
+    int numSamples = juce::jmin(hopLength - readyPosition, bufferToFill.numSamples - done);
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+      bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + done, overlapBuffer, channel, readyPosition, numSamples);
+    }
+
+    readyPosition += numSamples;
+    done += numSamples;
+  }
+}
+
+void TempoAudioSource::bufferInput(juce::int64 keepFromPosition, juce::int64 endPosition)
+{
+  // Drop what is no longer needed
+  int numToDrop = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numBufferedSamples), keepFromPosition - inputBufferStart));
+  if (numToDrop > 0)
+  {
+    numBufferedSamples -= numToDrop;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      float* samples = inputBuffer.getWritePointer(channel);
+      std::memmove(samples, samples + numToDrop, static_cast<size_t>(numBufferedSamples) * sizeof(float));
+    }
+    inputBufferStart += numToDrop;
+  }
+
+  // Read the rest straight into the buffer
+  int numToRead = static_cast<int>(endPosition - inputBufferStart) - numBufferedSamples;
+  jassert(numBufferedSamples + numToRead <= inputBuffer.getNumSamples());
+  numToRead = juce::jmin(numToRead, inputBuffer.getNumSamples() - numBufferedSamples);
+  if (numToRead <= 0) return;
+
+  juce::AudioSourceChannelInfo part(&inputBuffer, numBufferedSamples, numToRead);
+  input->getNextAudioBlock(part);
+
+  // Low-pass what was just read, so speeding up does not fold high frequencies back down
+  if (mode == Mode::highQuality && antiAliasingSpeed > 1.0)
+  {
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      float* samples = inputBuffer.getWritePointer(channel, numBufferedSamples);
+      antiAliasingFilters[channel][0].processSamples(samples, numToRead);
+      antiAliasingFilters[channel][1].processSamples(samples, numToRead);
+    }
+  }
+
+  numBufferedSamples += numToRead;
+}
+
+void TempoAudioSource::updateAntiAliasing()
+{
+  // Small speed changes are not worth new coefficients
+  if (std::abs(speed - antiAliasingSpeed) < 0.01) return;
+
+  // The filters only run above 1x, so whatever they held from the last time they did is stale
+  if ((speed > 1.0) != (antiAliasingSpeed > 1.0))
+  {
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      antiAliasingFilters[channel][0].reset();
+      antiAliasingFilters[channel][1].reset();
+    }
+  }
+
+  antiAliasingSpeed = speed;
+  if (speed <= 1.0) return;
+
+  // Butterworth Qs for a 4th-order low-pass, just below the new Nyquist
+  double cutoff = (sampleRate * 0.45) / speed;
+  juce::IIRCoefficients first = juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, 0.5412);
+  juce::IIRCoefficients second = juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, 1.3066);
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    antiAliasingFilters[channel][0].setCoefficients(first);
+    antiAliasingFilters[channel][1].setCoefficients(second);
+  }
+}
+
+void TempoAudioSource::addNextFrame()
+{
+  // The first half of the buffer has been played, so move the second half up to make room for the next frame
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    float* samples = overlapBuffer.getWritePointer(channel);
+    std::memmove(samples, samples + hopLength, static_cast<size_t>(frameLength - hopLength) * sizeof(float));
+    juce::FloatVectorOperations::clear(samples + (frameLength - hopLength), hopLength);
+  }
+
+  // Keep everything the search and the last frame's continuation still need
+  juce::int64 nominalPosition = static_cast<juce::int64>(analysisPosition);
+  juce::int64 keepFromPosition = nominalPosition - searchRange;
+  if (previousFramePosition >= 0) keepFromPosition = juce::jmin(keepFromPosition, previousFramePosition + hopLength);
+  bufferInput(keepFromPosition, nominalPosition + searchRange + frameLength);
+
+  juce::int64 framePosition = nominalPosition;
+  if (previousFramePosition >= 0) framePosition += findBestOffset(nominalPosition);
+
+  // Windowed frame, added on top of the last one's second half
+  int frameStart = static_cast<int>(framePosition - inputBufferStart);
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    const float* frame = inputBuffer.getReadPointer(channel, frameStart);
+    float* samples = overlapBuffer.getWritePointer(channel);
+    for (int i = 0; i < frameLength; ++i) samples[i] += window[static_cast<size_t>(i)] * frame[i];
+  }
+
+  previousFramePosition = framePosition;
+  analysisPosition += hopLength * speed;
+  readyPosition = 0;
+}
+
+int TempoAudioSource::findBestOffset(juce::int64 nominalPosition) const
+{
+  // What would have followed the last frame, had the input not been stretched
+  int templateStart = static_cast<int>(previousFramePosition + hopLength - inputBufferStart);
+  int overlapLength = frameLength - hopLength;
+  const float* left = inputBuffer.getReadPointer(0);
+  const float* right = inputBuffer.getReadPointer(1);
+
+  // Never search before the start of what is buffered
+  int lowestOffset = static_cast<int>(juce::jmax(static_cast<juce::int64>(-searchRange), inputBufferStart - nominalPosition));
+
+  int bestOffset = 0;
+  double bestScore = -std::numeric_limits<double>::infinity();
+  for (int offset = lowestOffset; offset <= searchRange; ++offset)
+  {
+    int candidateStart = static_cast<int>(nominalPosition + offset - inputBufferStart);
+
+    // Normalised cross-correlation of the mono mix, so louder candidates are not favoured
+    double correlation = 0.0;
+    double energy = 0.0;
+    for (int i = 0; i < overlapLength; i += correlationStride)
+    {
+      float a = left[templateStart + i] + right[templateStart + i];
+      float b = left[candidateStart + i] + right[candidateStart + i];
+      correlation += a * b;
+      energy += b * b;
+    }
+
+    double score = correlation / std::sqrt(energy + 1.0e-9);
+    if (score > bestScore)
+    {
+      bestScore = score;
+      bestOffset = offset;
+    }
+  }
+
+  return bestOffset;
+}
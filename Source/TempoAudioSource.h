@@ -0,0 +1,86 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+Plays its input faster or slower, in one of three modes.
+1. standard: juce::ResamplingAudioSource (cheapest, pitch follows speed)
+2. highQuality: 4th-order Lagrange interpolation, with the input low-passed first when sped up (pitch follows speed, far less aliasing)
+3. keyLock: WSOLA time-stretch, which overlaps short frames of the input at the new tempo, each nudged to where it best lines up with the last (pitch stays the same)
+Every mode does a fixed amount of work per output sample, and only allocates in prepareToPlay().
+*/
+class TempoAudioSource : public juce::AudioSource
+{
+public:
+  enum class Mode
+  {
+    standard,
+    highQuality,
+    keyLock
+  };
+
+  TempoAudioSource(juce::AudioSource* _input);
+  ~TempoAudioSource() override;
+
+  void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+  void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+  void releaseResources() override;
+
+  // Both are called on the audio thread (or before audio starts)
+  void setSpeed(double ratio);
+  void setMode(Mode newMode);
+  Mode getMode() const;
+
+  // Drops any input read ahead (call after the input has been seeked)
+  void flush();
+
+  static constexpr int numModes = 3;
+  static constexpr int numChannels = 2;
+  static constexpr double maxSpeed = 3.0;
+
+private:
+  void processHighQuality(const juce::AudioSourceChannelInfo& bufferToFill);
+  void processKeyLock(const juce::AudioSourceChannelInfo& bufferToFill);
+
+  // Drops input before 'keepFromPosition', then reads more until 'inputBuffer' holds everything up to 'endPosition' (both counted from the last flush)
+  void bufferInput(juce::int64 keepFromPosition, juce::int64 endPosition);
+
+  // Sets the low-pass in front of the interpolators for the current speed
+  void updateAntiAliasing();
+
+  // Overlap-adds the next key-lock frame, so another 'hopLength' samples are ready
+  void addNextFrame();
+
+  // Offset from 'nominalPosition' (within 'searchRange') whose start best continues the last frame
+  int findBestOffset(juce::int64 nominalPosition) const;
+
+  juce::AudioSource* input;
+  juce::ResamplingAudioSource resampleSource;
+  Mode mode = Mode::standard;
+  double speed = 1.0;
+  double sampleRate = 0.0;
+  int maxBlockSize = 0;
+
+  // Input read ahead by the high quality and key-lock modes
+  juce::AudioBuffer<float> inputBuffer;
+  juce::int64 inputBufferStart = 0; // Position of inputBuffer's first sample
+  int numBufferedSamples = 0;
+
+  // ----- High quality ----- //
+  juce::LagrangeInterpolator interpolators[numChannels];
+  juce::IIRFilter antiAliasingFilters[numChannels][2]; // 2 biquads make a 4th-order low-pass
+  double antiAliasingSpeed = 1.0; // Speed the filters were last set for (1 or less means they are not used)
+
+  // ----- Key lock ----- //
+  int frameLength = 0;
+  int hopLength = 0; // Frames overlap by half
+  int searchRange = 0;
+  int correlationStride = 4; // Only every 4th sample is compared when searching, which is plenty to line up the waveforms
+  std::vector<float> window; // Hann, so overlapping frames sum to 1
+  juce::AudioBuffer<float> overlapBuffer;
+  int readyPosition = 0; // How much of overlapBuffer's first 'hopLength' samples has been played
+  double analysisPosition = 0.0; // Where the next frame would be taken from if no nudge was needed
+  juce::int64 previousFramePosition = -1; // Where the last frame was taken from (-1 for none since the last flush)
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TempoAudioSource)
+};
@@ -0,0 +1,85 @@
+#include <JuceHeader.h>
+#include "TrackAnalyser.h"
+
+std::atomic<juce::int64> TrackAnalyser::totalBytesRead{ 0 };
+
+// Passes everything through to 'source', adding up how many bytes were read (into 'bytesRead' if there is one, and into 'totalBytesRead')
+class CountingInputStream : public juce::InputStream
+{
+public:
+  CountingInputStream(std::unique_ptr<juce::InputStream> _source, juce::int64* _bytesRead, std::atomic<juce::int64>& _totalBytesRead)
+    : source(std::move(_source)),
+      bytesRead(_bytesRead),
+      totalBytesRead(_totalBytesRead)
+  {
+  }
+
+  juce::int64 getTotalLength() override { return source->getTotalLength(); }
+  bool isExhausted() override { return source->isExhausted(); }
+  juce::int64 getPosition() override { return source->getPosition(); }
+  bool setPosition(juce::int64 newPosition) override { return source->setPosition(newPosition); }
+
+  int read(void* destBuffer, int maxBytesToRead) override
+  {
+    int numRead = source->read(destBuffer, maxBytesToRead);
+    if (numRead > 0)
+    {
+      if (bytesRead != nullptr) *bytesRead += numRead;
+      totalBytesRead += numRead;
+    }
+    return numRead;
+  }
+
+private:
+  std::unique_ptr<juce::InputStream> source;
+  juce::int64* bytesRead;
+  std::atomic<juce::int64>& totalBytesRead;
+};
+
+std::unique_ptr<juce::AudioFormatReader> TrackAnalyser::createReader(juce::AudioFormatManager& formatManager, const juce::File& file, Stats& stats)
+{
+  std::unique_ptr<juce::InputStream> input = file.createInputStream();
+  if (input == nullptr) return nullptr;
+
+  return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(std::make_unique<CountingInputStream>(std::move(input), &stats.bytesRead, totalBytesRead)));
+}
+
+std::unique_ptr<juce::AudioFormatReader> TrackAnalyser::createReader(juce::AudioFormatManager& formatManager, const juce::File& file)
+{
+  std::unique_ptr<juce::InputStream> input = file.createInputStream();
+  if (input == nullptr) return nullptr;
+
+  return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(std::make_unique<CountingInputStream>(std::move(input), nullptr, totalBytesRead)));
+}
+
+juce::int64 TrackAnalyser::getTotalBytesRead()
+{
+  return totalBytesRead.load();
+}
+
+bool TrackAnalyser::run(juce::AudioFormatReader& reader, const std::vector<Consumer*>& consumers, std::function<bool()> shouldStop, Stats& stats)
+{
+  if (reader.sampleRate <= 0 || reader.lengthInSamples <= 0 || consumers.empty()) return false;
+
+  double startTime = juce::Time::getMillisecondCounterHiRes();
+  int numChannels = juce::jlimit(1, 2, static_cast<int>(reader.numChannels));
+  for (Consumer* consumer : consumers) consumer->analysisStarted(numChannels, reader.sampleRate, reader.lengthInSamples);
+
+  // Read in blocks, so a cancelled pass stops quickly
+  juce::AudioBuffer<float> block(numChannels, samplesPerBlock);
+
+  for (juce::int64 position = 0; position < reader.lengthInSamples; position += samplesPerBlock)
+  {
+    if (shouldStop && shouldStop()) return false;
+
+    int numToRead = static_cast<int>(juce::jmin(static_cast<juce::int64>(samplesPerBlock), reader.lengthInSamples - position));
+    reader.read(&block, 0, numToRead, position, true, true);
+    for (Consumer* consumer : consumers) consumer->analysisBlock(block, position, numToRead);
+  }
+
+  bool allFinished = true;
+  for (Consumer* consumer : consumers) allFinished = consumer->analysisFinished() && allFinished;
+
+  stats.milliseconds += juce::Time::getMillisecondCounterHiRes() - startTime;
+  return allFinished;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+Decodes a track once, handing every block to each of its consumers in turn
+(eg. the RAM copy a deck plays from, and the peak file both waveform views draw from),
+instead of every consumer opening and decoding the file itself.
+*/
+class TrackAnalyser
+{
+public:
+  // Receives the decoded audio of one pass, in order, from the start of the track
+  class Consumer
+  {
+  public:
+    virtual ~Consumer() = default;
+
+    virtual void analysisStarted(int numChannels, double sampleRate, juce::int64 lengthInSamples) = 0;
+    virtual void analysisBlock(const juce::AudioBuffer<float>& block, juce::int64 position, int numSamples) = 0;
+
+    // Only called if the whole track was read, returns false if the consumer could not use it
+    virtual bool analysisFinished() = 0;
+  };
+
+  struct Stats
+  {
+    juce::int64 bytesRead = 0;
+    double milliseconds = 0.0;
+  };
+
+  // Opens 'file', counting every byte read from it into 'stats'
+  static std::unique_ptr<juce::AudioFormatReader> createReader(juce::AudioFormatManager& formatManager, const juce::File& file, Stats& stats);
+
+  // Opens 'file' for reading as it plays (only counted in getTotalBytesRead(), as the reader may outlive any Stats)
+  static std::unique_ptr<juce::AudioFormatReader> createReader(juce::AudioFormatManager& formatManager, const juce::File& file);
+
+  // Every byte read through a createReader() reader since the app started, on any thread
+  static juce::int64 getTotalBytesRead();
+
+  // Reads all of 'reader' once (returns false if 'shouldStop' returns true part way through, or a consumer fails)
+  static bool run(juce::AudioFormatReader& reader, const std::vector<Consumer*>& consumers, std::function<bool()> shouldStop, Stats& stats);
+
+private:
+  static constexpr int samplesPerBlock = 65'536;
+  static std::atomic<juce::int64> totalBytesRead;
+};
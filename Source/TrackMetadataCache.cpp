@@ -0,0 +1,131 @@
+#include <JuceHeader.h>
+#include "TrackMetadataCache.h"
+
+TrackMetadataCache::TrackMetadataCache()
+{
+}
+
+TrackMetadataCache::~TrackMetadataCache()
+{
+}
+
+bool TrackMetadataCache::lookup(const juce::File& file, TrackMetadata& metadata) const
+{
+  const juce::ScopedReadLock srl(entriesLock);
+
+  auto found = entries.find(file.getFullPathName().toStdString());
+  if (found == entries.end()) return false;
+
+  // Only stat the file (never open it) to check if the entry is outdated
+  const Entry& entry = found->second;
+  if (entry.fileSize != file.getSize()) return false;
+  if (entry.modificationTime != file.getLastModificationTime().toMilliseconds()) return false;
+
+  metadata = entry.metadata;
+  return true;
+}
+
+void TrackMetadataCache::store(const juce::File& file, const TrackMetadata& metadata)
+{
+  Entry entry;
+  entry.fileSize = file.getSize();
+  entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+  entry.metadata = metadata;
+
+  const juce::ScopedWriteLock swl(entriesLock);
+  entries[file.getFullPathName().toStdString()] = std::move(entry);
+  hasUnsavedChanges = true;
+}
+
+void TrackMetadataCache::loadFromFile(const juce::File& cacheFile)
+{
+  juce::FileInputStream fileInputStream(cacheFile);
+  if (!fileInputStream.openedOk()) return;
+
+  juce::BufferedInputStream input(fileInputStream, 64 * 1024);
+
+  // Header: magic number, version, number of entries
+  if (input.readInt() != static_cast<int>(juce::ByteOrder::littleEndianInt("OTMC"))) return;
+  if (input.readInt() != cacheFileVersion) return;
+  int numEntries = input.readInt();
+
+  // A damaged count can never be bigger than what the file has room for
+  juce::int64 maxEntries = (cacheFile.getSize() - headerSize) / minEntrySize;
+  if (numEntries < 0 || numEntries > maxEntries) return;
+
+  const juce::ScopedWriteLock swl(entriesLock);
+  entries.reserve(entries.size() + static_cast<size_t>(numEntries));
+
+  for (int i = 0; i < numEntries && !input.isExhausted(); ++i)
+  {
+    std::string path = input.readString().toStdString();
+
+    Entry entry;
+    entry.fileSize = input.readInt64();
+    entry.modificationTime = input.readInt64();
+    entry.metadata.duration = input.readDouble();
+    entry.metadata.sampleRate = input.readDouble();
+    entry.metadata.numChannels = input.readInt();
+    entry.metadata.title = input.readString().toStdString();
+
+    entries[path] = std::move(entry);
+  }
+
+  hasUnsavedChanges = false;
+}
+
+void TrackMetadataCache::saveToFile(const juce::File& cacheFile)
+{
+  const juce::ScopedReadLock srl(entriesLock);
+  if (!hasUnsavedChanges && cacheFile.existsAsFile()) return;
+
+  // Write to a temporary file first, so a crash never leaves a half-written cache behind
+  juce::TemporaryFile temporaryFile(cacheFile);
+  {
+    juce::FileOutputStream output(temporaryFile.getFile());
+    if (!output.openedOk()) return;
+
+    output.writeInt(static_cast<int>(juce::ByteOrder::littleEndianInt("OTMC")));
+    output.writeInt(cacheFileVersion);
+    output.writeInt(static_cast<int>(entries.size()));
+
+    for (const auto& [path, entry] : entries)
+    {
+      output.writeString(juce::String(path));
+      output.writeInt64(entry.fileSize);
+      output.writeInt64(entry.modificationTime);
+      output.writeDouble(entry.metadata.duration);
+      output.writeDouble(entry.metadata.sampleRate);
+      output.writeInt(entry.metadata.numChannels);
+      output.writeString(juce::String(entry.metadata.title));
+    }
+
+    output.flush();
+    if (output.getStatus().failed()) return;
+  }
+
+  if (temporaryFile.overwriteTargetFileWithTemporary()) hasUnsavedChanges = false;
+}
+
+void TrackMetadataCache::removeMissingFiles()
+{
+  const juce::ScopedWriteLock swl(entriesLock);
+
+  for (auto it = entries.begin(); it != entries.end();)
+  {
+    if (juce::File(juce::String(it->first)).existsAsFile())
+    {
+      ++it;
+      continue;
+    }
+
+    it = entries.erase(it);
+    hasUnsavedChanges = true;
+  }
+}
+
+int TrackMetadataCache::getNumEntries() const
+{
+  const juce::ScopedReadLock srl(entriesLock);
+  return static_cast<int>(entries.size());
+}
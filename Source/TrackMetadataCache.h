@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+/*
+On-disk cache of track metadata, so that a warm start only needs to check each file's size and modification time.
+Entries are keyed by full path, and are only used if the file's size and modification time still match.
+Safe to use from LibraryImporter's worker threads.
+*/
+class TrackMetadataCache
+{
+public:
+  struct TrackMetadata
+  {
+    double duration = 0.0;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    std::string title;
+  };
+
+  TrackMetadataCache();
+  ~TrackMetadataCache();
+
+  // Returns true and fills 'metadata' if 'file' has a valid (ie. not outdated) entry
+  bool lookup(const juce::File& file, TrackMetadata& metadata) const;
+  void store(const juce::File& file, const TrackMetadata& metadata);
+
+  // Read/write the cache file (unknown or outdated cache files are ignored)
+  void loadFromFile(const juce::File& cacheFile);
+  void saveToFile(const juce::File& cacheFile);
+
+  // Forget files that have since been deleted (a stat per entry, so only worth doing eg. as the app closes)
+  void removeMissingFiles();
+
+  int getNumEntries() const;
+
+private:
+  struct Entry
+  {
+    juce::int64 fileSize = 0;
+    juce::int64 modificationTime = 0;
+    TrackMetadata metadata;
+  };
+
+  // Change this whenever the layout written by saveToFile() changes
+  static constexpr int cacheFileVersion = 1;
+  static constexpr juce::int64 headerSize = 12;
+  static constexpr juce::int64 minEntrySize = 38; // Two empty strings (their terminators), and the numbers
+
+  mutable juce::ReadWriteLock entriesLock;
+  std::unordered_map<std::string, Entry> entries;
+  std::atomic<bool> hasUnsavedChanges{ false }; // Cleared by saveToFile(), which only holds the read lock
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackMetadataCache)
+};
@@ -0,0 +1,176 @@
+#include <JuceHeader.h>
+#include <algorithm>
+#include "TrackStore.h"
+
+TrackStore::TrackStore()
+{
+}
+
+TrackStore::~TrackStore()
+{
+}
+
+TrackStore::TrackId TrackStore::add(const juce::String& fileURL, const juce::String& fileTitle, double fileDuration, double sampleRate, int numChannels, juce::int64 dateAdded)
+{
+  TrackId id = static_cast<TrackId>(fileURLs.size());
+  fileURLs.push_back(intern(fileURL));
+  fileTitles.push_back(intern(fileTitle));
+  fileDurationTexts.push_back(intern(formatDuration(fileDuration)));
+  fileDurations.push_back(static_cast<float>(fileDuration));
+  sampleRates.push_back(static_cast<float>(sampleRate));
+  channelCounts.push_back(static_cast<juce::uint8>(juce::jlimit(0, 255, numChannels)));
+
+  if (dateAdded == 0) dateAdded = juce::Time::currentTimeMillis();
+  datesAdded.push_back(dateAdded);
+
+  juce::int64 minute = dateAdded / 60'000;
+  if (minute != lastAddedMinute)
+  {
+    lastAddedMinute = minute;
+    lastDateAddedText = juce::Time(dateAdded).formatted("%Y-%m-%d %H:%M");
+  }
+  dateAddedTexts.push_back(intern(lastDateAddedText));
+  trackIds.push_back(id);
+  ++numTracks;
+  return id;
+}
+
+void TrackStore::remove(TrackId id)
+{
+  if (!contains(id)) return;
+
+  release(fileURLs[id]);
+  release(fileTitles[id]);
+  release(fileDurationTexts[id]);
+  release(dateAddedTexts[id]);
+  fileURLs[id] = nullptr;
+  fileTitles[id] = nullptr;
+  fileDurationTexts[id] = nullptr;
+  dateAddedTexts[id] = nullptr;
+  datesAdded[id] = 0;
+  fileDurations[id] = 0.0f;
+  sampleRates[id] = 0.0f;
+  channelCounts[id] = 0;
+
+  // Left in 'trackIds' until it is next asked for
+  trackIdsHaveRemovals = true;
+  --numTracks;
+}
+
+void TrackStore::clear()
+{
+  strings.clear();
+  fileURLs.clear();
+  fileTitles.clear();
+  fileDurationTexts.clear();
+  dateAddedTexts.clear();
+  datesAdded.clear();
+  fileDurations.clear();
+  sampleRates.clear();
+  channelCounts.clear();
+  trackIds.clear();
+  trackIdsHaveRemovals = false;
+  numTracks = 0;
+}
+
+bool TrackStore::contains(TrackId id) const
+{
+  return id < fileURLs.size() && fileURLs[id] != nullptr;
+}
+
+const juce::String& TrackStore::getURL(TrackId id) const
+{
+  static const juce::String none;
+  return contains(id) ? *fileURLs[id] : none;
+}
+
+const juce::String& TrackStore::getTitle(TrackId id) const
+{
+  static const juce::String none;
+  return contains(id) ? *fileTitles[id] : none;
+}
+
+double TrackStore::getDuration(TrackId id) const
+{
+  return contains(id) ? fileDurations[id] : 0.0;
+}
+
+const juce::String& TrackStore::getDurationText(TrackId id) const
+{
+  static const juce::String none;
+  return contains(id) ? *fileDurationTexts[id] : none;
+}
+
+juce::int64 TrackStore::getDateAdded(TrackId id) const
+{
+  return contains(id) ? datesAdded[id] : 0;
+}
+
+const juce::String& TrackStore::getDateAddedText(TrackId id) const
+{
+  static const juce::String none;
+  return contains(id) ? *dateAddedTexts[id] : none;
+}
+
+double TrackStore::getSampleRate(TrackId id) const
+{
+  return contains(id) ? sampleRates[id] : 0.0;
+}
+
+int TrackStore::getNumChannels(TrackId id) const
+{
+  return contains(id) ? channelCounts[id] : 0;
+}
+
+juce::String TrackStore::formatDuration(double durationInSeconds)
+{
+  int min = static_cast<int>(durationInSeconds) / 60;
+  int sec = static_cast<int>(durationInSeconds) % 60;
+  return juce::String::formatted("%02d:%02d", min, sec);
+}
+
+const std::vector<TrackStore::TrackId>& TrackStore::getTrackIds() const
+{
+  // Removed tracks are all dropped in one pass, keeping the rest in the order they were added
+  if (trackIdsHaveRemovals)
+  {
+    trackIds.erase(std::remove_if(trackIds.begin(), trackIds.end(), [this](TrackId id) { return !contains(id); }), trackIds.end());
+    trackIdsHaveRemovals = false;
+  }
+
+  return trackIds;
+}
+
+int TrackStore::getNumTracks() const
+{
+  return numTracks;
+}
+
+size_t TrackStore::getMemoryUsage() const
+{
+  size_t bytes = (fileURLs.capacity() + fileTitles.capacity() + fileDurationTexts.capacity() + dateAddedTexts.capacity()) * sizeof(const juce::String*)
+               + datesAdded.capacity() * sizeof(juce::int64)
+               + (fileDurations.capacity() + sampleRates.capacity()) * sizeof(float)
+               + channelCounts.capacity() * sizeof(juce::uint8)
+               + trackIds.capacity() * sizeof(TrackId);
+
+  // Each string is a hash table node, plus its characters (after a reference count and size)
+  bytes += strings.bucket_count() * sizeof(void*);
+  for (const auto& entry : strings) bytes += sizeof(entry) + (2 * sizeof(void*)) + (2 * sizeof(size_t)) + entry.first.getNumBytesAsUTF8() + 1;
+
+  return bytes;
+}
+
+const juce::String* TrackStore::intern(const juce::String& text)
+{
+  auto it = strings.try_emplace(text, 0).first;
+  ++(it->second);
+  return &(it->first);
+}
+
+void TrackStore::release(const juce::String* text)
+{
+  auto it = strings.find(*text);
+  if (it == strings.end()) return;
+  if (--(it->second) == 0) strings.erase(it);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <JuceHeader.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Every track in the library, stored column by column (one vector per field) instead of as copies of whole vectors.
+1. each track has an ID that never changes while it is in the store (its slot in the columns), so rows and searches can refer to it however the table is filtered
+2. removing a track only empties its slot (a tombstone), so no other track's ID or data moves, and it takes the same time however big the library is
+3. URLs, titles, durations' "mm:ss" and when each track was added (to the minute) are interned juce::Strings, so a table can paint them without building a string (and a track imported twice shares them)
+4. durations and sample rates are kept as floats, numbers of channels as bytes, and when each track was added as milliseconds since 1970
+   (given back when a saved library is loaded again, so a track keeps the date it was first added)
+5. getTrackIds() is every track still in the store, in the order they were added (a view of the library as an index array),
+   which drops removed tracks the first time it is asked for after any were removed (so removing many tracks at once costs one pass, not one per track)
+*/
+class TrackStore
+{
+public:
+  using TrackId = juce::uint32;
+  static constexpr TrackId noTrack = 0xffff'ffff;
+
+  TrackStore();
+  ~TrackStore();
+
+  // 'dateAdded' is in milliseconds since 1970, 0 for now
+  TrackId add(const juce::String& fileURL, const juce::String& fileTitle, double fileDuration, double sampleRate = 0.0, int numChannels = 0, juce::int64 dateAdded = 0);
+  void remove(TrackId id);
+  void clear();
+
+  bool contains(TrackId id) const;
+  const juce::String& getURL(TrackId id) const;
+  const juce::String& getTitle(TrackId id) const;
+  double getDuration(TrackId id) const;
+  const juce::String& getDurationText(TrackId id) const; // Formatted once, when the track is added
+  juce::int64 getDateAdded(TrackId id) const; // Milliseconds since 1970
+  const juce::String& getDateAddedText(TrackId id) const; // To the minute
+  double getSampleRate(TrackId id) const; // 0 if unknown
+  int getNumChannels(TrackId id) const;   // 0 if unknown
+
+  // "mm:ss"
+  static juce::String formatDuration(double durationInSeconds);
+
+  const std::vector<TrackId>& getTrackIds() const;
+  int getNumTracks() const;
+
+  // Rough size of the columns and strings in bytes (including what removed tracks still take up)
+  size_t getMemoryUsage() const;
+
+private:
+  struct StringHash
+  {
+    size_t operator()(const juce::String& text) const { return text.hash(); }
+  };
+
+  // Shared copy of 'text', released when no track uses it any more
+  const juce::String* intern(const juce::String& text);
+  void release(const juce::String* text);
+
+  // Every string in use, with how many times it is used (nodes never move, so tracks can point at their keys)
+  std::unordered_map<juce::String, juce::uint32, StringHash> strings;
+
+  // Columns, one slot per ID (a removed track's slot has no strings)
+  std::vector<const juce::String*> fileURLs;
+  std::vector<const juce::String*> fileTitles;
+  std::vector<const juce::String*> fileDurationTexts;
+  std::vector<const juce::String*> dateAddedTexts;
+  std::vector<juce::int64> datesAdded;
+  std::vector<float> fileDurations;
+  std::vector<float> sampleRates;
+  std::vector<juce::uint8> channelCounts;
+
+  // Tracks are usually added many at a time (and a saved library's tracks mostly in the same minutes), so the date is only formatted again once the minute changes
+  juce::int64 lastAddedMinute = -1;
+  juce::String lastDateAddedText;
+
+  // Can still hold removed IDs until getTrackIds() next compacts it
+  mutable std::vector<TrackId> trackIds;
+  mutable bool trackIdsHaveRemovals = false;
+  int numTracks = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackStore)
+};
@@ -1,15 +1,13 @@
 #include <JuceHeader.h>
 #include "WaveformDisplay.h"
 
-WaveformDisplay::WaveformDisplay(juce::AudioFormatManager& formatManagerToUse,
-                                 juce::AudioThumbnailCache& cacheToUse,
+WaveformDisplay::WaveformDisplay(PeakFileStore& peakFileStoreToUse,
                                  juce::Colour _incomingColour)
-  : audioThumb(1'000, formatManagerToUse, cacheToUse), // Refers to '1000' points in waveform
-    fileLoaded(false),
+  : fileLoaded(false),
     position(0),
-    incomingColour(_incomingColour)
+    incomingColour(_incomingColour),
+    peakFileStore(peakFileStoreToUse)
 {
-  audioThumb.addChangeListener(this);
 }
 
 WaveformDisplay::~WaveformDisplay()
@@ -22,17 +20,24 @@ void WaveformDisplay::paint(juce::Graphics& g)
   juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
   g.fillAll(myBlack);
   
-  if (fileLoaded)
+  if (fileLoaded && peaks != nullptr)
   {
-    // Static waveform
-    g.setColour(incomingColour.darker());
-    audioThumb.drawChannel(g, getLocalBounds(), 0, audioThumb.getTotalLength(), 0, 1.0f);
+    // Static waveform (drawn once, then copied from the cached image, unless moved to a screen with a different pixel density)
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (!cachedWaveformValid || cachedWaveform.getWidth() != juce::jmax(1, juce::roundToInt(getWidth() * scale))) renderCachedWaveform(scale);
+    g.drawImage(cachedWaveform, getLocalBounds().toFloat());
     
     // Moving vertical line
     g.setColour(juce::Colours::white);
-    float lineThickness = 2.0f;
     g.fillRect((position * getWidth()) - (lineThickness / 2.0f), 0.0f, lineThickness, static_cast<float>(getHeight()));
   }
+  else if (fileLoaded)
+  {
+    // Ensure same as WaveformDisplayZoomedIn::paint()'s 'else if{}' section
+    g.setColour(juce::Colours::white.withAlpha(0.5f));
+    g.setFont(18.0f);
+    g.drawText("Reading waveform...", getLocalBounds(), juce::Justification::centred, true);
+  }
   else
   {
     // Ensure same as WaveformDisplayZoomedIn::paint()'s 'else{}' section
@@ -53,24 +58,67 @@ void WaveformDisplay::paint(juce::Graphics& g)
 
 void WaveformDisplay::resized()
 {
+  cachedWaveformValid = false;
 }
 
-void WaveformDisplay::changeListenerCallback(juce::ChangeBroadcaster* source)
+void WaveformDisplay::peaksChanged()
 {
+  cachedWaveformValid = false;
   repaint();
 }
 
 void WaveformDisplay::loadURL(juce::URL audioURL)
 {
-  audioThumb.clear();
-  fileLoaded = audioThumb.setSource(new juce::URLInputSource(audioURL));
+  peaks = nullptr;
+  fileLoaded = audioURL.isLocalFile() && audioURL.getLocalFile().existsAsFile();
+  int requestNumber = ++latestRequestNumber;
+  peaksChanged();
+
+  if (!fileLoaded) return;
+
+  juce::Component::SafePointer<WaveformDisplay> safeThis(this);
+  peakFileStore.requestPeaks(audioURL.getLocalFile(), [safeThis, requestNumber](std::shared_ptr<const PeakFile> newPeaks)
+    {
+      if (safeThis == nullptr || requestNumber != safeThis->latestRequestNumber) return;
+
+      safeThis->peaks = newPeaks;
+      safeThis->fileLoaded = newPeaks != nullptr;
+      safeThis->peaksChanged();
+    });
 }
 
 void WaveformDisplay::setPositionRelative(double pos)
 {
   if (pos != position)
   {
+    // Only the strips under the old and new vertical line need repainting
+    repaint(getPlayheadBounds(position));
     position = pos;
-    repaint();
+    repaint(getPlayheadBounds(position));
   }
 }
+
+void WaveformDisplay::renderCachedWaveform(float scale)
+{
+  // Rendered at the display's pixel density, so it stays sharp on high-DPI screens
+  int imageWidth = juce::jmax(1, juce::roundToInt(getWidth() * scale));
+  int imageHeight = juce::jmax(1, juce::roundToInt(getHeight() * scale));
+  cachedWaveform = juce::Image(juce::Image::RGB, imageWidth, imageHeight, false);
+
+  juce::Graphics imageGraphics(cachedWaveform);
+  imageGraphics.addTransform(juce::AffineTransform::scale(imageWidth / static_cast<float>(juce::jmax(1, getWidth())), imageHeight / static_cast<float>(juce::jmax(1, getHeight()))));
+
+  juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
+  imageGraphics.fillAll(myBlack);
+
+  peaks->drawChannel(imageGraphics, getLocalBounds(), 0, peaks->getLengthInSeconds(), 0, incomingColour.darker(), incomingColour);
+
+  cachedWaveformValid = true;
+}
+
+juce::Rectangle<int> WaveformDisplay::getPlayheadBounds(double pos)
+{
+  // A pixel of padding either side covers anti-aliasing
+  int x = static_cast<int>(std::floor((pos * getWidth()) - (lineThickness / 2.0f))) - 1;
+  return juce::Rectangle<int>(x, 0, static_cast<int>(std::ceil(lineThickness)) + 2, getHeight());
+}
@@ -1,30 +1,44 @@
 #pragma once
 #include <JuceHeader.h>
+#include "PeakFileStore.h"
 
-class WaveformDisplay : public juce::Component,
-                        public juce::ChangeListener
+class WaveformDisplay : public juce::Component
 {
 public:
-  WaveformDisplay(juce::AudioFormatManager& formatManagerToUse,
-                  juce::AudioThumbnailCache& cacheToUse,
+  WaveformDisplay(PeakFileStore& peakFileStoreToUse,
                   juce::Colour _incomingColour);
   ~WaveformDisplay() override;
 
   void paint(juce::Graphics&) override;
   void resized() override;
 
-  void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+  // Shows the track's peak file straight away if it has one, otherwise once it has been built in the background
   void loadURL(juce::URL audioURL);
 
   // Set vertical line's position relative to width/entire waveform
   void setPositionRelative(double pos);
 
-  juce::AudioThumbnail audioThumb;
+  std::shared_ptr<const PeakFile> peaks; // nullptr until the peak file is ready
   bool fileLoaded;
   double position;
 
+protected:
+  // Called whenever 'peaks' or 'fileLoaded' changes
+  virtual void peaksChanged();
+
 private:
   juce::Colour incomingColour;
+  PeakFileStore& peakFileStore;
+  int latestRequestNumber = 0; // Peaks of an older request are ignored if they arrive late
+
+  // Background and waveform, only redrawn after a resize or when 'peaks' changes
+  juce::Image cachedWaveform;
+  bool cachedWaveformValid = false;
+  void renderCachedWaveform(float scale);
+
+  // Area covered by the vertical line at 'pos' (so only that strip needs repainting when it moves)
+  juce::Rectangle<int> getPlayheadBounds(double pos);
+  float lineThickness = 2.0f;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDisplay)
 };
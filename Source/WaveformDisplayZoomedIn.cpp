@@ -1,9 +1,8 @@
 #include "WaveformDisplayZoomedIn.h"
 
-WaveformDisplayZoomedIn::WaveformDisplayZoomedIn(juce::AudioFormatManager& formatManagerToUse,
-                                                 juce::AudioThumbnailCache& cacheToUse,
+WaveformDisplayZoomedIn::WaveformDisplayZoomedIn(PeakFileStore& peakFileStoreToUse,
                                                  juce::Colour _incomingColour)
-  : WaveformDisplay(formatManagerToUse, cacheToUse, _incomingColour),
+  : WaveformDisplay(peakFileStoreToUse, _incomingColour),
     incomingColour(_incomingColour)
 {
 }
@@ -18,33 +17,57 @@ void WaveformDisplayZoomedIn::paint(juce::Graphics& g)
   juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
   g.fillAll(myBlack);
 
-  if (fileLoaded)
+  if (fileLoaded && peaks != nullptr)
   {
-    // Set zoom amount
-    /*
-    0.01 = very zoomed in
-    0.50 = same as normal WaveformDisplay
-    1.00 = original
-    */
-    double zoom = 0.05;
-    
-    // Set range
-    double rangeStart = position - zoom;
-    double rangeEnd = position + zoom;
-    
-    // Get range in terms of audioThumb
-    double visibleStart = rangeStart * audioThumb.getTotalLength();
-    double visibleEnd = rangeEnd * audioThumb.getTotalLength();
-    
-    // Moving waveform (via changing start-and-end points)
-    g.setColour(incomingColour.brighter());
-    audioThumb.drawChannel(g, getLocalBounds(), visibleStart, visibleEnd, 0, 1.0f);
+    // Tiles are only valid for the pixel density they were drawn at
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (scale != tileScale)
+    {
+      clearTiles();
+      tileScale = scale;
+    }
+
+    // Visible range (playhead stays in the middle)
+    double totalLength = peaks->getLengthInSeconds();
+    double secondsPerPixel = visibleSeconds / juce::jmax(1, getWidth());
+    double tileSeconds = secondsPerPixel * tileWidth;
+    double visibleStart = (position * totalLength) - (visibleSeconds / 2);
+
+    juce::int64 firstTile = static_cast<juce::int64>(std::floor(visibleStart / tileSeconds));
+    juce::int64 lastTile = static_cast<juce::int64>(std::floor((visibleStart + visibleSeconds) / tileSeconds));
+
+    // Moving waveform (via moving the tiles, drawing any that are new)
+    for (juce::int64 tileIndex = firstTile; tileIndex <= lastTile; ++tileIndex)
+    {
+      double tileStart = tileIndex * tileSeconds;
+      if (tileStart + tileSeconds <= 0 || tileStart >= totalLength) continue;
+
+      auto tile = tiles.find(tileIndex);
+      if (tile == tiles.end()) tile = tiles.emplace(tileIndex, renderTile(tileIndex, tileSeconds, scale)).first;
+
+      float x = static_cast<float>((tileStart - visibleStart) / secondsPerPixel);
+      g.drawImage(tile->second, juce::Rectangle<float>(x, 0.0f, static_cast<float>(tileWidth), static_cast<float>(getHeight())));
+    }
+
+    // Throw away tiles that have scrolled well out of view (a couple either side are kept for small seeks)
+    for (auto tile = tiles.begin(); tile != tiles.end();)
+    {
+      if (tile->first < firstTile - 2 || tile->first > lastTile + 2) tile = tiles.erase(tile);
+      else ++tile;
+    }
     
     // Static vertical line (using 'drawRect' to get sharper line)
     g.setColour(juce::Colours::white);
     double lineThickness = 1;
     g.drawRect((getWidth() / static_cast<double>(2)) - (lineThickness / 2), 0, lineThickness, getHeight());
   }
+  else if (fileLoaded)
+  {
+    // Ensure same as WaveformDisplay::paint()'s 'else if{}' section
+    g.setColour(juce::Colours::white.withAlpha(0.5f));
+    g.setFont(18.0f);
+    g.drawText("Reading waveform...", getLocalBounds(), juce::Justification::centred, true);
+  }
   else
   {
     // Ensure same as WaveformDisplay::paint()'s 'else{}' section
@@ -68,6 +91,29 @@ void WaveformDisplayZoomedIn::paint(juce::Graphics& g)
   g.drawRect(getLocalBounds(), 2);
 }
 
+void WaveformDisplayZoomedIn::resized()
+{
+  WaveformDisplay::resized();
+  clearTiles();
+}
+
+void WaveformDisplayZoomedIn::peaksChanged()
+{
+  clearTiles();
+  WaveformDisplay::peaksChanged();
+}
+
+void WaveformDisplayZoomedIn::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+  // Scrolling up zooms in
+  setVisibleSeconds(visibleSeconds * std::pow(2.0, -wheel.deltaY * 2.0));
+}
+
+void WaveformDisplayZoomedIn::mouseDoubleClick(const juce::MouseEvent& event)
+{
+  setVisibleSeconds(defaultVisibleSeconds);
+}
+
 void WaveformDisplayZoomedIn::setPositionRelativeOfWaveform(double pos)
 {
   if (pos != position)
@@ -76,3 +122,47 @@ void WaveformDisplayZoomedIn::setPositionRelativeOfWaveform(double pos)
     repaint();
   }
 }
+
+void WaveformDisplayZoomedIn::setVisibleSeconds(double seconds)
+{
+  seconds = juce::jlimit(minVisibleSeconds, maxVisibleSeconds, seconds);
+  if (seconds == visibleSeconds) return;
+
+  visibleSeconds = seconds;
+  clearTiles();
+  repaint();
+}
+
+double WaveformDisplayZoomedIn::getVisibleSeconds() const
+{
+  return visibleSeconds;
+}
+
+juce::Image WaveformDisplayZoomedIn::renderTile(juce::int64 tileIndex, double tileSeconds, float scale)
+{
+  int imageWidth = juce::jmax(1, juce::roundToInt(tileWidth * scale));
+  int imageHeight = juce::jmax(1, juce::roundToInt(getHeight() * scale));
+  juce::Image tile(juce::Image::RGB, imageWidth, imageHeight, false);
+
+  juce::Graphics tileGraphics(tile);
+  tileGraphics.addTransform(juce::AffineTransform::scale(scale));
+
+  juce::Colour myBlack = juce::Colour::fromRGB(20, 20, 20);
+  tileGraphics.fillAll(myBlack);
+
+  // Only the part of the tile that lies within the track
+  double tileStart = tileIndex * tileSeconds;
+  double drawStart = juce::jmax(tileStart, 0.0);
+  double drawEnd = juce::jmin(tileStart + tileSeconds, peaks->getLengthInSeconds());
+  int xStart = juce::roundToInt(((drawStart - tileStart) / tileSeconds) * tileWidth);
+  int xEnd = juce::roundToInt(((drawEnd - tileStart) / tileSeconds) * tileWidth);
+
+  if (xEnd > xStart) peaks->drawChannel(tileGraphics, juce::Rectangle<int>(xStart, 0, xEnd - xStart, getHeight()), drawStart, drawEnd, 0, incomingColour.brighter(), incomingColour.brighter().brighter());
+
+  return tile;
+}
+
+void WaveformDisplayZoomedIn::clearTiles()
+{
+  tiles.clear();
+}
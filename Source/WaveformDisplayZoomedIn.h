@@ -1,19 +1,50 @@
 #pragma once
+#include <map>
 #include "WaveformDisplay.h"
 
+/*
+Scrolling close-up of the waveform, with the playhead fixed in the middle.
+1. the waveform is drawn into fixed-width image tiles, which are kept and reused as the playhead moves
+   (PeakFile picks the level of detail to match the zoom)
+2. only tiles that scroll into view are drawn (tiles well out of view are thrown away)
+3. zoom with the mouse wheel, double-click to reset it
+*/
 class WaveformDisplayZoomedIn : public WaveformDisplay
 {
 public:
-  WaveformDisplayZoomedIn(juce::AudioFormatManager& formatManagerToUse,
-                          juce::AudioThumbnailCache& cacheToUse,
+  WaveformDisplayZoomedIn(PeakFileStore& peakFileStoreToUse,
                           juce::Colour _incomingColour);
   ~WaveformDisplayZoomedIn() override;
 
   void paint(juce::Graphics&) override;
+  void resized() override;
+
+  void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+  void mouseDoubleClick(const juce::MouseEvent& event) override;
 
   // Set waveform's start-and-end point's position relative to entire waveform
   void setPositionRelativeOfWaveform(double pos);
 
+  // Seconds of audio shown across the whole width
+  void setVisibleSeconds(double seconds);
+  double getVisibleSeconds() const;
+
+protected:
+  void peaksChanged() override;
+
 private:
   juce::Colour incomingColour;
+
+  // Renders one tile, where tile 'tileIndex' starts at (tileIndex * tileSeconds) into the track
+  juce::Image renderTile(juce::int64 tileIndex, double tileSeconds, float scale);
+  void clearTiles();
+
+  double defaultVisibleSeconds = 20.0;
+  double visibleSeconds = defaultVisibleSeconds;
+  double minVisibleSeconds = 2.0;
+  double maxVisibleSeconds = 120.0;
+
+  static constexpr int tileWidth = 256;
+  std::map<juce::int64, juce::Image> tiles;
+  float tileScale = 0.0f; // Pixel density the tiles were drawn at
 };